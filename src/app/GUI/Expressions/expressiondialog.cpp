@@ -22,11 +22,13 @@
 #include <QStatusBar>
 #include <QApplication>
 #include <QButtonGroup>
+#include <QTimer>
 
 #include <Qsci/qscilexerjavascript.h>
 #include <Qsci/qsciapis.h>
 
 #include "Expressions/expression.h"
+#include "Expressions/expressiongraph.h"
 #include "Boxes/boundingbox.h"
 #include "Private/document.h"
 #include "expressioneditor.h"
@@ -372,6 +374,24 @@ ExpressionDialog::ExpressionDialog(QrealAnimator* const target,
     mScriptError->setObjectName("errorLabel");
     mainLayout->addWidget(mScriptError);
 
+    const auto statsLayout = new QHBoxLayout;
+    mStatsLabel = new QLabel(this);
+    const auto resetStatsButton = new QPushButton("Reset Stats", this);
+    connect(resetStatsButton, &QPushButton::released, this, [this]() {
+        const auto expression = mTarget->getExpression();
+        if(expression) expression->resetEvaluationStats();
+        updateStats();
+    });
+    statsLayout->addWidget(mStatsLabel, 1);
+    statsLayout->addWidget(resetStatsButton);
+    mainLayout->addLayout(statsLayout);
+
+    const auto statsTimer = new QTimer(this);
+    connect(statsTimer, &QTimer::timeout,
+            this, &ExpressionDialog::updateStats);
+    statsTimer->start(500);
+    updateStats();
+
     const auto buttonsLayout = new QHBoxLayout;
     const auto applyButton = new QPushButton("Apply", this);
     const auto okButton = new QPushButton("Ok", this);
@@ -562,6 +582,24 @@ void ExpressionDialog::updateScriptBindings() {
                           BFC_1 " ) :");
 }
 
+void ExpressionDialog::updateStats() {
+    const auto expression = mTarget->getExpression();
+    QString stats;
+    if(expression) {
+        const int count = expression->evaluationCount();
+        const qint64 nsecs = expression->evaluationNsecs();
+        const qreal avgUs = count ? 0.001*nsecs/count : 0;
+        stats = QString("Evaluated %1 times, %2 us on average").
+                arg(count).arg(avgUs, 0, 'f', 2);
+    } else stats = "Not applied";
+    const int cycles = ExpressionGraph::sCycleCount();
+    if(cycles > 0) {
+        stats += QString(", %1 expressions are part of "
+                         "a dependency cycle").arg(cycles);
+    }
+    mStatsLabel->setText(stats);
+}
+
 bool ExpressionDialog::apply(const bool action) {
     mBindingsButton->setIcon(QIcon());
     mDefinitionsButon->setIcon(QIcon());
@@ -574,19 +612,17 @@ bool ExpressionDialog::apply(const bool action) {
     PropertyBindingMap bindings;
     if(!getBindings(bindings)) return false;
 
-    auto engine = std::make_unique<QJSEngine>();
     try {
-        Expression::sAddDefinitionsTo(definitionsStr, *engine);
+        Expression::sValidateDefinitions(definitionsStr);
     } catch(const std::exception& e) {
         mDefinitionsError->setText(e.what());
         mDefinitionsButon->setIcon(mRedDotIcon);
         return false;
     }
 
-    QJSValue eEvaluate;
     try {
-        Expression::sAddScriptTo(scriptStr, bindings, *engine, eEvaluate,
-                                 Expression::sQrealAnimatorTester);
+        Expression::sValidateScript(definitionsStr, scriptStr, bindings,
+                                    Expression::sQrealAnimatorTester);
     } catch(const std::exception& e) {
         mScriptError->setText(e.what());
         mBindingsButton->setIcon(mRedDotIcon);
@@ -595,9 +631,7 @@ bool ExpressionDialog::apply(const bool action) {
 
     try {
         auto expr = Expression::sCreate(definitionsStr,
-                                        scriptStr, std::move(bindings),
-                                        std::move(engine),
-                                        std::move(eEvaluate));
+                                        scriptStr, std::move(bindings));
         if(expr && !expr->isValid()) expr = nullptr;
         if(action) {
             mTarget->setExpressionAction(expr);
@@ -609,5 +643,6 @@ bool ExpressionDialog::apply(const bool action) {
     }
 
     Document::sInstance->actionFinished();
+    updateStats();
     return true;
 }
@@ -43,6 +43,8 @@ private:
     void updateScriptDefinitions();
     void updateAllScript();
     void setCurrentTabId(const int id);
+    //! @brief Shows the evaluation stats of the applied expression
+    void updateStats();
 
     bool apply(const bool action);
 
@@ -71,6 +73,8 @@ private:
     QsciAPIs* mScriptApi;
     QLabel* mScriptError;
 
+    QLabel* mStatsLabel;
+
     ConnContext mAutoApplyConn;
 };
 
@@ -82,6 +82,20 @@ PerformanceSettingsWidget::PerformanceSettingsWidget(QWidget *parent) :
     mPathGpuAccCheck = new QCheckBox("Path GPU acceleration", this);
     addWidget(mPathGpuAccCheck);
 
+    addSeparator();
+
+    const auto previewLayout = new QHBoxLayout;
+    const auto previewLabel = new QLabel("Progressive preview:");
+    mPreviewResolutionCombo = new QComboBox(this);
+    mPreviewResolutionCombo->addItem("Disabled", 1);
+    mPreviewResolutionCombo->addItem("1/4 resolution", 4);
+    mPreviewResolutionCombo->addItem("1/8 resolution", 8);
+    mPreviewResolutionCombo->setToolTip(
+                "Show a low resolution frame before the full resolution one");
+    previewLayout->addWidget(previewLabel);
+    previewLayout->addWidget(mPreviewResolutionCombo);
+    addLayout(previewLayout);
+
 //    const auto line2 = new QFrame();
 //    line2->setFrameShape(QFrame::HLine);
 //    line2->setFrameShadow(QFrame::Sunken);
@@ -117,6 +131,7 @@ void PerformanceSettingsWidget::applySettings() {
     mSett.fAccPreference = static_cast<AccPreference>(
                 mAccPreferenceSlider->value());
     mSett.fPathGpuAcc = mPathGpuAccCheck->isChecked();
+    mSett.fPreviewResolutionDiv = mPreviewResolutionCombo->currentData().toInt();
 //        sett.fHddCache = mHddCacheCheck->isChecked();
 //        sett.fRamMBCap = mHddCacheMBCapCheck->isChecked() ?
 //                    mHddCacheMBCapSpin->value() : 0;
@@ -139,6 +154,9 @@ void PerformanceSettingsWidget::updateSettings() {
     mAccPreferenceSlider->setValue(static_cast<int>(mSett.fAccPreference));
     updateAccPreferenceDesc();
     mPathGpuAccCheck->setChecked(mSett.fPathGpuAcc);
+    const int previewId = mPreviewResolutionCombo->findData(
+                qMax(1, mSett.fPreviewResolutionDiv));
+    mPreviewResolutionCombo->setCurrentIndex(qMax(0, previewId));
 
 //    mHddCacheCheck->setChecked(sett.fHddCache);
 
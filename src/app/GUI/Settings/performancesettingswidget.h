@@ -6,6 +6,7 @@
 #include <QLabel>
 #include <QCheckBox>
 #include <QSlider>
+#include <QComboBox>
 
 class PerformanceSettingsWidget : public SettingsWidget {
 public:
@@ -32,6 +33,8 @@ private:
 
     QCheckBox* mPathGpuAccCheck = nullptr;
 
+    QComboBox* mPreviewResolutionCombo = nullptr;
+
     QCheckBox* mHddCacheCheck = nullptr;
 
     QCheckBox* mHddCacheMBCapCheck = nullptr;
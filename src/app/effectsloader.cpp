@@ -21,11 +21,13 @@
 #include <QFileSystemModel>
 #include <iostream>
 #include "ShaderEffects/shadereffectcreator.h"
+#include "ShaderEffects/shadereffectcpucheck.h"
 #include "Private/esettings.h"
 
 EffectsLoader::EffectsLoader() {}
 
 EffectsLoader::~EffectsLoader() {
+    if(!mGpuInitialized) return;
     makeCurrent();
     glDeleteBuffers(1, &GL_PLAIN_SQUARE_VBO);
     glDeleteVertexArrays(1, &mPlainSquareVAO);
@@ -81,6 +83,17 @@ void EffectsLoader::initializeGpu() {
 
     doneCurrent();
     std::cout << "Done OffscreenQGL33c current" << std::endl;
+    mGpuInitialized = true;
+}
+
+QGL33* EffectsLoader::makeCurrentIfAvailable() {
+    if(!mGpuInitialized) return nullptr;
+    makeCurrent();
+    return this;
+}
+
+void EffectsLoader::doneCurrentIfAvailable() {
+    if(mGpuInitialized) doneCurrent();
 }
 
 #include "Boxes/ecustombox.h"
@@ -220,18 +233,18 @@ void EffectsLoader::iniCustomRasterEffects() {
 void EffectsLoader::reloadProgram(ShaderEffectCreator* const loaded,
                                   const QString &fragPath) {
     try {
-        makeCurrent();
-        loaded->reloadProgram(this, fragPath);
+        const auto gl = makeCurrentIfAvailable();
+        loaded->reloadProgram(gl, fragPath);
         emit programChanged(&*loaded->fProgram);
-        doneCurrent();
+        doneCurrentIfAvailable();
     } catch(const std::exception& e) {
-        doneCurrent();
+        doneCurrentIfAvailable();
         gPrintExceptionCritical(e);
     }
 }
 
 void EffectsLoader::iniShaderEffects() {
-    makeCurrent();
+    makeCurrentIfAvailable();
     QDir(eSettings::sSettingsDir()).mkdir("ShaderEffects");
     const QString dirPath = eSettings::sSettingsDir() + "/ShaderEffects";
     QDirIterator dirIt(dirPath, QDirIterator::NoIteratorFlags);
@@ -281,16 +294,16 @@ void EffectsLoader::iniShaderEffects() {
             }
         });
     });
-    doneCurrent();
+    doneCurrentIfAvailable();
 }
 
 void EffectsLoader::iniSingleRasterEffectProgram(const QString& grePath) {
     try {
-        makeCurrent();
+        makeCurrentIfAvailable();
         iniShaderEffectProgramExec(grePath);
-        doneCurrent();
+        doneCurrentIfAvailable();
     } catch(const std::exception& e) {
-        doneCurrent();
+        doneCurrentIfAvailable();
         gPrintExceptionCritical(e);
     }
 }
@@ -302,8 +315,12 @@ void EffectsLoader::iniShaderEffectProgramExec(const QString& grePath) {
             fileInfo.completeBaseName() + ".frag";
     if(!QFile(fragPath).exists()) return;
     try {
-        const auto loaded = ShaderEffectCreator::sLoadFromFile(this, grePath).get();
+        QGL33* const gl = mGpuInitialized ? this : nullptr;
+        const auto loaded = ShaderEffectCreator::sLoadFromFile(gl, grePath).get();
         mLoadedGREPaths << grePath;
+#ifdef QT_DEBUG
+        ShaderEffectCpuCheck::sCheck(*loaded);
+#endif
 
         const auto newFileWatcher = QSharedPointer<QFileSystemWatcher>(
                     new QFileSystemWatcher);
@@ -43,6 +43,11 @@ private:
     void iniCustomRasterEffect(const QString &soPath);
     void iniIfCustomRasterEffect(const QString &path);
 
+    //! @brief Makes the context current, returns null without a GPU
+    QGL33* makeCurrentIfAvailable();
+    void doneCurrentIfAvailable();
+
+    bool mGpuInitialized = false;
     QStringList mLoadedGREPaths;
     GLuint mPlainSquareVAO;
     GLuint mTexturedSquareVAO;
@@ -29,6 +29,7 @@
 #include "videoencoder.h"
 #include "iconloader.h"
 #include "GUI/envesplash.h"
+#include "Paint/colorconversions.h"
 #ifdef Q_OS_WIN
     #include "windowsincludes.h"
 #endif // Q_OS_WIN
@@ -57,6 +58,7 @@ void printHardware() {
     case GpuVendor::unrecognized: std::cout << "Unrecognized"; break;
     }
     std::cout << std::endl;
+    std::cout << "   Paint pixels: " << colorconversions_instruction_set() << std::endl;
     std::cout << std::endl;
 }
 
@@ -111,6 +113,12 @@ int main(int argc, char *argv[]) {
         gPrintExceptionCritical(e);
     }
     printHardware();
+#ifdef QT_DEBUG
+    if(!colorconversions_compare_with_scalar()) {
+        std::cout << "Paint pixel conversions differ "
+                     "from the scalar code" << std::endl;
+    }
+#endif
 
     eSettings settings(HardwareInfo::sCpuThreads(),
                        HardwareInfo::sRamKB(),
@@ -211,7 +219,8 @@ int main(int argc, char *argv[]) {
         taskScheduler.initializeGpu();
     } catch(const std::exception& e) {
         GPU_NOT_COMPATIBLE;
-        gPrintExceptionFatal(e);
+        gPrintExceptionCritical(e);
+        std::cout << "Falling back to CPU rendering" << std::endl;
     }
 
     splash->showMessage("Initialize custom path effects...");
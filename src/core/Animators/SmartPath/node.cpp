@@ -70,23 +70,21 @@ Node Node::sInterpolateNormal(const Node &node1, const Node &node2,
                 w1*node1.c2() + weight2*node2.c2());
     result.setC0Enabled(node1.getC0Enabled() || node2.getC0Enabled());
     result.setC2Enabled(node1.getC2Enabled() || node2.getC2Enabled());
-    const CtrlsMode node1Ctrls = node1.getCtrlsMode();
-    const CtrlsMode node2Ctrls = node2.getCtrlsMode();
-    if(node1Ctrls == node2Ctrls) {
-        result.mCtrlsMode = node1Ctrls;
-    } else if(node1Ctrls == CtrlsMode::corner ||
-              node2Ctrls == CtrlsMode::corner) {
-        result.mCtrlsMode = CtrlsMode::corner;
-    } else if(node1Ctrls == CtrlsMode::smooth ||
-              node2Ctrls == CtrlsMode::smooth) {
-        result.mCtrlsMode = CtrlsMode::smooth;
-    } else {
-        result.mCtrlsMode = CtrlsMode::symmetric;
-    }
-    result.setCtrlsMode(result.mCtrlsMode);
+    result.setCtrlsMode(sInterpolatedCtrlsMode(node1.getCtrlsMode(),
+                                               node2.getCtrlsMode()));
     return result;
 }
 
+CtrlsMode Node::sInterpolatedCtrlsMode(const CtrlsMode mode1,
+                                       const CtrlsMode mode2) {
+    if(mode1 == mode2) return mode1;
+    if(mode1 == CtrlsMode::corner || mode2 == CtrlsMode::corner)
+        return CtrlsMode::corner;
+    if(mode1 == CtrlsMode::smooth || mode2 == CtrlsMode::smooth)
+        return CtrlsMode::smooth;
+    return CtrlsMode::symmetric;
+}
+
 Node Node::sInterpolateDissolved(const Node &node1, const Node &node2,
                         const qreal weight2) {
     if(!node1.isDissolved() || !node2.isDissolved())
@@ -80,6 +80,10 @@ struct CORE_EXPORT Node {
     static Node sInterpolateDissolved(const Node &node1, const Node &node2,
                                       const qreal weight2);
 
+    //! @brief Ctrls mode of a node interpolated between the two modes
+    static CtrlsMode sInterpolatedCtrlsMode(const CtrlsMode mode1,
+                                            const CtrlsMode mode2);
+
     QPointF c0() const { return mC0Enabled ? mC0 : mP1; }
     QPointF p1() const { return mP1; }
     QPointF c2() const { return mC2Enabled ? mC2 : mP1; }
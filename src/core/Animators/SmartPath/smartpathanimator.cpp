@@ -33,6 +33,11 @@ SmartPathAnimator::SmartPathAnimator() :
     });
 
     setPointsHandler(ptsHandler);
+
+    connect(this, &Animator::anim_addedKey,
+            this, [this]() { mInterpolators.clear(); });
+    connect(this, &Animator::anim_removedKey,
+            this, [this]() { mInterpolators.clear(); });
 }
 
 SmartPathAnimator::SmartPathAnimator(const SkPath &path) :
@@ -152,13 +157,8 @@ SkPath SmartPathAnimator::getPathAtRelFrame(const qreal frame) {
            anim_getKeyAtIndex<SmartPathKey>(pn.first + 1);
     if(keyAtRelFrame) return keyAtRelFrame->getValue().getPathAt();
     if(prevKey && nextKey) {
-        SkPath result;
         const qreal nWeight = graph_prevKeyWeight(prevKey, nextKey, frame);
-        SmartPath sPath;
-        const auto& prevPath = prevKey->getValue();
-        const auto& nextPath = nextKey->getValue();
-        gInterpolate(prevPath, nextPath, nWeight, sPath);
-        return sPath.getPathAt();
+        return getInterpolator(prevKey, nextKey).interpolate(nWeight);
     } else if(!prevKey && nextKey) {
         return nextKey->getValue().getPathAt();
     } else if(prevKey && !nextKey) {
@@ -167,6 +167,24 @@ SkPath SmartPathAnimator::getPathAtRelFrame(const qreal frame) {
     return baseValue().getPathAt();
 }
 
+void SmartPathAnimator::prp_afterChangedAbsRange(const FrameRange &range,
+                                                 const bool clip) {
+    mInterpolators.clear();
+    SmartPathAnimatorBase::prp_afterChangedAbsRange(range, clip);
+}
+
+const SmartPathInterpolator& SmartPathAnimator::getInterpolator(
+        const SmartPathKey * const prevKey,
+        const SmartPathKey * const nextKey) {
+    auto& interpolator = mInterpolators[prevKey];
+    if(!interpolator) {
+        const auto& prevPath = prevKey->getValue();
+        const auto& nextPath = nextKey->getValue();
+        interpolator = std::make_unique<SmartPathInterpolator>(prevPath, nextPath);
+    }
+    return *interpolator;
+}
+
 void SmartPathAnimator::actionSetNormalNodeCtrlsMode(
         const int nodeId, const CtrlsMode mode) {
     prp_pushUndoRedoName("Set Node Ctrls Mode");
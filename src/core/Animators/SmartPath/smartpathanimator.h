@@ -23,6 +23,10 @@
 #include "../interoptimalanimatort.h"
 #include "differsinterpolate.h"
 #include "smartpath.h"
+#include "smartpathinterpolator.h"
+
+#include <map>
+#include <memory>
 
 using SmartPathKey = InterpolationKeyT<SmartPath>;
 
@@ -57,6 +61,9 @@ public:
     void prp_readProperty(eReadStream& src);
     void prp_writeProperty(eWriteStream& dst) const;
 
+    void prp_afterChangedAbsRange(const FrameRange &range,
+                                  const bool clip);
+
     SkPath getPathAtAbsFrame(const qreal frame)
     { return getPathAtRelFrame(prp_absFrameToRelFrameF(frame)); }
     SkPath getPathAtRelFrame(const qreal frame);
@@ -127,6 +134,14 @@ private:
 
     void updateAllPoints();
 
+    const SmartPathInterpolator& getInterpolator(
+            const SmartPathKey * const prevKey,
+            const SmartPathKey * const nextKey);
+
+    //! @brief Interpolators for adjacent key pairs, by previous key,
+    //! cleared after any key change
+    std::map<const SmartPathKey*,
+             std::unique_ptr<SmartPathInterpolator>> mInterpolators;
     SkPath mResultPath;
     Mode mMode = Mode::normal;
     QColor mPathColor = Qt::white;
@@ -0,0 +1,198 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "smartpathinterpolator.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SMARTPATH_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #define SMARTPATH_NEON
+    #include <arm_neon.h>
+#endif
+
+//! @brief result = weight1*values1 + weight2*values2,
+//! bit exact with the scalar QPointF arithmetic of Node::sInterpolateNormal
+static void lerpValues(const double* const values1,
+                       const double* const values2,
+                       const double weight2,
+                       double* const result, const int count) {
+    const double weight1 = 1 - weight2;
+    int i = 0;
+#if defined(SMARTPATH_SSE2)
+    const __m128d w1 = _mm_set1_pd(weight1);
+    const __m128d w2 = _mm_set1_pd(weight2);
+    for(; i + 2 <= count; i += 2) {
+        const __m128d v1 = _mm_mul_pd(w1, _mm_loadu_pd(values1 + i));
+        const __m128d v2 = _mm_mul_pd(w2, _mm_loadu_pd(values2 + i));
+        _mm_storeu_pd(result + i, _mm_add_pd(v1, v2));
+    }
+#elif defined(SMARTPATH_NEON)
+    const float64x2_t w1 = vdupq_n_f64(weight1);
+    const float64x2_t w2 = vdupq_n_f64(weight2);
+    for(; i + 2 <= count; i += 2) {
+        const float64x2_t v1 = vmulq_f64(w1, vld1q_f64(values1 + i));
+        const float64x2_t v2 = vmulq_f64(w2, vld1q_f64(values2 + i));
+        vst1q_f64(result + i, vaddq_f64(v1, v2));
+    }
+#endif
+    for(; i < count; i++) {
+        result[i] = weight1*values1[i] + weight2*values2[i];
+    }
+}
+
+static void appendNormal(const Node * const node, std::vector<double>& values) {
+    const QPointF c0 = node->c0();
+    const QPointF p1 = node->p1();
+    const QPointF c2 = node->c2();
+    values.insert(values.end(), {c0.x(), c0.y(), p1.x(), p1.y(),
+                                 c2.x(), c2.y()});
+}
+
+SmartPathInterpolator::SmartPathInterpolator(const SmartPath& path1,
+                                             const SmartPath& path2) {
+    const auto& list1 = path1.getNodesRef();
+    const auto& list2 = path2.getNodesRef();
+    if(list1.count() != list2.count())
+        RuntimeThrow("Cannot interpolate paths with different node count");
+    if(list1.isClosed() != list2.isClosed())
+        RuntimeThrow("Cannot interpolate a closed path with an open path.");
+    mClosed = list1.isClosed();
+    NodeList list1Cpy = list1;
+    NodeList list2Cpy = list2;
+    const int listCount = list1Cpy.count();
+    for(int i = 0; i < listCount; i++) {
+        const Node * const node1 = list1Cpy.at(i);
+        const Node * const node2 = list2Cpy.at(i);
+        if(node1->getType() == node2->getType()) continue;
+        if(node1->isDissolved()) {
+            list1Cpy.promoteDissolvedNodeToNormal(i);
+        } else if(node2->isDissolved()) {
+            list2Cpy.promoteDissolvedNodeToNormal(i);
+        } else RuntimeThrow("Nodes with different type should not happen");
+    }
+    if(listCount > 0 && list1Cpy.at(0)->isDissolved()) {
+        mUseNodeLists = true;
+        mPath1 = SmartPath(list1Cpy);
+        mPath2 = SmartPath(list2Cpy);
+        return;
+    }
+    mNodes.reserve(static_cast<size_t>(listCount));
+    mValues1.reserve(6*static_cast<size_t>(listCount));
+    mValues2.reserve(6*static_cast<size_t>(listCount));
+    for(int i = 0; i < listCount; i++) {
+        const Node * const node1 = list1Cpy.at(i);
+        const Node * const node2 = list2Cpy.at(i);
+        if(node1->isNormal() && node2->isNormal()) {
+            const auto mode = Node::sInterpolatedCtrlsMode(
+                        node1->getCtrlsMode(), node2->getCtrlsMode());
+            const bool c0Enabled = node1->getC0Enabled() ||
+                                   node2->getC0Enabled();
+            const bool c2Enabled = node1->getC2Enabled() ||
+                                   node2->getC2Enabled();
+            mNodes.push_back({false, c0Enabled, c2Enabled, mode});
+            appendNormal(node1, mValues1);
+            appendNormal(node2, mValues2);
+        } else if(node1->isDissolved() && node2->isDissolved()) {
+            mNodes.push_back({true, false, false, CtrlsMode::corner});
+            mValues1.push_back(node1->t());
+            mValues2.push_back(node2->t());
+        } else RuntimeThrow("Nodes with different type should not happen");
+    }
+}
+
+struct NormalNodePoints {
+    QPointF fC0;
+    QPointF fP1;
+    QPointF fC2;
+};
+
+static void cubicTo(const NormalNodePoints& prevNode,
+                    const NormalNodePoints& nextNode,
+                    std::vector<double>& dissolvedTs, SkPath& result) {
+    qCubicSegment2D seg(prevNode.fP1, prevNode.fC2,
+                        nextNode.fC0, nextNode.fP1);
+    qreal lastT = 0;
+    for(const qreal t : dissolvedTs) {
+        const qreal mappedT = gMapTToFragment(lastT, 1, t);
+        auto div = seg.dividedAtT(mappedT);
+        const auto& first = div.first;
+        result.cubicTo(toSkPoint(first.c1()),
+                       toSkPoint(first.c2()),
+                       toSkPoint(first.p3()));
+        seg = div.second;
+        lastT = t;
+    }
+    result.cubicTo(toSkPoint(seg.c1()),
+                   toSkPoint(seg.c2()),
+                   toSkPoint(seg.p3()));
+    dissolvedTs.clear();
+}
+
+SkPath SmartPathInterpolator::interpolate(const qreal weight2) const {
+    if(mUseNodeLists) {
+        SmartPath result;
+        SmartPath::sInterpolate(mPath1, mPath2, weight2, result);
+        return result.getPathAt();
+    }
+    SkPath result;
+    if(mNodes.empty()) return result;
+
+    const int valueCount = static_cast<int>(mValues1.size());
+    std::vector<double> values(mValues1.size());
+    lerpValues(mValues1.data(), mValues2.data(), weight2,
+               values.data(), valueCount);
+
+    NormalNodePoints firstNode;
+    NormalNodePoints prevNode;
+    std::vector<double> dissolvedTs;
+    bool move = true;
+    const double* value = values.data();
+    for(const auto& node : mNodes) {
+        if(node.fDissolved) {
+            dissolvedTs.push_back(*value++);
+            continue;
+        }
+        QPointF c0(value[0], value[1]);
+        const QPointF p1(value[2], value[3]);
+        QPointF c2(value[4], value[5]);
+        value += 6;
+        if(node.fCtrlsMode == CtrlsMode::symmetric) {
+            gGetCtrlsSymmetricPos(c0, p1, c2, c0, c2);
+        } else if(node.fCtrlsMode == CtrlsMode::smooth) {
+            gGetCtrlsSmoothPos(c0, p1, c2, c0, c2);
+        } else {
+            if(!node.fC0Enabled) c0 = p1;
+            if(!node.fC2Enabled) c2 = p1;
+        }
+        const NormalNodePoints points{c0, p1, c2};
+        if(move) {
+            firstNode = points;
+            result.moveTo(toSkPoint(p1));
+            move = false;
+        } else {
+            cubicTo(prevNode, points, dissolvedTs, result);
+        }
+        prevNode = points;
+    }
+    if(mClosed) {
+        cubicTo(prevNode, firstNode, dissolvedTs, result);
+        result.close();
+    }
+    return result;
+}
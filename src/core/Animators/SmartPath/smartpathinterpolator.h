@@ -0,0 +1,59 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef SMARTPATHINTERPOLATOR_H
+#define SMARTPATHINTERPOLATOR_H
+
+#include "smartpath.h"
+
+#include <vector>
+
+//! @brief Interpolation between the paths of a key pair.
+//! Node type matching (promotion of dissolved nodes) is done once,
+//! node values of both paths are stored in flat arrays,
+//! interpolated with a single vectorized pass and converted
+//! directly to SkPath, without creating intermediate nodes.
+class CORE_EXPORT SmartPathInterpolator {
+public:
+    SmartPathInterpolator(const SmartPath& path1, const SmartPath& path2);
+    SmartPathInterpolator(const SmartPathInterpolator&) = delete;
+    SmartPathInterpolator& operator=(const SmartPathInterpolator&) = delete;
+
+    //! @brief Same as gInterpolate followed by SmartPath::getPathAt
+    SkPath interpolate(const qreal weight2) const;
+private:
+    struct NodeInfo {
+        bool fDissolved;
+        bool fC0Enabled;
+        bool fC2Enabled;
+        CtrlsMode fCtrlsMode;
+    };
+
+    bool mClosed = false;
+    //! @brief Result starting with a dissolved node needs promotion,
+    //! handled by interpolating node lists.
+    bool mUseNodeLists = false;
+    SmartPath mPath1;
+    SmartPath mPath2;
+
+    std::vector<NodeInfo> mNodes;
+    //! @brief c0, p1, c2 coordinates for normal nodes, t for dissolved
+    std::vector<double> mValues1;
+    std::vector<double> mValues2;
+};
+
+#endif // SMARTPATHINTERPOLATOR_H
@@ -24,6 +24,7 @@
 #include "Private/esettings.h"
 
 #include <QPainter>
+#include <climits>
 
 Animator::Animator(const QString& name) : Property(name), anim_mKeys(this) {}
 
@@ -85,7 +86,7 @@ int Animator::anim_getNextKeyRelFrame(const int relFrame) const {
 }
 
 void Animator::prp_afterChangedAbsRange(const FrameRange &range, const bool clip) {
-    if(range.inRange(anim_mCurrentAbsFrame))
+    if(range.inRange(anim_getCurrentAbsFrame()))
         prp_afterChangedCurrent(UpdateReason::userChange);
     emit prp_absFrameRangeChanged(range, clip);
 }
@@ -272,6 +273,7 @@ void Animator::anim_appendKey(const stdsptr<Key>& newKey) {
     const bool isComplex = toComplexAnimator();
     if(!isComplex) anim_setRecordingValue(true);
     anim_mKeys.add(newKey);
+    anim_updateAnimatedSelf();
     if(newKey->getRelFrame() == anim_mCurrentRelFrame)
         anim_setKeyOnCurrentFrame(newKey.get());
     if(!isComplex) anim_updateAfterChangedKey(newKey.get());
@@ -307,6 +309,7 @@ void Animator::removeKeyWithoutDeselecting(const stdsptr<Key>& keyToRemove) {
     const int rFrame = keyPtr->getRelFrame();
     if(rFrame == anim_mCurrentRelFrame)
         anim_setKeyOnCurrentFrame(nullptr);
+    anim_updateAnimatedSelf();
     emit anim_removedKey(keyPtr, QPrivateSignal());
 }
 
@@ -443,13 +446,53 @@ std::pair<int, int> Animator::anim_getPrevAndNextKeyIdF(const qreal relFrame) co
 }
 
 int Animator::anim_getCurrentAbsFrame() const {
+    if(anim_followsParentFrame())
+        return getParent()->anim_getCurrentAbsFrame();
     return anim_mCurrentAbsFrame;
 }
 
 int Animator::anim_getCurrentRelFrame() const {
+    if(anim_followsParentFrame())
+        return anim_getCurrentAbsFrame() - prp_getTotalFrameShift();
     return anim_mCurrentRelFrame;
 }
 
+bool Animator::anim_followsParentFrame() const {
+    return anim_mChildProperty && anim_mAnimatedCount == 0 && getParent();
+}
+
+void Animator::anim_updateAnimatedSelf() {
+    const bool animated = anim_isAnimatedSelf();
+    if(animated == anim_mAnimatedSelf) return;
+    anim_mAnimatedSelf = animated;
+    anim_changeAnimatedCount(animated ? 1 : -1);
+}
+
+void Animator::anim_changeAnimatedCount(const int by) {
+    if(by == 0) return;
+    if(anim_mAnimatedCount == 0) {
+        // frame changes were skipped, catch up before tracking them again
+        const int absFrame = anim_getCurrentAbsFrame();
+        anim_mAnimatedCount += by;
+        anim_mCurrentAbsFrame = absFrame;
+        anim_updateRelFrame();
+    } else {
+        anim_mAnimatedCount += by;
+    }
+    Q_ASSERT(anim_mAnimatedCount >= 0);
+    if(anim_mChildProperty && getParent())
+        getParent()->anim_changeAnimatedCount(by);
+}
+
+void Animator::anim_setChildProperty(const bool child) {
+    if(anim_mChildProperty == child) return;
+    if(!child && anim_followsParentFrame()) {
+        anim_mCurrentAbsFrame = anim_getCurrentAbsFrame();
+        anim_mCurrentRelFrame = anim_getCurrentRelFrame();
+    }
+    anim_mChildProperty = child;
+}
+
 FrameRange Animator::prp_getIdenticalRelRange(const int relFrame) const {
     if(anim_mKeys.count() <= 1) return FrameRange::EMINMAX;
     const auto pn = anim_getPrevAndNextKeyId(relFrame);
@@ -589,9 +632,16 @@ void Animator::prp_drawTimelineControls(
     if(type == KeyFrameType::object) radMult = 0.3;
     else radMult = 0.21;
     const qreal keyRadius = rowHeight * radMult;
+    const auto& frames = anim_mKeys.frames();
+    int lastDrawnX = INT_MIN;
     for(int i = idRange.fMin; i <= idRange.fMax; i++) {
         if(i < 0 || i >= anim_mKeys.count()) continue;
+        // dense keys share pixels when zoomed out,
+        // only selected keys need to be drawn over the previous one
+        const int keyX = qFloor(frames[static_cast<size_t>(i)]*pixelsPerFrame);
         const auto& key = anim_mKeys.atId(i);
+        if(keyX == lastDrawnX && !key->isSelected()) continue;
+        lastDrawnX = keyX;
         anim_drawKey(p, key, pixelsPerFrame, absFrameRange.fMin, rowHeight,
                      color, sett.fSelectedKeyframeColor, keyRadius, type);
     }
@@ -713,11 +763,31 @@ void Animator::saveSVG(SvgExporter& exp,
                        const bool transform,
                        const QString& type,
                        const QString& interpolation) const {
+    const ValuesGetter valuesGetter = [&valueGetter](
+            const QVector<qreal>& relFrames) {
+        QStringList values;
+        for(const qreal relFrame : relFrames) {
+            values << valueGetter(static_cast<int>(relFrame));
+        }
+        return values;
+    };
+    saveSVG(exp, parent, visRange, attrName, valuesGetter,
+            transform, type, interpolation);
+}
+
+void Animator::saveSVG(SvgExporter& exp,
+                       QDomElement& parent,
+                       const FrameRange& visRange,
+                       const QString& attrName,
+                       const ValuesGetter& valuesGetter,
+                       const bool transform,
+                       const QString& type,
+                       const QString& interpolation) const {
     Q_ASSERT(!transform || attrName == "transform");
     const auto idRange = prp_getIdenticalRelRange(visRange.fMin);
     const int span = exp.fAbsRange.span();
     if(idRange.inRange(visRange) || span == 1) {
-        auto value = valueGetter(visRange.fMin);
+        auto value = valuesGetter({qreal(visRange.fMin)}).first();
         if(transform) {
             value = parent.attribute(attrName) + " " +
                     type + "(" + value + ")";
@@ -732,13 +802,24 @@ void Animator::saveSVG(SvgExporter& exp,
         const qreal div = span - 1;
         const qreal dur = div/exp.fFps;
         anim.setAttribute("dur", QString::number(dur)  + 's');
+        // the frames are collected first to evaluate them in one call
+        QVector<qreal> frames;
+        QVector<FrameRange> ranges;
         int i = visRange.fMin;
+        while(true) {
+            const auto iRange = exp.fAbsRange*prp_getIdenticalAbsRange(i);
+            frames << i;
+            ranges << iRange;
+            if(iRange.fMax >= visRange.fMax) break;
+            i = prp_nextDifferentRelFrame(i);
+        }
+        const auto frameValues = valuesGetter(frames);
         QStringList values;
         QStringList keyTimes;
-        while(true) {
-            const auto value = valueGetter(i);
+        for(int j = 0; j < frames.count(); j++) {
+            const auto& value = frameValues.at(j);
+            const auto& iRange = ranges.at(j);
             values << value;
-            const auto iRange = exp.fAbsRange*prp_getIdenticalAbsRange(i);
             const qreal minTime = (iRange.fMin - exp.fAbsRange.fMin)/div;
             keyTimes << QString::number(minTime);
             if(iRange.fMin != iRange.fMax) {
@@ -746,8 +827,6 @@ void Animator::saveSVG(SvgExporter& exp,
                 const qreal maxTime = (iRange.fMax - exp.fAbsRange.fMin)/div;
                 keyTimes << QString::number(maxTime);
             }
-            if(iRange.fMax >= visRange.fMax) break;
-            i = prp_nextDifferentRelFrame(i);
         }
         if(keyTimes.isEmpty()) return;
         if(keyTimes.last() != "1") {
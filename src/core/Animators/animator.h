@@ -33,9 +33,15 @@ class CORE_EXPORT Animator : public Property {
     Q_OBJECT
     e_DECLARE_TYPE(Animator)
     friend class OverlappingKeys;
+    friend class ComplexAnimator;
 protected:
     Animator(const QString &name);
 
+    //! @brief Whether the animator itself changes with the frame,
+    //! update with anim_updateAnimatedSelf() when the result changes.
+    virtual bool anim_isAnimatedSelf() const { return anim_hasKeys(); }
+    void anim_updateAnimatedSelf();
+
     virtual void anim_afterKeyOnCurrentFrameChanged(Key* const key)
     { Q_UNUSED(key) }
 public:
@@ -140,6 +146,11 @@ public:
     int anim_getCurrentRelFrame() const;
     int anim_getCurrentAbsFrame() const;
 
+    //! @brief Number of animated animators in this subtree,
+    //! static child properties are skipped on frame change.
+    int anim_getAnimatedCount() const { return anim_mAnimatedCount; }
+    bool anim_isStatic() const { return anim_mAnimatedCount == 0; }
+
     void anim_moveKeyToRelFrame(Key * const key, const int newFrame);
 
     int anim_getPrevKeyRelFrame(const int relFrame) const;
@@ -202,6 +213,16 @@ public:
                  const bool transform,
                  const QString& type,
                  const QString& interpolation = "linear") const;
+    //! @brief Returns the values of all relFrames at once
+    using ValuesGetter = std::function<QStringList(const QVector<qreal>& relFrames)>;
+    void saveSVG(SvgExporter& exp,
+                 QDomElement& parent,
+                 const FrameRange& visRange,
+                 const QString& attrName,
+                 const ValuesGetter& valuesGetter,
+                 const bool transform,
+                 const QString& type,
+                 const QString& interpolation = "linear") const;
 protected:
     void anim_readKeys(eReadStream &src);
     void anim_writeKeys(eWriteStream& dst) const;
@@ -217,7 +238,16 @@ private:
     void anim_updateKeyOnCurrrentFrame();
     void anim_setKeyOnCurrentFrame(Key * const key);
 
+    void anim_changeAnimatedCount(const int by);
+    void anim_setChildProperty(const bool child);
+    bool anim_followsParentFrame() const;
+
     bool anim_mIsRecording = false;
+    //! @brief Direct child of a ComplexAnimator, frames of static
+    //! child properties are taken from the parent.
+    bool anim_mChildProperty = false;
+    bool anim_mAnimatedSelf = false;
+    int anim_mAnimatedCount = 0;
 
     int anim_mCurrentAbsFrame = 0;
     int anim_mCurrentRelFrame = 0;
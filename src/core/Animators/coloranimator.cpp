@@ -130,6 +130,21 @@ QColor ColorAnimator::getColor(const qreal relFrame) const {
     return valuesToColor(val1, val2, val3, alpha, mColorMode);
 }
 
+void ColorAnimator::evaluate(const QVector<qreal>& relFrames,
+                             QVector<QColor>& colors) const {
+    QVector<qreal> val1s, val2s, val3s, alphas;
+    mVal1Animator->evaluate(relFrames, val1s);
+    mVal2Animator->evaluate(relFrames, val2s);
+    mVal3Animator->evaluate(relFrames, val3s);
+    mAlphaAnimator->evaluate(relFrames, alphas);
+    const int count = relFrames.count();
+    colors.resize(count);
+    for(int i = 0; i < count; i++) {
+        colors[i] = valuesToColor(val1s.at(i), val2s.at(i), val3s.at(i),
+                                  alphas.at(i), mColorMode);
+    }
+}
+
 void ColorAnimator::setColor(const QColor &col) {
     qreal val1, val2, val3;
     const qreal alpha = col.alphaF();
@@ -258,9 +273,14 @@ void ColorAnimator::saveColorSVG(SvgExporter& exp,
                                  QDomElement& parent,
                                  const FrameRange& visRange,
                                  const QString& name) const {
-    Animator::saveSVG(exp, parent, visRange, name, [this](const int relFrame) {
-        return getColor(relFrame).name();
-    });
+    const ValuesGetter valuesGetter = [this](const QVector<qreal>& relFrames) {
+        QVector<QColor> colors;
+        evaluate(relFrames, colors);
+        QStringList values;
+        for(const auto& color : colors) values << color.name();
+        return values;
+    };
+    Animator::saveSVG(exp, parent, visRange, name, valuesGetter, false, "");
 }
 
 void ColorAnimator::prp_setupTreeViewMenu(PropertyMenu * const menu) {
@@ -43,6 +43,8 @@ public:
     QColor getBaseColor(const qreal relFrame) const;
     QColor getColor() const;
     QColor getColor(const qreal relFrame) const;
+    void evaluate(const QVector<qreal>& relFrames,
+                  QVector<QColor>& colors) const;
     void setColor(const QColor& col);
 
     void setColorMode(const ColorMode colorMode);
@@ -156,6 +156,8 @@ void ComplexAnimator::ca_insertChild(const qsptr<Property>& child,
         childAnimator->anim_addAllKeysToComplexAnimator(this);
         ca_childIsRecordingChanged();
         childAnimator->anim_setAbsFrame(anim_getCurrentAbsFrame());
+        childAnimator->anim_setChildProperty(true);
+        anim_changeAnimatedCount(childAnimator->anim_getAnimatedCount());
     }
     if(changeInfluence){
         connect(child.data(), &Property::prp_absFrameRangeChanged,
@@ -279,6 +281,8 @@ void ComplexAnimator::ca_removeChild(const qsptr<Property> child) {
     const auto childRange = child->prp_absInfluenceRange();
     if(const auto childAnimator = enve_cast<Animator*>(child.get())) {
         childAnimator->anim_removeAllKeysFromComplexAnimator(this);
+        anim_changeAnimatedCount(-childAnimator->anim_getAnimatedCount());
+        childAnimator->anim_setChildProperty(false);
     }
     disconnect(child.get(), nullptr, this, nullptr);
 
@@ -349,13 +353,15 @@ void ComplexAnimator::prp_afterFrameShiftChanged(const FrameRange &oldAbsRange,
         property->prp_setInheritedFrameShift(thisShift, this);
 }
 
+int ComplexAnimator::sFrameChangeSkips = 0;
+
 void ComplexAnimator::anim_setAbsFrame(const int frame) {
-    //if(!anim_isDescendantRecording()) return;
     Animator::anim_setAbsFrame(frame);
 
     for(const auto &property : ca_mChildren) {
         if(const auto asAnim = enve_cast<Animator*>(property.get())) {
-            asAnim->anim_setAbsFrame(frame);
+            if(asAnim->anim_isStatic()) sFrameChangeSkips++;
+            else asAnim->anim_setAbsFrame(frame);
         }
     }
 }
@@ -137,6 +137,15 @@ public:
 
     void ca_setHiddenWhenEmpty(const bool hidden);
     void ca_setDisabledWhenEmpty(const bool disabled);
+
+    //! @brief Number of key or expression animated descendants
+    int ca_getAnimatedDescendantsCount() const
+    { return anim_getAnimatedCount(); }
+
+    //! @brief Static child properties skipped by anim_setAbsFrame
+    //! since the last ca_resetFrameChangeSkips() call.
+    static int ca_getFrameChangeSkips() { return sFrameChangeSkips; }
+    static void ca_resetFrameChangeSkips() { sFrameChangeSkips = 0; }
 signals:
     void ca_childAdded(Property*);
     void ca_childRemoved(Property*);
@@ -159,7 +168,11 @@ protected:
 
     const QList<qsptr<Property>>& ca_getChildren() const
     { return ca_mChildren; }
+
+    bool anim_isAnimatedSelf() const { return false; }
 private:
+    static int sFrameChangeSkips;
+
     bool ca_mDisabledEmpty = true;
     bool ca_mHiddenEmpty = false;
     bool ca_mChildRecording = false;
@@ -520,12 +520,31 @@ void GraphAnimator::graph_saveSVG(SvgExporter& exp,
                                   const ValueGetter& valueGetter,
                                   const bool transform,
                                   const QString& type) const {
+    const ValuesGetter valuesGetter = [&valueGetter](
+            const QVector<qreal>& relFrames) {
+        QStringList values;
+        for(const qreal relFrame : relFrames) {
+            values << valueGetter(static_cast<int>(relFrame));
+        }
+        return values;
+    };
+    graph_saveSVG(exp, parent, visRange, attrName, valuesGetter,
+                  transform, type);
+}
+
+void GraphAnimator::graph_saveSVG(SvgExporter& exp,
+                                  QDomElement& parent,
+                                  const FrameRange& visRange,
+                                  const QString& attrName,
+                                  const ValuesGetter& valuesGetter,
+                                  const bool transform,
+                                  const QString& type) const {
     Q_ASSERT(!transform || attrName == "transform");
     const auto relRange = prp_absRangeToRelRange(exp.fAbsRange);
     const auto idRange = prp_getIdenticalRelRange(visRange.fMin);
     const int span = exp.fAbsRange.span();
     if(idRange.inRange(visRange) || span == 1) {
-        auto value = valueGetter(visRange.fMin);
+        auto value = valuesGetter({qreal(visRange.fMin)}).first();
         if(transform) {
             value = parent.attribute(attrName) + " " +
                     type + "(" + value + ")";
@@ -543,7 +562,8 @@ void GraphAnimator::graph_saveSVG(SvgExporter& exp,
         const auto& keys = anim_getKeys();
         GraphKey* nextKey = nullptr;
         GraphKey* prevKey = nullptr;
-        QStringList values;
+        // the frames are collected first to evaluate them in one call
+        QVector<qreal> frames;
         QStringList keyTimes;
         QStringList keySplines;
         const QString ks = QString("%1 %2 %3 %4");
@@ -557,12 +577,12 @@ void GraphAnimator::graph_saveSVG(SvgExporter& exp,
                     if(nextKeyRelFrame != visRange.fMin) {
                         keySplines << ks.arg(0).arg(0).arg(1).arg(1);
                         keyTimes << QString::number(0);
-                        values << valueGetter(visRange.fMin);
+                        frames << visRange.fMin;
                     }
                     const int prevRelFrame = prevKey->getRelFrame();
                     const qreal t = (prevRelFrame - relRange.fMin)/div;
                     keyTimes << QString::number(t);
-                    values << valueGetter(prevRelFrame);
+                    frames << prevRelFrame;
                 }
                 const auto xSeg = getGraphXSegment(prevKey, nextKey);
                 const auto ySeg = getGraphYSegment(prevKey, nextKey);
@@ -587,7 +607,7 @@ void GraphAnimator::graph_saveSVG(SvgExporter& exp,
                     const qreal relFrame = subSeg.first.p1();
                     const qreal t = (relFrame - relRange.fMin)/div;
                     keyTimes << QString::number(t);
-                    values << valueGetter(relFrame);
+                    frames << relFrame;
                 }
                 if(nextKeyRelFrame >= visRange.fMax) break;
             }
@@ -596,8 +616,9 @@ void GraphAnimator::graph_saveSVG(SvgExporter& exp,
         if(nextKey && nextKey->getRelFrame() < visRange.fMax) {
             keySplines << ks.arg(0).arg(0).arg(1).arg(1);
             keyTimes << QString::number(1);
-            values << valueGetter(visRange.fMax);
+            frames << visRange.fMax;
         }
+        const auto values = valuesGetter(frames);
 
         anim.setAttribute("calcMode", "spline");
         anim.setAttribute("values", values.join(';'));
@@ -83,6 +83,13 @@ public:
                        const ValueGetter& valueGetter,
                        const bool transform = false,
                        const QString& type = "") const;
+    void graph_saveSVG(SvgExporter& exp,
+                       QDomElement& parent,
+                       const FrameRange& visRange,
+                       const QString& attrName,
+                       const ValuesGetter& valuesGetter,
+                       const bool transform = false,
+                       const QString& type = "") const;
 protected:
     qreal graph_prevKeyWeight(const GraphKey * const prevKey,
                               const GraphKey * const nextKey,
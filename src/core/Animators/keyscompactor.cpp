@@ -0,0 +1,67 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "keyscompactor.h"
+
+#include "Private/document.h"
+
+KeysCompactor::KeysCompactor(const QList<QrealAnimator*>& targets,
+                             const qreal tolerance) :
+    mTolerance(tolerance) {
+    for(const auto target : targets) {
+        const auto& keys = target->anim_getKeys();
+        // nothing to remove with less than three keys
+        if(keys.count() < 3) continue;
+        const int minFrame = keys.first()->getRelFrame();
+        const int maxFrame = keys.last()->getRelFrame();
+        mTargets.append({target, target->getBaseValueSnapshot(),
+                         {minFrame, maxFrame}, keys.count(), {}});
+    }
+}
+
+void KeysCompactor::sCompact(const QList<QrealAnimator*>& targets,
+                             const qreal tolerance) {
+    const auto task = enve::make_shared<KeysCompactor>(targets, tolerance);
+    if(task->mTargets.isEmpty()) return;
+    task->queTask();
+}
+
+void KeysCompactor::process() {
+    const qreal error = mTolerance*mTolerance;
+    for(auto& target : mTargets) {
+        const auto samples = QrealAnimator::sSampleKeys(*target.fSnapshot,
+                                                        target.fRelRange);
+        target.fSegments = QrealAnimator::sFitSamples(samples, error);
+    }
+}
+
+void KeysCompactor::afterProcessing() {
+    bool changed = false;
+    for(const auto& target : mTargets) {
+        const auto animator = target.fAnimator.data();
+        if(!animator) continue;
+        // keys changed while fitting
+        if(animator->getBaseValueSnapshot() != target.fSnapshot) continue;
+        if(target.fSegments.isEmpty()) continue;
+        if(target.fSegments.count() + 1 >= target.fKeyCount) continue;
+        animator->prp_pushUndoRedoName("Compact Keys");
+        animator->replaceKeysWithSegments(target.fRelRange,
+                                          target.fSegments, true);
+        changed = true;
+    }
+    if(changed) Document::sInstance->actionFinished();
+}
@@ -0,0 +1,53 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef KEYSCOMPACTOR_H
+#define KEYSCOMPACTOR_H
+
+#include "Tasks/updatable.h"
+#include "qrealanimator.h"
+
+//! @brief Refits dense keys of QrealAnimators into a minimal set of
+//! cubic keys deviating from the original values by at most tolerance.
+//! Keys are sampled from snapshots and fitted on a worker thread,
+//! the results replace the keys on the main thread.
+class CORE_EXPORT KeysCompactor : public eCpuTask {
+    e_OBJECT
+protected:
+    KeysCompactor(const QList<QrealAnimator*>& targets,
+                  const qreal tolerance);
+public:
+    static void sCompact(const QList<QrealAnimator*>& targets,
+                         const qreal tolerance);
+
+    void process();
+protected:
+    void afterProcessing();
+private:
+    struct Target {
+        qptr<QrealAnimator> fAnimator;
+        QrealAnimator::BaseValueSnapshot fSnapshot;
+        FrameRange fRelRange;
+        int fKeyCount;
+        QVector<QrealAnimator::FittedSegment> fSegments;
+    };
+
+    const qreal mTolerance;
+    QList<Target> mTargets;
+};
+
+#endif // KEYSCOMPACTOR_H
@@ -16,6 +16,8 @@
 
 #include "overlappingkeylist.h"
 
+#include <algorithm>
+
 bool OverlappingKeyList::hasKey(const Key * const key, int *idP) const {
     int id = idAtFrame(key->getRelFrame());
     if(idP) *idP = id;
@@ -30,15 +32,15 @@ bool OverlappingKeyList::isDuplicateAtIdex(const int index) const {
 
 void OverlappingKeyList::add(const stdsptr<Key> &key) {
     const int relFrame = key->getRelFrame();
-    const auto notLess = lowerBound(relFrame);
-    if(notLess == mList.end()) {
+    const int notLessId = lowerBoundId(relFrame);
+    if(notLessId == mList.count()) {
         mList.append(OverlappingKeys(key, mAnimator));
+        mFrames.push_back(relFrame);
+    } else if(frameAtId(notLessId) == relFrame) {
+        mList[notLessId].addKey(key);
     } else {
-        if(notLess->getFrame() == relFrame) notLess->addKey(key);
-        else {
-            const int insertId = notLess - mList.begin();
-            mList.insert(insertId, OverlappingKeys(key, mAnimator));
-        }
+        mList.insert(notLessId, OverlappingKeys(key, mAnimator));
+        mFrames.insert(mFrames.begin() + notLessId, relFrame);
     }
 }
 
@@ -48,16 +50,18 @@ void OverlappingKeyList::remove(const stdsptr<Key> &key) {
     if(removeId == -1) return;
     auto& ovrlp = mList[removeId];
     ovrlp.removeKey(key);
-    if(ovrlp.isEmpty()) mList.removeAt(removeId);
+    if(ovrlp.isEmpty()) {
+        mList.removeAt(removeId);
+        mFrames.erase(mFrames.begin() + removeId);
+    }
 }
 
 std::pair<int, int> OverlappingKeyList::prevAndNextId(const int relFrame) const {
     if(mList.isEmpty()) return {-1, -1};
-    const auto notLess = lowerBound(relFrame);
-    if(notLess == mList.end())
+    const int notLessId = lowerBoundId(relFrame);
+    if(notLessId == mList.count())
         return {mList.count() - 1, -1};
-    const int notLessId = notLess - mList.begin();
-    if(notLess->getFrame() == relFrame) {
+    if(frameAtId(notLessId) == relFrame) {
         if(notLessId == mList.count() - 1)
             return {notLessId - 1, -1};
         return {notLessId - 1, notLessId + 1};
@@ -66,43 +70,14 @@ std::pair<int, int> OverlappingKeyList::prevAndNextId(const int relFrame) const
     return {notLessId - 1, notLessId};
 }
 
-bool OKeyFrameMore(const int relFrame, const OverlappingKeys& keys) {
-    return keys.getFrame() > relFrame;
-}
-
-OverlappingKeyList::OKeyListCIter
-OverlappingKeyList::upperBound(const int relFrame) const {
-    return std::upper_bound(mList.begin(), mList.end(),
-                            relFrame, OKeyFrameMore);
-}
-
-OverlappingKeyList::OKeyListIter
-OverlappingKeyList::upperBound(const int relFrame) {
-    return std::upper_bound(mList.begin(), mList.end(),
-                            relFrame, OKeyFrameMore);
-}
-
-bool OKeyFrameLess(const OverlappingKeys& keys,
-                   const int relFrame) {
-    return keys.getFrame() < relFrame;
-}
-
-OverlappingKeyList::OKeyListCIter
-    OverlappingKeyList::lowerBound(const int relFrame) const {
-    return std::lower_bound(mList.begin(), mList.end(),
-                            relFrame, OKeyFrameLess);
-}
-
-OverlappingKeyList::OKeyListIter
-    OverlappingKeyList::lowerBound(const int relFrame) {
-    return std::lower_bound(mList.begin(), mList.end(),
-                            relFrame, OKeyFrameLess);
+int OverlappingKeyList::lowerBoundId(const int relFrame) const {
+    const auto it = std::lower_bound(mFrames.begin(), mFrames.end(), relFrame);
+    return static_cast<int>(it - mFrames.begin());
 }
 
 int OverlappingKeyList::idAtFrame(const int relFrame) const {
-    const auto notPrevious = lowerBound(relFrame);
-    if(notPrevious == mList.end()) return -1;
-    if(notPrevious->getFrame() == relFrame)
-        return notPrevious - mList.begin();
+    const int notPreviousId = lowerBoundId(relFrame);
+    if(notPreviousId == mList.count()) return -1;
+    if(frameAtId(notPreviousId) == relFrame) return notPreviousId;
     return -1;
 }
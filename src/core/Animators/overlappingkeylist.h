@@ -19,9 +19,13 @@
 
 #include "overlappingkeys.h"
 
+#include <vector>
+
+//! @brief Keys sorted by frame.
+//! Frames are kept in a flat array parallel to the key list,
+//! so lookups binary search contiguous memory
+//! and only the found key object is accessed.
 class CORE_EXPORT OverlappingKeyList {
-    typedef QList<OverlappingKeys>::const_iterator OKeyListCIter;
-    typedef QList<OverlappingKeys>::iterator OKeyListIter;
 public:
     OverlappingKeyList(Animator * const animator) :
         mAnimator(animator) {}
@@ -88,18 +92,23 @@ public:
     T* last() const
     { return atId<T>(mList.count() - 1); }
 
+    //! @brief Relative frames of the keys, sorted, one per key id
+    const std::vector<int>& frames() const
+    { return mFrames; }
+    int frameAtId(const int id) const
+    { return mFrames[static_cast<size_t>(id)]; }
+
     void mergeAll()
     { for(auto& oKey : mList) oKey.merge(); }
 private:
-    OKeyListCIter upperBound(const int relFrame) const;
-    OKeyListCIter lowerBound(const int relFrame) const;
-    OKeyListIter upperBound(const int relFrame);
-    OKeyListIter lowerBound(const int relFrame);
+    //! @brief Id of the first key not before relFrame
+    int lowerBoundId(const int relFrame) const;
 
     int idAtFrame(const int relFrame) const;
 
     Animator * const mAnimator;
     QList<OverlappingKeys> mList;
+    std::vector<int> mFrames;
 };
 
 template <class T>
@@ -111,11 +120,7 @@ T* OverlappingKeyList::atId(const int id) const {
 
 template <class T>
 T* OverlappingKeyList::atRelFrame(const int relFrame) const {
-    const int id = idAtFrame(relFrame);
-    const auto kAtId = atId<T>(id);
-    if(!kAtId) return nullptr;
-    if(kAtId->getRelFrame() == relFrame) return kAtId;
-    return nullptr;
+    return atId<T>(idAtFrame(relFrame));
 }
 
 #endif // OVERLAPPINGKEYLIST_H
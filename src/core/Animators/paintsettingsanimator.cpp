@@ -303,15 +303,10 @@ void PaintSettingsAnimator::saveSVG(SvgExporter& exp,
                                      "return Math.sqrt(distPt[0]*distPt[0] + "
                                                       "distPt[1]*distPt[1]);";
 
-                auto engine = std::make_unique<QJSEngine>();
-                Expression::sAddDefinitionsTo("", *engine);
-                QJSValue eEvaluate;
-                Expression::sAddScriptTo(rScript, bindings, *engine, eEvaluate,
-                                         Expression::sQrealAnimatorTester);
+                Expression::sValidateScript("", rScript, bindings,
+                                            Expression::sQrealAnimatorTester);
                 const auto rExpr = Expression::sCreate("", rScript,
-                                                       std::move(bindings),
-                                                       std::move(engine),
-                                                       std::move(eEvaluate));
+                                                       std::move(bindings));
 
                 const auto rAnim = enve::make_shared<QrealAnimator>("");
                 rAnim->setExpression(rExpr);
@@ -105,6 +105,19 @@ QPointF QPointFAnimator::getEffectiveValue(const qreal relFrame) const {
                    mYAnimator->getEffectiveValue(relFrame));
 }
 
+void QPointFAnimator::evaluate(const QVector<qreal>& relFrames,
+                               QVector<QPointF>& values) const {
+    QVector<qreal> xs;
+    QVector<qreal> ys;
+    mXAnimator->evaluate(relFrames, xs);
+    mYAnimator->evaluate(relFrames, ys);
+    const int count = relFrames.count();
+    values.resize(count);
+    for(int i = 0; i < count; i++) {
+        values[i] = QPointF(xs.at(i), ys.at(i));
+    }
+}
+
 void QPointFAnimator::setPrefferedValueStep(const qreal valueStep) {
     mXAnimator->setPrefferedValueStep(valueStep);
     mYAnimator->setPrefferedValueStep(valueStep);
@@ -234,12 +247,18 @@ void QPointFAnimator::saveQPointFSVG(SvgExporter& exp,
                                      const QString& name,
                                      const bool transform,
                                      const QString& type) const {
+    const ValuesGetter valuesGetter = [this](const QVector<qreal>& relFrames) {
+        QVector<QPointF> points;
+        evaluate(relFrames, points);
+        QStringList values;
+        for(const auto& value : points) {
+            values << QString::number(value.x()) + " " +
+                      QString::number(value.y());
+        }
+        return values;
+    };
     Animator::saveSVG(exp, parent, visRange, name,
-                      [this](const int relFrame) {
-        const auto value = getEffectiveValue(relFrame);
-        return QString::number(value.x()) + " " +
-               QString::number(value.y());
-    }, transform, type);
+                      valuesGetter, transform, type);
 }
 
 void QPointFAnimator::saveQPointFSVGX(SvgExporter& exp,
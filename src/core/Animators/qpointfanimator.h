@@ -78,6 +78,8 @@ public:
     QPointF getEffectiveValue() const;
     QPointF getEffectiveValueAtAbsFrame(const qreal frame) const;
     QPointF getEffectiveValue(const qreal relFrame) const;
+    void evaluate(const QVector<qreal>& relFrames,
+                  QVector<QPointF>& values) const;
 
     qreal getEffectiveXValue();
     qreal getEffectiveXValue(const qreal relFrame);
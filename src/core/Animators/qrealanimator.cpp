@@ -19,26 +19,43 @@
 #include "qrealpoint.h"
 #include "qrealkey.h"
 #include "../Expressions/expression.h"
+#include "../Expressions/expressiongraph.h"
 #include "../simpletask.h"
 #include "typemenu.h"
+#include "keyscompactor.h"
 #include "GUI/dialogsinterface.h"
 #include "Segments/fitcurves.h"
 #include "svgexporter.h"
 #include "Properties/namedproperty.h"
 
+#include <QInputDialog>
+
 QrealAnimator::QrealAnimator(const qreal iniVal,
                              const qreal minVal,
                              const qreal maxVal,
                              const qreal prefferdStep,
                              const QString &name) :
-    GraphAnimator(name) {
+    QrealAnimator(name) {
     mCurrentBaseValue = iniVal;
     mClampMin = minVal;
     mClampMax = maxVal;
     mPrefferedValueStep = prefferdStep;
+    updateBaseValueSnapshot();
 }
 
-QrealAnimator::QrealAnimator(const QString &name) : GraphAnimator(name) {}
+QrealAnimator::QrealAnimator(const QString &name) : GraphAnimator(name) {
+    updateBaseValueSnapshot();
+    connect(this, &Animator::anim_addedKey, this, [this]() {
+        updateBaseValueSnapshot();
+    });
+    connect(this, &Animator::anim_removedKey, this, [this]() {
+        updateBaseValueSnapshot();
+    });
+}
+
+QrealAnimator::~QrealAnimator() {
+    if(mExpression) ExpressionGraph::sRemoveNode(this);
+}
 
 void QrealAnimator::prp_setupTreeViewMenu(PropertyMenu * const menu) {
     if(menu->hasActionsForType<QrealAnimator>()) return;
@@ -66,6 +83,17 @@ void QrealAnimator::prp_setupTreeViewMenu(PropertyMenu * const menu) {
     };
     menu->addPlainAction("Clear Expression", cOp)->setEnabled(hasExpression());
     menu->addSeparator();
+
+    const PropertyMenu::AllOp<QrealAnimator> kOp =
+    [parentWidget](const QList<QrealAnimator*>& targets) {
+        bool ok;
+        const qreal tolerance = QInputDialog::getDouble(
+                    parentWidget, "Compact Keys",
+                    "Tolerance:", 0.01, 0.0001, 1000, 4, &ok);
+        if(ok) KeysCompactor::sCompact(targets, tolerance);
+    };
+    menu->addPlainAction("Compact Keys...", kOp)->setEnabled(anim_getKeys().count() > 2);
+    menu->addSeparator();
     Animator::prp_setupTreeViewMenu(menu);
 }
 
@@ -194,16 +222,19 @@ QrealSnapshot QrealAnimator::makeSnapshot(
 void QrealAnimator::setValueRange(const qreal minVal, const qreal maxVal) {
     mClampMin = minVal;
     mClampMax = maxVal;
+    updateBaseValueSnapshot();
     setCurrentBaseValue(mCurrentBaseValue);
 }
 
 void QrealAnimator::setMinValue(const qreal minVal) {
     mClampMin = minVal;
+    updateBaseValueSnapshot();
     setCurrentBaseValue(mCurrentBaseValue);
 }
 
 void QrealAnimator::setMaxValue(const qreal maxVal) {
     mClampMax = maxVal;
+    updateBaseValueSnapshot();
     setCurrentBaseValue(mCurrentBaseValue);
 }
 
@@ -285,44 +316,52 @@ void QrealAnimator::setExpressionAction(const qsptr<Expression> &expression) {
     setExpression(expression);
 }
 
-void QrealAnimator::applyExpressionSub(const FrameRange& relRange,
-                                       const int sampleInc,
-                                       const bool action,
-                                       const qreal accuracy) {
-    if(!relRange.isValid()) return;
-    const int count = qCeil(relRange.span()/qreal(sampleInc));
-    QVector<QPointF> pts;
-    pts.reserve(count);
-
+QVector<QrealAnimator::FittedSegment> QrealAnimator::sFitSamples(
+        const QVector<QPointF>& samples, const qreal error) {
+    QVector<FittedSegment> result;
+    if(samples.count() < 2) return result;
+    // keeps fitted segments single valued in frame,
+    // fitting error is measured mostly along the value axis
     const qreal frameMultiplier = 100;
     const qreal frameDivider = 1/frameMultiplier;
 
-    qreal valSum = 0;
-    for(int i = 0; i < count; i++) {
-        const qreal relFrame = relRange.fMin + i*sampleInc;
-        const qreal value = mExpression->evaluate(relFrame).toNumber();
-        pts << QPointF{relFrame*frameMultiplier, value};
-        valSum += qAbs(value);
+    QVector<QPointF> pts;
+    pts.reserve(samples.count());
+    for(const auto& sample : samples) {
+        pts << QPointF{sample.x()*frameMultiplier, sample.y()};
     }
 
-    anim_removeKeys(relRange, action);
-
-    const qreal valAvg = valSum/count;
-
-    QrealKey* prevKey = nullptr;
-    const auto adder = [this, frameDivider, &prevKey, action](
+    const auto adder = [frameDivider, &result](
                        const int n, const BezierCurve curve) {
         Q_UNUSED(n)
         const auto qptData = reinterpret_cast<QPointF*>(curve);
-        const QPointF& p0 = qptData[0];
-        const QPointF& c1 = qptData[1];
-        const QPointF& c2 = qptData[2];
-        const QPointF& p3 = qptData[3];
+        FittedSegment segment;
+        for(int i = 0; i < 4; i++) {
+            const QPointF& pt = qptData[i];
+            segment[static_cast<size_t>(i)] = {pt.x()*frameDivider, pt.y()};
+        }
+        result << segment;
+    };
+
+    FitCurves::FitCurve(pts, error, adder, true, true);
+    return result;
+}
 
-        const int frame0 = qRound(p0.x()*frameDivider);
-        const qreal frame1 = c1.x()*frameDivider;
-        const qreal frame2 = c2.x()*frameDivider;
-        const int frame3 = qRound(p3.x()*frameDivider);
+void QrealAnimator::replaceKeysWithSegments(
+        const FrameRange& relRange,
+        const QVector<FittedSegment>& segments,
+        const bool action) {
+    anim_removeKeys(relRange, action);
+
+    QrealKey* prevKey = nullptr;
+    for(const auto& segment : segments) {
+        const QPointF& p0 = segment[0];
+        const QPointF& c1 = segment[1];
+        const QPointF& c2 = segment[2];
+        const QPointF& p3 = segment[3];
+
+        const int frame0 = qRound(p0.x());
+        const int frame3 = qRound(p3.x());
 
         stdsptr<QrealKey> key0Ref;
         QrealKey* key0 = nullptr;
@@ -339,19 +378,61 @@ void QrealAnimator::applyExpressionSub(const FrameRange& relRange,
         else anim_appendKey(key1);
 
         key0->setC1Enabled(true);
-        key0->setC1Frame(frame1);
+        key0->setC1Frame(c1.x());
         key0->setC1Value(c1.y());
         key0->guessCtrlsMode();
 
         key1->setC0Enabled(true);
         key1->setCtrlsMode(CtrlsMode::corner);
-        key1->setC0Frame(frame2);
+        key1->setC0Frame(c2.x());
         key1->setC0Value(c2.y());
 
         prevKey = key1.get();
-    };
+    }
+}
 
-    FitCurves::FitCurve(pts, 0.01*(0.01 + valAvg/accuracy), adder, true, true);
+void QrealAnimator::applyExpressionSub(const FrameRange& relRange,
+                                       const int sampleInc,
+                                       const bool action,
+                                       const qreal accuracy) {
+    if(!relRange.isValid()) return;
+    const int count = qCeil(relRange.span()/qreal(sampleInc));
+
+    QVector<qreal> relFrames(count);
+    for(int i = 0; i < count; i++) {
+        relFrames[i] = relRange.fMin + i*sampleInc;
+    }
+    const auto values = mExpression->evaluate(relFrames);
+
+    QVector<QPointF> pts;
+    pts.reserve(count);
+    qreal valSum = 0;
+    for(int i = 0; i < count; i++) {
+        const qreal relFrame = relFrames.at(i);
+        const qreal value = values.at(i).toNumber();
+        pts << QPointF{relFrame, value};
+        valSum += qAbs(value);
+    }
+
+    const qreal valAvg = valSum/count;
+    const auto segments = sFitSamples(pts, 0.01*(0.01 + valAvg/accuracy));
+    replaceKeysWithSegments(relRange, segments, action);
+}
+
+QVector<QPointF> QrealAnimator::sSampleKeys(const QrealCurve& curve,
+                                             const FrameRange& relRange) {
+    QVector<QPointF> result;
+    if(!relRange.isValid()) return result;
+    const int count = relRange.span();
+    QVector<qreal> relFrames(count);
+    for(int i = 0; i < count; i++) relFrames[i] = relRange.fMin + i;
+    QVector<qreal> values(count);
+    curve.valuesAtFrames(relFrames.constData(), values.data(), count);
+    result.reserve(count);
+    for(int i = 0; i < count; i++) {
+        result << QPointF{relFrames.at(i), values.at(i)};
+    }
+    return result;
 }
 
 void QrealAnimator::applyExpression(const FrameRange& relRange,
@@ -393,65 +474,60 @@ void QrealAnimator::applyExpression(const FrameRange& relRange,
 
 void QrealAnimator::setExpression(const qsptr<Expression>& expression) {
     auto& conn = mExpression.assign(expression);
+    anim_updateAnimatedSelf();
     if(expression) {
         const int absFrame = anim_getCurrentAbsFrame();
         expression->setAbsFrame(absFrame);
         conn << connect(expression.get(), &Expression::currentValueChanged,
                         this, [this]() {
-            updateCurrentEffectiveValue();
+            ExpressionGraph::sMarkDirty(this);
         });
         conn << connect(expression.get(), &Expression::relRangeChanged,
                         this, [this](const FrameRange& range) {
             prp_afterChangedRelRange(range);
         });
-    }
-    updateCurrentEffectiveValue();
+        conn << connect(expression.get(), &Expression::dependenciesChanged,
+                        this, [this]() {
+            ExpressionGraph::sUpdateDependencies(this);
+        });
+        ExpressionGraph::sAddNode(this);
+        ExpressionGraph::sMarkDirty(this);
+    } else ExpressionGraph::sRemoveNode(this);
     prp_afterWholeInfluenceRangeChanged();
     emit expressionChanged();
 }
 
-qreal QrealAnimator::calculateBaseValueAtRelFrame(const qreal frame) const {
-    if(!anim_hasKeys()) return mCurrentBaseValue;
-    const auto pn = anim_getPrevAndNextKeyIdF(frame);
-    const int prevId = pn.first;
-    const int nextId = pn.second;
-
-    const bool adjKeys = nextId - prevId == 1;
-    const auto keyAtRelFrame = adjKeys ? nullptr :
-                               anim_getKeyAtIndex<QrealKey>(prevId + 1);
-    if(keyAtRelFrame) return keyAtRelFrame->getValue();
-    const auto prevKey = anim_getKeyAtIndex<QrealKey>(prevId);
-    const auto nextKey = anim_getKeyAtIndex<QrealKey>(nextId);
-
-    if(prevKey && nextKey) {
-        const qCubicSegment1D seg{qreal(prevKey->getRelFrame()),
-                                  prevKey->getC1Frame(),
-                                  nextKey->getC0Frame(),
-                                  qreal(nextKey->getRelFrame())};
-        const qreal t = gTFromX(seg, frame);
-        const qreal p0y = prevKey->getValue();
-        const qreal p1y = prevKey->getC1Value();
-        const qreal p2y = nextKey->getC0Value();
-        const qreal p3y = nextKey->getValue();
-        return clamp(gCubicValueAtT({p0y, p1y, p2y, p3y}, t),
-                     mClampMin, mClampMax);
-    } else if(prevKey) {
-        return prevKey->getValue();
-    } else if(nextKey) {
-        return nextKey->getValue();
+QrealAnimator::BaseValueSnapshot QrealAnimator::getBaseValueSnapshot() const {
+    return std::atomic_load(&mCurve);
+}
+
+void QrealAnimator::updateBaseValueSnapshot(const bool keepCurrentValue) {
+    const qreal value = anim_hasKeys() ? 0 : mCurrentBaseValue;
+    const auto curve = std::make_shared<QrealCurve>(value, mClampMin, mClampMax);
+    for(const auto key : anim_getKeys()) {
+        curve->appendKey(static_cast<QrealKey*>(key));
     }
-    return mCurrentBaseValue;
+    mCurveHasFrameValue = false;
+    if(keepCurrentValue && anim_hasKeys()) {
+        const qreal relFrame = anim_getCurrentRelFrame();
+        const qreal keysValue = curve->valueAtFrame(relFrame);
+        if(!isZero4Dec(keysValue - mCurrentBaseValue)) {
+            curve->setFrameValue(relFrame, mCurrentBaseValue);
+            mCurveHasFrameValue = true;
+        }
+    }
+    std::atomic_store(&mCurve, BaseValueSnapshot(curve));
+}
+
+qreal QrealAnimator::calculateBaseValueAtRelFrame(const qreal frame) const {
+    return getBaseValueSnapshot()->valueAtFrame(frame);
 }
 
 qreal QrealAnimator::getBaseValue(const qreal relFrame) const {
-    if(isZero4Dec(relFrame - anim_getCurrentRelFrame()))
-        return mCurrentBaseValue;
     return calculateBaseValueAtRelFrame(relFrame);
 }
 
 qreal QrealAnimator::getEffectiveValue(const qreal relFrame) const {
-    if(isZero4Dec(relFrame - anim_getCurrentRelFrame()))
-        return getEffectiveValue();
     if(mExpression) {
         const auto ret = mExpression->evaluate(relFrame);
         if(ret.isNumber()) return clamped(ret.toNumber());
@@ -459,6 +535,26 @@ qreal QrealAnimator::getEffectiveValue(const qreal relFrame) const {
     return getBaseValue(relFrame);
 }
 
+void QrealAnimator::evaluateBase(const QVector<qreal>& relFrames,
+                                 QVector<qreal>& values) const {
+    const int count = relFrames.count();
+    values.resize(count);
+    const auto curve = getBaseValueSnapshot();
+    curve->valuesAtFrames(relFrames.constData(), values.data(), count);
+}
+
+void QrealAnimator::evaluate(const QVector<qreal>& relFrames,
+                             QVector<qreal>& values) const {
+    evaluateBase(relFrames, values);
+    if(!mExpression) return;
+    const int count = relFrames.count();
+    const auto ret = mExpression->evaluate(relFrames);
+    for(int i = 0; i < count; i++) {
+        const auto& iRet = ret.at(i);
+        if(iRet.isNumber()) values[i] = clamped(iRet.toNumber());
+    }
+}
+
 qreal QrealAnimator::getCurrentBaseValue() const {
     return mCurrentBaseValue;
 }
@@ -471,8 +567,15 @@ qreal QrealAnimator::getEffectiveValue() const {
 bool QrealAnimator::assignCurrentBaseValue(const qreal newValue) {
     if(isZero4Dec(newValue - mCurrentBaseValue)) return false;
     mCurrentBaseValue = newValue;
+    if(!anim_hasKeys() || mCurveHasFrameValue) {
+        updateBaseValueSnapshot(true);
+    } else {
+        const qreal relFrame = anim_getCurrentRelFrame();
+        const qreal keysValue = getBaseValueSnapshot()->valueAtFrame(relFrame);
+        if(!isZero4Dec(keysValue - newValue)) updateBaseValueSnapshot(true);
+    }
     emit baseValueChanged(mCurrentBaseValue);
-    if(mExpression) updateCurrentEffectiveValue();
+    if(mExpression) ExpressionGraph::sMarkDirty(this);
     else emit effectiveValueChanged(mCurrentBaseValue);
     return true;
 }
@@ -526,6 +629,8 @@ void QrealAnimator::prp_afterFrameShiftChanged(const FrameRange &oldAbsRange,
 void QrealAnimator::anim_setAbsFrame(const int frame) {
     GraphAnimator::anim_setAbsFrame(frame);
     const bool baseValChanged = updateCurrentBaseValue();
+    // the value changed without a key belonged to the previous frame
+    if(mCurveHasFrameValue) updateBaseValueSnapshot(true);
     const bool exprValChanged = updateExpressionRelFrame();
     const bool changed = baseValChanged || exprValChanged;
     if(changed) prp_afterChangedCurrent(UpdateReason::frameChange);
@@ -745,6 +850,7 @@ FrameRange QrealAnimator::prp_nextNonUnaryIdenticalRelRange(const int relFrame)
 
 void QrealAnimator::prp_afterChangedAbsRange(const FrameRange &range,
                                              const bool clip) {
+    updateBaseValueSnapshot();
     if(range.inRange(anim_getCurrentAbsFrame()))
         updateCurrentBaseValue();
     GraphAnimator::prp_afterChangedAbsRange(range, clip);
@@ -788,9 +894,18 @@ void QrealAnimator::saveQrealSVG(SvgExporter& exp, QDomElement& parent,
         setExpression(mExpression.sptr());
     } else {
         graph_saveSVG(exp, parent, visRange, attrName,
-                      [this, mangler, &templ](const int relFrame) {
-            const qreal val = mangler(getEffectiveValue(relFrame));
-            return templ.arg(val);
+                      [this, mangler, &templ](const QVector<qreal>& relFrames) {
+            // sampled at whole frames, same as the single frame getters
+            QVector<qreal> frames;
+            frames.reserve(relFrames.count());
+            for(const qreal relFrame : relFrames) {
+                frames << static_cast<int>(relFrame);
+            }
+            QVector<qreal> values;
+            evaluate(frames, values);
+            QStringList result;
+            for(const qreal value : values) result << templ.arg(mangler(value));
+            return result;
         }, transform, type);
     }
 }
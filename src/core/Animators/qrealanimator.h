@@ -18,8 +18,12 @@
 #define VALUEANIMATORS_H
 #include "graphanimator.h"
 #include "qrealsnapshot.h"
+#include "qrealcurve.h"
 #include "../conncontextptr.h"
 
+#include <array>
+#include <memory>
+
 class QrealKey;
 class Expression;
 
@@ -27,6 +31,7 @@ class CORE_EXPORT QrealAnimator :  public GraphAnimator {
     Q_OBJECT
     e_OBJECT
     friend class QPointFAnimator;
+    friend class ExpressionGraph;
 protected:
     QrealAnimator(const QString& name);
     QrealAnimator(const qreal iniVal,
@@ -38,6 +43,8 @@ protected:
     QDomElement prp_writePropertyXEV_impl(const XevExporter& exp) const;
     void prp_readPropertyXEV_impl(const QDomElement& ele, const XevImporter& imp);
 public:
+    ~QrealAnimator();
+
     QJSValue prp_getBaseJSValue(QJSEngine& e) const {
         Q_UNUSED(e)
         return getCurrentBaseValue();
@@ -90,6 +97,9 @@ public:
     void prp_readProperty(eReadStream& src);
     stdsptr<Key> anim_createKey();
 protected:
+    bool anim_isAnimatedSelf() const
+    { return anim_hasKeys() || hasExpression(); }
+
     void graph_getValueConstraints(GraphKey *key, const QrealPointType type,
                                    qreal &minMoveValue, qreal &maxMoveValue) const;
 public:
@@ -112,11 +122,28 @@ public:
     void multCurrentBaseValue(const qreal mult);
 
     qreal getCurrentBaseValue() const;
+    //! @brief Expression values are settled by ExpressionGraph,
+    //! inside of a batch this is the value from before the batch
     qreal getEffectiveValue() const;
     qreal getBaseValue(const qreal relFrame) const;
     qreal getBaseValueAtAbsFrame(const qreal frame) const;
     qreal getEffectiveValue(const qreal relFrame) const;
     qreal getEffectiveValueAtAbsFrame(const qreal frame) const;
+    //! @brief Effective values at relFrames, equivalent to calling
+    //! getEffectiveValue(relFrame) for every frame, but walks keys once
+    //! and evaluates the expression with a single batched call.
+    void evaluate(const QVector<qreal>& relFrames,
+                  QVector<qreal>& values) const;
+    void evaluateBase(const QVector<qreal>& relFrames,
+                      QVector<qreal>& values) const;
+
+    using BaseValueSnapshot = std::shared_ptr<const QrealCurve>;
+    //! @brief Immutable copy of the keys, clamp range and a value
+    //! changed without a key on the current frame.
+    //! Rebuilt by the owning thread on every change and swapped
+    //! atomically, it can be taken and evaluated from any thread.
+    //! Expressions are not part of the snapshot.
+    BaseValueSnapshot getBaseValueSnapshot() const;
 
     qreal getSavedBaseValue();
     void incAllValues(const qreal valInc);
@@ -151,6 +178,7 @@ public:
     bool prp_dependsOn(const Property* const prop) const;
     bool hasValidExpression() const;
     bool hasExpression() const { return mExpression; }
+    Expression* getExpression() const { return mExpression.get(); }
     void clearExpressionAction() { setExpressionAction(nullptr); }
 
     QString getExpressionBindingsString() const;
@@ -163,6 +191,22 @@ public:
                          const qreal accuracy,
                          const bool action);
 
+    //! @brief Cubic segment (p0, c1, c2, p3) in (frame, value) space
+    using FittedSegment = std::array<QPointF, 4>;
+    //! @brief Fits cubic segments to (frame, value) samples sorted by frame,
+    //! error is the maximum squared deviation. Does not access any
+    //! animator, can be used from any thread.
+    static QVector<FittedSegment> sFitSamples(const QVector<QPointF>& samples,
+                                              const qreal error);
+    //! @brief Samples the curve at every frame of relRange,
+    //! can be used from any thread
+    static QVector<QPointF> sSampleKeys(const QrealCurve& curve,
+                                        const FrameRange& relRange);
+    //! @brief Removes keys within relRange and adds keys of the segments
+    void replaceKeysWithSegments(const FrameRange& relRange,
+                                 const QVector<FittedSegment>& segments,
+                                 const bool action);
+
     void saveQrealSVG(SvgExporter& exp,
                       QDomElement& parent,
                       const FrameRange& visRange,
@@ -182,6 +226,9 @@ public:
                       const QString& templ = "%1");
 private:
     qreal calculateBaseValueAtRelFrame(const qreal frame) const;
+    //! @param keepCurrentValue Keep the current value if it differs
+    //! from the keys on the current frame
+    void updateBaseValueSnapshot(const bool keepCurrentValue = false);
     void startBaseValueTransform();
     void finishBaseValueTransform();
     bool updateExpressionRelFrame();
@@ -194,6 +241,10 @@ private:
                             const bool action,
                             const qreal accuracy);
 
+    //! @brief Only accessed through std::atomic_load/atomic_store
+    BaseValueSnapshot mCurve;
+    bool mCurveHasFrameValue = false;
+
     bool mGraphMinMaxValuesFixed = false;
     bool mTransformed = false;
 
@@ -0,0 +1,171 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "qrealcurve.h"
+#include "qrealkey.h"
+#include "simplemath.h"
+
+#include <algorithm>
+
+QrealCurve::QrealCurve(const qreal value,
+                       const qreal clampMin, const qreal clampMax) :
+    mValue(value), mClampMin(clampMin), mClampMax(clampMax) {}
+
+void QrealCurve::appendKey(const QrealKey * const key) {
+    appendKey(key->getC0Frame(), key->getC0Value(),
+              key->getRelFrame(), key->getValue(),
+              key->getC1Frame(), key->getC1Value());
+}
+
+void QrealCurve::appendKey(const qreal c0Frame, const qreal c0Value,
+                           const qreal frame, const qreal value,
+                           const qreal c1Frame, const qreal c1Value) {
+    if(mKeyCount == 0) {
+        mFirstFrame = frame;
+        mFirstValue = value;
+    } else {
+        Segment seg;
+        const qreal f0 = mLastFrame;
+        const qreal f1 = mPrevC1Frame;
+        const qreal f2 = c0Frame;
+        const qreal f3 = frame;
+        seg.fStartFrame = f0;
+        seg.fEndFrame = f3;
+        seg.fFC = 3*(f1 - f0);
+        seg.fFB = 3*(f2 - 2*f1 + f0);
+        seg.fFA = f3 - 3*f2 + 3*f1 - f0;
+
+        const qreal v0 = mLastValue;
+        const qreal v1 = mPrevC1Value;
+        const qreal v2 = c0Value;
+        const qreal v3 = value;
+        seg.fStartValue = v0;
+        seg.fEndValue = v3;
+        seg.fVC = 3*(v1 - v0);
+        seg.fVB = 3*(v2 - 2*v1 + v0);
+        seg.fVA = v3 - 3*v2 + 3*v1 - v0;
+
+        for(int i = 0; i <= sTableIntervals; i++) {
+            seg.fFrames[i] = seg.frameAtT(qreal(i)/sTableIntervals);
+        }
+        mSegments.push_back(seg);
+    }
+    mLastFrame = frame;
+    mLastValue = value;
+    mPrevC1Frame = c1Frame;
+    mPrevC1Value = c1Value;
+    mKeyCount++;
+}
+
+void QrealCurve::setFrameValue(const qreal relFrame, const qreal value) {
+    mHasFrameValue = true;
+    mFrameValueFrame = relFrame;
+    mFrameValue = value;
+}
+
+bool QrealCurve::isFrameValueAt(const qreal relFrame) const {
+    return mHasFrameValue && isZero4Dec(relFrame - mFrameValueFrame);
+}
+
+qreal QrealCurve::valueAtFrame(const qreal relFrame,
+                               int* const segmentHint) const {
+    if(isFrameValueAt(relFrame)) return mFrameValue;
+    if(mKeyCount == 0) return mValue;
+    int localHint = 0;
+    int& hint = segmentHint ? *segmentHint : localHint;
+    return qBound(mClampMin, keysValueAtFrame(relFrame, hint), mClampMax);
+}
+
+void QrealCurve::valuesAtFrames(const qreal* const relFrames,
+                                qreal* const values,
+                                const int count) const {
+    if(mKeyCount == 0) {
+        std::fill(values, values + count, mValue);
+        return;
+    }
+    int hint = 0;
+    for(int i = 0; i < count; i++) {
+        const qreal value = keysValueAtFrame(relFrames[i], hint);
+        values[i] = qBound(mClampMin, value, mClampMax);
+    }
+    if(!mHasFrameValue) return;
+    for(int i = 0; i < count; i++) {
+        if(isFrameValueAt(relFrames[i])) values[i] = mFrameValue;
+    }
+}
+
+qreal QrealCurve::keysValueAtFrame(const qreal relFrame,
+                                   int& segmentHint) const {
+    if(relFrame <= mFirstFrame) return mFirstValue;
+    if(relFrame >= mLastFrame) return mLastValue;
+    const int id = segmentId(relFrame, segmentHint);
+    return mSegments[static_cast<size_t>(id)].valueAtFrame(relFrame);
+}
+
+int QrealCurve::segmentId(const qreal relFrame, int& segmentHint) const {
+    const int count = static_cast<int>(mSegments.size());
+    const int last = qBound(0, segmentHint, count - 1);
+    const auto inSegment = [this, relFrame](const int id) {
+        const auto& seg = mSegments[static_cast<size_t>(id)];
+        return relFrame >= seg.fStartFrame && relFrame < seg.fEndFrame;
+    };
+    if(inSegment(last)) return last;
+    if(last + 1 < count && inSegment(last + 1)) {
+        segmentHint = last + 1;
+        return segmentHint;
+    }
+    int minId = 0;
+    int maxId = count - 1;
+    while(minId < maxId) {
+        const int midId = (minId + maxId + 1)/2;
+        const auto& mid = mSegments[static_cast<size_t>(midId)];
+        if(mid.fStartFrame > relFrame) maxId = midId - 1;
+        else minId = midId;
+    }
+    segmentHint = minId;
+    return minId;
+}
+
+qreal QrealCurve::Segment::tAtFrame(const qreal frame) const {
+    int i = 0;
+    while(i < sTableIntervals - 1 && fFrames[i + 1] <= frame) i++;
+    const qreal iFrame0 = fFrames[i];
+    const qreal iFrame1 = fFrames[i + 1];
+    qreal minT = qreal(i)/sTableIntervals;
+    qreal maxT = qreal(i + 1)/sTableIntervals;
+    const qreal span = iFrame1 - iFrame0;
+    qreal t = span > 0 ? minT + (frame - iFrame0)/span*(maxT - minT) :
+                         minT;
+    for(int j = 0; j < 16; j++) {
+        const qreal diff = frameAtT(t) - frame;
+        if(qAbs(diff) < 0.0001) break;
+        if(diff > 0) maxT = t;
+        else minT = t;
+        const qreal deriv = frameDerivativeAtT(t);
+        qreal newT = deriv > 0 ? t - diff/deriv : -1;
+        // fall back to bisection when Newton leaves the bracket
+        if(newT <= minT || newT >= maxT) newT = 0.5*(minT + maxT);
+        t = newT;
+    }
+    return t;
+}
+
+qreal QrealCurve::Segment::valueAtFrame(const qreal frame) const {
+    if(frame <= fStartFrame) return fStartValue;
+    if(frame >= fEndFrame) return fEndValue;
+    return valueAtT(tAtFrame(frame));
+}
@@ -0,0 +1,107 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef QREALCURVE_H
+#define QREALCURVE_H
+#include "../core_global.h"
+
+#include <QtGlobal>
+#include <vector>
+
+class QrealKey;
+
+//! @brief Keys of a QrealAnimator compiled for fast evaluation.
+//! Every key pair stores the polynomial coefficients of its segment
+//! and a small table of frames sampled at uniform t,
+//! used as a starting guess for Newton-Raphson refinement.
+//! Once built the curve is not modified, evaluation is const and
+//! re-entrant, so a shared curve can be evaluated from any thread.
+class CORE_EXPORT QrealCurve {
+    //! @brief Number of table intervals for the t lookup
+    static const int sTableIntervals = 8;
+
+    struct Segment {
+        qreal fStartFrame;
+        qreal fEndFrame;
+        qreal fStartValue;
+        qreal fEndValue;
+        // frame(t) = ((fFA*t + fFB)*t + fFC)*t + fStartFrame
+        qreal fFA;
+        qreal fFB;
+        qreal fFC;
+        // value(t) = ((fVA*t + fVB)*t + fVC)*t + fStartValue
+        qreal fVA;
+        qreal fVB;
+        qreal fVC;
+        qreal fFrames[sTableIntervals + 1];
+
+        qreal frameAtT(const qreal t) const
+        { return ((fFA*t + fFB)*t + fFC)*t + fStartFrame; }
+        qreal frameDerivativeAtT(const qreal t) const
+        { return (3*fFA*t + 2*fFB)*t + fFC; }
+        qreal valueAtT(const qreal t) const
+        { return ((fVA*t + fVB)*t + fVC)*t + fStartValue; }
+
+        qreal tAtFrame(const qreal frame) const;
+        qreal valueAtFrame(const qreal frame) const;
+    };
+public:
+    //! @param value Value used when no keys are appended
+    QrealCurve(const qreal value, const qreal clampMin, const qreal clampMax);
+    QrealCurve(const QrealCurve&) = delete;
+    QrealCurve& operator=(const QrealCurve&) = delete;
+
+    void appendKey(const QrealKey * const key);
+    void appendKey(const qreal c0Frame, const qreal c0Value,
+                   const qreal frame, const qreal value,
+                   const qreal c1Frame, const qreal c1Value);
+
+    //! @brief Value at relFrame replacing the keys value,
+    //! used for a value changed without a key on the current frame
+    void setFrameValue(const qreal relFrame, const qreal value);
+
+    //! @brief Clamped value at relFrame.
+    //! @param segmentHint Optional caller owned lookup hint,
+    //! speeds up evaluation of monotonically changing frames.
+    qreal valueAtFrame(const qreal relFrame,
+                       int* const segmentHint = nullptr) const;
+    //! @brief Batch version of valueAtFrame,
+    //! sorted relFrames are evaluated in a single pass over the segments
+    void valuesAtFrames(const qreal* const relFrames,
+                        qreal* const values, const int count) const;
+private:
+    qreal keysValueAtFrame(const qreal relFrame, int& segmentHint) const;
+    int segmentId(const qreal relFrame, int& segmentHint) const;
+    bool isFrameValueAt(const qreal relFrame) const;
+
+    const qreal mValue;
+    const qreal mClampMin;
+    const qreal mClampMax;
+    qreal mFirstFrame = 0;
+    qreal mFirstValue = 0;
+    qreal mLastFrame = 0;
+    qreal mLastValue = 0;
+    int mKeyCount = 0;
+    bool mHasFrameValue = false;
+    qreal mFrameValueFrame = 0;
+    qreal mFrameValue = 0;
+    qreal mPrevC1Frame = 0;
+    qreal mPrevC1Value = 0;
+    std::vector<Segment> mSegments;
+};
+
+#endif // QREALCURVE_H
@@ -135,6 +135,7 @@ BoundingBox *BoundingBox::sGetBoxByDocumentId(const int documentId) {
 void BoundingBox::prp_afterChangedAbsRange(const FrameRange &range, const bool clip) {
     const auto croppedRange = clip ? prp_absInfluenceRange()*range : range;
     StaticComplexAnimator::prp_afterChangedAbsRange(croppedRange, clip);
+    if(croppedRange.isValid()) mMotionBlurSamples.clear();
     if(croppedRange.inRange(anim_getCurrentAbsFrame())) {
         planUpdate(UpdateReason::userChange);
     }
@@ -469,6 +470,7 @@ void BoundingBox::planUpdate(const UpdateReason reason) {
     if(reason == UpdateReason::userChange) {
         mStateId++;
         mRenderDataHandler.clear();
+        mMotionBlurSamples.clear();
     }
 
     mDrawRenderContainer.setExpired(true);
@@ -492,6 +494,18 @@ stdsptr<BoxRenderData> BoundingBox::queExternalRender(
     return renderData;
 }
 
+stdsptr<BoxRenderData> BoundingBox::queMotionBlurSample(const qreal relFrame) {
+    const auto scene = getParentScene();
+    if(!scene) return nullptr;
+    if(scene->isSettingUpPreview()) return queExternalRender(relFrame, true);
+    const auto cached = mMotionBlurSamples.getSample(
+                relFrame, mStateId, scene->getResolution());
+    if(cached) return cached;
+    const auto sample = queExternalRender(relFrame, true);
+    if(sample) mMotionBlurSamples.addSample(sample);
+    return sample;
+}
+
 stdsptr<BoxRenderData> BoundingBox::queRender(const qreal relFrame) {
     const auto renderData = updateCurrentRenderData(relFrame);
     if(!renderData) return nullptr;
@@ -793,7 +807,7 @@ void BoundingBox::setupWithoutRasterEffects(const qreal relFrame,
     data->fRelTransform = getRelativeTransformAtFrame(relFrame);
     data->fInheritedTransform = getInheritedTransformAtFrame(relFrame);
     data->fTotalTransform = getTotalTransformAtFrame(relFrame);
-    data->fResolution = scene->getResolution();
+    data->fResolution = scene->getRenderResolution();
     data->fResolutionScale.reset();
     data->fResolutionScale.scale(data->fResolution, data->fResolution);
     data->fOpacity = mTransformAnimator->getOpacity(relFrame);
@@ -910,20 +924,14 @@ void BoundingBox::removeRasterEffect(const qsptr<RasterEffect> &effect) {
 //}
 
 QMatrix BoundingBox::getRelativeTransformAtFrame(const qreal relFrame) {
-    if(isZero6Dec(relFrame - anim_getCurrentRelFrame()))
-        return mTransformAnimator->getRelativeTransform();
     return mTransformAnimator->getRelativeTransformAtFrame(relFrame);
 }
 
 QMatrix BoundingBox::getInheritedTransformAtFrame(const qreal relFrame) {
-    if(isZero6Dec(relFrame - anim_getCurrentRelFrame()))
-        return mTransformAnimator->getInheritedTransform();
     return mTransformAnimator->getInheritedTransformAtFrame(relFrame);
 }
 
 QMatrix BoundingBox::getTotalTransformAtFrame(const qreal relFrame) {
-    if(isZero6Dec(relFrame - anim_getCurrentRelFrame()))
-        return mTransformAnimator->getTotalTransform();
     return mTransformAnimator->getTotalTransformAtFrame(relFrame);
 }
 
@@ -21,6 +21,7 @@
 #include "boxrendercontainer.h"
 #include "skia/skiaincludes.h"
 #include "renderdatahandler.h"
+#include "motionblursamplecache.h"
 #include "smartPointers/ememory.h"
 #include "colorhelpers.h"
 #include "MovablePoints/segment.h"
@@ -260,6 +261,9 @@ public:
     stdsptr<BoxRenderData> queRender(const qreal relFrame);
     stdsptr<BoxRenderData> queExternalRender(
             const qreal relFrame, const bool forceRasterize);
+    //! @brief Rasterized render data at relFrame for motion blur,
+    //! reuses samples already requested by neighbouring frames.
+    stdsptr<BoxRenderData> queMotionBlurSample(const qreal relFrame);
 
     void setupWithoutRasterEffects(const qreal relFrame,
                                    BoxRenderData * const data,
@@ -437,6 +441,7 @@ protected:
     eBoxType mType;
 
     RenderDataHandler mRenderDataHandler;
+    MotionBlurSampleCache mMotionBlurSamples;
 
     const qsptr<CustomProperties> mCustomProperties;
     const qsptr<BlendEffectCollection> mBlendEffectCollection;
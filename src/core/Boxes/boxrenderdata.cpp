@@ -155,17 +155,18 @@ void BoxRenderData::process() {
 }
 
 void BoxRenderData::beforeProcessing(const Hardware hw) {
-    Q_UNUSED(hw)
     Q_ASSERT(mStep != Step::EFFECTS);
+    mEffectsRenderer.plan(hw);
     setupRenderData();
     if(!mDataSet) dataSet();
     if(isZero4Dec(fOpacity)) finishedProcessing();
 }
 
 void BoxRenderData::afterProcessing() {
-    if(fMotionBlurTarget) {
-        fMotionBlurTarget->fOtherGlobalRects << fGlobalRect;
+    for(const auto& target : fMotionBlurTargets) {
+        if(target) target->fOtherGlobalRects << fGlobalRect;
     }
+    fMotionBlurTargets.clear();
     if(fParentBox && fParentIsTarget) {
         fParentBox->renderDataFinished(this);
     } else if(mCopySource) {
@@ -194,11 +195,13 @@ void BoxRenderData::queTaskNow() {
 }
 
 bool BoxRenderData::nextStep() {
+    if(!TaskScheduler::sGpuAvailable()) mEffectsRenderer.skipGpuOnly();
     const bool result = !mEffectsRenderer.isEmpty() &&
                         fRenderedImage;
     if(result) {
         mStep = Step::EFFECTS;
-        if(hardwareSupport() == HardwareSupport::cpuOnly) {
+        if(hardwareSupport() == HardwareSupport::cpuOnly ||
+           !TaskScheduler::sGpuAvailable()) {
             mEffectsRenderer.processCpu(this);
         } else {
             GpuTaskExecutor::sAddTask(ref<eTask>());
@@ -214,7 +217,7 @@ void BoxRenderData::dataSet() {
         fRelBoundingRectSet = true;
         updateRelBoundingRect();
     }
-    if(!fParentBox || !fParentIsTarget) return;
+    if(!fParentBox || !fParentIsTarget || fPreview) return;
     fParentBox->updateCurrentPreviewDataFromRenderData(this);
 }
 
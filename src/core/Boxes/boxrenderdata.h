@@ -98,7 +98,7 @@ public:
     qreal fRelFrame;
 
     // for motion blur
-    stdptr<BoxRenderData> fMotionBlurTarget;
+    QList<stdptr<BoxRenderData>> fMotionBlurTargets;
     // for motion blur
 
     SkBlendMode fBlendMode = SkBlendMode::kSrcOver;
@@ -107,6 +107,9 @@ public:
     bool fUseRenderTransform = false;
 
     bool fParentIsTarget = true;
+    //! @brief Low resolution progressive preview,
+    //! never cached nor used as the current preview data
+    bool fPreview = false;
     qptr<BoundingBox> fParentBox;
     BoundingBox* fBlendEffectIdentifier;
     sk_sp<SkImage> fRenderedImage;
@@ -886,8 +886,14 @@ void processChildData(BoundingBox * const child,
         }
         return;
     }
-    auto boxRenderData = child->getCurrentRenderData(childRelFrame);
-    if(!boxRenderData) boxRenderData = child->queRender(childRelFrame);
+    stdsptr<BoxRenderData> boxRenderData;
+    const auto scene = child->getParentScene();
+    if(scene && scene->isSettingUpPreview()) {
+        boxRenderData = child->queExternalRender(childRelFrame, false);
+    } else {
+        boxRenderData = child->getCurrentRenderData(childRelFrame);
+        if(!boxRenderData) boxRenderData = child->queRender(childRelFrame);
+    }
     if(!boxRenderData) return;
     boxRenderData->addDependent(parentData);
     ChildRenderData cData = boxRenderData;
@@ -18,6 +18,8 @@
 #include "boxrenderdata.h"
 #include "RasterEffects/rastereffectcaller.h"
 #include "gpurendertools.h"
+#include "Private/Tasks/taskscheduler.h"
+#include "Private/Tasks/taskque.h"
 
 void EffectsRenderer::processGpu(QGL33 * const gl,
                                  SwitchableContext &context,
@@ -33,7 +35,7 @@ void EffectsRenderer::processGpu(QGL33 * const gl,
     GpuRenderTools renderTools(gl, context, srcImage, boxData->fGlobalRect);
     while(mCurrentId < mEffects.count()) {
         const auto& effect = mEffects.at(mCurrentId);
-        if(effect->hardwareSupport() == HardwareSupport::cpuOnly) break;
+        if(plannedHardware(mCurrentId) == Hardware::cpu) break;
         effect->processGpu(gl, renderTools);
         mCurrentId++;
     }
@@ -43,6 +45,7 @@ void EffectsRenderer::processGpu(QGL33 * const gl,
 
 #include "effectsubtaskspawner.h"
 void EffectsRenderer::processCpu(BoxRenderData * const boxData) {
+    Q_ASSERT(plannedHardware(mCurrentId) == Hardware::cpu);
     const auto& effect = mEffects.at(mCurrentId++);
 
     Q_ASSERT(effect->hardwareSupport() != HardwareSupport::gpuOnly);
@@ -61,7 +64,100 @@ void EffectsRenderer::setBaseGlobalRect(SkIRect &currRect,
     }
 }
 
+void EffectsRenderer::skipGpuOnly() {
+    while(!isEmpty()) {
+        const auto& effect = mEffects.at(mCurrentId);
+        if(effect->hardwareSupport() != HardwareSupport::gpuOnly) break;
+        mCurrentId++;
+    }
+}
+
 HardwareSupport EffectsRenderer::nextHardwareSupport() const {
     Q_ASSERT(!isEmpty());
-    return mEffects.at(mCurrentId)->hardwareSupport();
+    if(mPlan.isEmpty()) return mEffects.at(mCurrentId)->hardwareSupport();
+    return plannedHardware(mCurrentId) == Hardware::gpu ?
+                HardwareSupport::gpuOnly : HardwareSupport::cpuOnly;
+}
+
+Hardware EffectsRenderer::plannedHardware(const int id) const {
+    if(id < mPlan.count()) return mPlan.at(id);
+    const auto hwSupport = mEffects.at(id)->hardwareSupport();
+    return hwSupport == HardwareSupport::cpuOnly ? Hardware::cpu :
+                                                   Hardware::gpu;
+}
+
+// Cost of moving the image between the CPU and the GPU memory
+// is the unit, running an effect on the device it is not queued for
+// costs as much as a single transfer, unless forced by the user setting.
+static const qreal sTransferCost = 1;
+static const qreal sNotPreferredCost = 1;
+static const qreal sNotForcedCost = 4;
+static const qreal sUnsupportedCost = 1000;
+
+static void sEffectCosts(const HardwareSupport hwSupport,
+                         qreal& cpuCost, qreal& gpuCost) {
+    cpuCost = 0;
+    gpuCost = 0;
+    if(!TaskScheduler::sGpuAvailable()) {
+        if(hwSupport == HardwareSupport::gpuOnly) cpuCost = sUnsupportedCost;
+        else gpuCost = sUnsupportedCost;
+        return;
+    }
+    switch(TaskQue::sQueFor(hwSupport)) {
+        case HardwareSupport::gpuOnly:
+            cpuCost = hwSupport == HardwareSupport::gpuOnly ?
+                        sUnsupportedCost : sNotForcedCost;
+            break;
+        case HardwareSupport::gpuPreffered:
+            cpuCost = sNotPreferredCost;
+            break;
+        case HardwareSupport::cpuPreffered:
+            gpuCost = sNotPreferredCost;
+            break;
+        case HardwareSupport::cpuOnly:
+            gpuCost = hwSupport == HardwareSupport::cpuOnly ?
+                        sUnsupportedCost : sNotForcedCost;
+            break;
+    }
+}
+
+void EffectsRenderer::plan(const Hardware startHw) {
+    mPlan.clear();
+    const int count = mEffects.count();
+    if(count == 0) return;
+    // cheapest chain cost ending on the cpu/gpu after each effect,
+    // and whether the device was switched right before it
+    QVector<qreal> cpuCost(count), gpuCost(count);
+    QVector<bool> cpuSwitch(count), gpuSwitch(count);
+    qreal prevCpu = startHw == Hardware::gpu ? sTransferCost : 0;
+    qreal prevGpu = startHw == Hardware::gpu ? 0 : sTransferCost;
+    for(int i = 0; i < count; i++) {
+        qreal effectCpu;
+        qreal effectGpu;
+        sEffectCosts(mEffects.at(i)->hardwareSupport(), effectCpu, effectGpu);
+
+        const qreal cpuFromGpu = prevGpu + sTransferCost;
+        cpuSwitch[i] = cpuFromGpu < prevCpu;
+        cpuCost[i] = effectCpu + (cpuSwitch[i] ? cpuFromGpu : prevCpu);
+
+        const qreal gpuFromCpu = prevCpu + sTransferCost;
+        gpuSwitch[i] = gpuFromCpu < prevGpu;
+        gpuCost[i] = effectGpu + (gpuSwitch[i] ? gpuFromCpu : prevGpu);
+
+        prevCpu = cpuCost[i];
+        prevGpu = gpuCost[i];
+    }
+    // the final image is always read back to the cpu memory
+    Hardware hw = prevGpu + sTransferCost < prevCpu ? Hardware::gpu :
+                                                      Hardware::cpu;
+    mPlan.reserve(count);
+    for(int i = 0; i < count; i++) mPlan << hw;
+    for(int i = count - 1; i >= 0; i--) {
+        mPlan[i] = hw;
+        const bool switched = hw == Hardware::gpu ? gpuSwitch[i] :
+                                                    cpuSwitch[i];
+        if(switched) {
+            hw = hw == Hardware::gpu ? Hardware::cpu : Hardware::gpu;
+        }
+    }
 }
@@ -40,8 +40,19 @@ public:
                            const SkIRect& skMaxBounds) const;
 
     HardwareSupport nextHardwareSupport() const;
+
+    //! @brief Skips effects that can only be processed on the GPU
+    void skipGpuOnly();
+
+    //! @brief Assigns hardware to every effect in the chain,
+    //! minimizing transfers between the CPU and the GPU memory.
+    //! @param startHw Hardware the box image is rendered with
+    void plan(const Hardware startHw);
 private:
+    Hardware plannedHardware(const int id) const;
+
     int mCurrentId = 0;
     QList<stdsptr<RasterEffectCaller>> mEffects;
+    QList<Hardware> mPlan;
 };
 #endif // EFFECTSRENDERER_H
@@ -35,10 +35,12 @@ private:
     void spawn();
     void splitSpawn(CpuRenderData& data,
                     const SkIRect& rect,
-                    const int nSplits);
+                    const int nSplits,
+                    const CpuTileSplit split);
 
     const bool mUseDst;
     int mRemaining = 0;
+    int mPass = 0;
     const stdsptr<RasterEffectCaller> mEffectCaller;
     const stdsptr<BoxRenderData> mData;
     SkBitmap mSrcBitmap;
@@ -59,7 +61,8 @@ void EffectSubTaskSpawner_priv::initialize() {
 
 void EffectSubTaskSpawner_priv::splitSpawn(CpuRenderData& data,
                                            const SkIRect& rect,
-                                           const int nSplits) {
+                                           const int nSplits,
+                                           const CpuTileSplit split) {
     if(nSplits == 0) return;
     if(nSplits == 1) {
         data.fTexTile = rect;
@@ -81,27 +84,29 @@ void EffectSubTaskSpawner_priv::splitSpawn(CpuRenderData& data,
 
     const int splits1 = nSplits/2;
     const int splits2 = nSplits - splits1;
-    const bool splitWidth = rect.width() > rect.height();
+    const bool splitWidth = split == CpuTileSplit::any ?
+                rect.width() > rect.height() :
+                split == CpuTileSplit::columns;
     if(splitWidth) {
         const int width1 = rect.width()*splits1/nSplits;
         const auto rect1 = SkIRect::MakeXYWH(rect.x(), rect.y(),
                                              width1, rect.height());
-        splitSpawn(data, rect1, splits1);
+        splitSpawn(data, rect1, splits1, split);
 
         //const int width2 = rect.width() - width1;
         const auto rect2 = SkIRect::MakeLTRB(rect1.right(), rect.top(),
                                              rect.right(), rect.bottom());
-        splitSpawn(data, rect2, splits2);
+        splitSpawn(data, rect2, splits2, split);
     } else {
         const int height1 = rect.height()*splits1/nSplits;
         const auto rect1 = SkIRect::MakeXYWH(rect.x(), rect.y(),
                                              rect.width(), height1);
-        splitSpawn(data, rect1, splits1);
+        splitSpawn(data, rect1, splits1, split);
 
         //const int height2 = rect.height() - height1;
         const auto rect2 = SkIRect::MakeLTRB(rect.left(), rect1.bottom(),
                                              rect.right(), rect.bottom());
-        splitSpawn(data, rect2, splits2);
+        splitSpawn(data, rect2, splits2, split);
     }
 }
 
@@ -120,13 +125,17 @@ void EffectSubTaskSpawner_priv::spawn() {
     data.fPos = mData->fGlobalRect.topLeft();
     data.fWidth = static_cast<uint>(srcWidth);
     data.fHeight = static_cast<uint>(srcHeight);
+    data.fPass = mPass;
 
-    splitSpawn(data, srcImage->bounds(), nThreads);
+    mEffectCaller->setupCpuPass(data);
+    const auto split = mEffectCaller->cpuTileSplit(mPass);
+    splitSpawn(data, srcImage->bounds(), nThreads, split);
 }
 
 void EffectSubTaskSpawner_priv::decRemaining_k() {
     if(--mRemaining > 0) return;
     if(mData->getState() != eTaskState::canceled) {
+        if(++mPass < mEffectCaller->cpuPasses()) return spawn();
         if(mUseDst) {
             mData->fRenderedImage = SkiaHelpers::transferDataToSkImage(
                                         mDstBitmap);
@@ -0,0 +1,64 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "motionblursamplecache.h"
+
+MotionBlurSampleContainer::MotionBlurSampleContainer(
+        const int key, const stdsptr<BoxRenderData>& sample,
+        MotionBlurSampleCache * const parent) :
+    mKey(key), mSample(sample), mParent(parent) {}
+
+int MotionBlurSampleContainer::getByteCount() {
+    const auto& img = mSample->fRenderedImage;
+    if(!img) return 0;
+    const auto& info = img->imageInfo();
+    return info.width()*info.height()*info.bytesPerPixel();
+}
+
+void MotionBlurSampleContainer::noDataLeft_k() {
+    mParent->removeKey(mKey);
+}
+
+stdsptr<BoxRenderData> MotionBlurSampleCache::getSample(
+        const qreal relFrame, const uint stateId, const qreal resolution) {
+    const int key = sFrameToKey(relFrame);
+    const auto it = mSamples.find(key);
+    if(it == mSamples.end()) return nullptr;
+    const auto& cont = it->second;
+    const auto& sample = cont->sample();
+    const bool valid = sample->fBoxStateId == stateId &&
+                       isZero4Dec(sample->fResolution - resolution) &&
+                       sample->getState() != eTaskState::canceled;
+    if(!valid) {
+        mSamples.erase(it);
+        return nullptr;
+    }
+    cont->sampleUsed();
+    return sample;
+}
+
+void MotionBlurSampleCache::addSample(const stdsptr<BoxRenderData>& sample) {
+    const int key = sFrameToKey(sample->fRelFrame);
+    const auto cont = enve::make_shared<MotionBlurSampleContainer>(
+                key, sample, this);
+    mSamples.erase(key);
+    mSamples.insert({key, cont});
+}
+
+void MotionBlurSampleCache::removeKey(const int key) {
+    mSamples.erase(key);
+}
@@ -0,0 +1,71 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef MOTIONBLURSAMPLECACHE_H
+#define MOTIONBLURSAMPLECACHE_H
+#include "boxrenderdata.h"
+#include "CacheHandlers/cachecontainer.h"
+#include <map>
+
+class MotionBlurSampleCache;
+
+//! @brief Keeps a single motion blur sample alive under memory management.
+class CORE_EXPORT MotionBlurSampleContainer : public CacheContainer {
+    e_OBJECT
+protected:
+    MotionBlurSampleContainer(const int key,
+                              const stdsptr<BoxRenderData>& sample,
+                              MotionBlurSampleCache * const parent);
+public:
+    int getByteCount();
+
+    const stdsptr<BoxRenderData>& sample() const { return mSample; }
+    void sampleUsed() { updateInMemoryManagment(); }
+protected:
+    void noDataLeft_k();
+private:
+    const int mKey;
+    const stdsptr<BoxRenderData> mSample;
+    MotionBlurSampleCache * const mParent;
+};
+
+//! @brief Sub-frame render data of a box keyed by relative frame.
+//! Lets consecutive output frames share motion blur samples,
+//! stale samples are released by MemoryDataHandler.
+class CORE_EXPORT MotionBlurSampleCache {
+    friend class MotionBlurSampleContainer;
+public:
+    void clear() { mSamples.clear(); }
+
+    //! @brief Returns a rendered or still processing sample at relFrame,
+    //! nullptr if none is cached for the given state and resolution.
+    stdsptr<BoxRenderData> getSample(const qreal relFrame,
+                                     const uint stateId,
+                                     const qreal resolution);
+    void addSample(const stdsptr<BoxRenderData>& sample);
+
+private:
+    void removeKey(const int key);
+
+    static int sFrameToKey(const qreal frame) {
+        return qRound(frame*1000);
+    }
+
+    std::map<int, stdsptr<MotionBlurSampleContainer>> mSamples;
+};
+
+#endif // MOTIONBLURSAMPLECACHE_H
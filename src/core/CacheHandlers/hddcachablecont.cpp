@@ -25,7 +25,7 @@ HddCachableCont::~HddCachableCont() {
 int HddCachableCont::free_RAM_k() {
     const int bytes = clearMemory();
     setDataInMemory(false);
-    if(!mTmpFile && !mTmpSaveTask) noDataLeft_k();
+    if(!mTmpFile && !mTmpSaveTask && !storesCompressedData()) noDataLeft_k();
     return bytes;
 }
 
@@ -47,7 +47,12 @@ eTask *HddCachableCont::scheduleSaveToTmpFile() {
 eTask *HddCachableCont::scheduleLoadFromTmpFile() {
     if(storesDataInMemory()) return nullptr;
     if(mTmpLoadTask) return mTmpLoadTask.get();
-    if(!mTmpSaveTask && !mTmpFile) return nullptr;
+    if(!mTmpSaveTask && !mTmpFile) {
+        if(!storesCompressedData()) return nullptr;
+        mTmpLoadTask = createCompressedDataLoader();
+        mTmpLoadTask->queTask();
+        return mTmpLoadTask.get();
+    }
 
     mTmpLoadTask = createTmpFileDataLoader();
     if(mTmpSaveTask)
@@ -26,6 +26,12 @@ protected:
     virtual int clearMemory() = 0;
     virtual stdsptr<eHddTask> createTmpFileDataSaver() = 0;
     virtual stdsptr<eHddTask> createTmpFileDataLoader() = 0;
+
+    //! @brief Whether the data can be restored without a tmp file,
+    //! from a compressed copy kept in memory
+    virtual bool storesCompressedData() const { return false; }
+    //! @brief Restores the data from its compressed copy
+    virtual stdsptr<eTask> createCompressedDataLoader() { return nullptr; }
 public:
     ~HddCachableCont();
 
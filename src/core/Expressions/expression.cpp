@@ -17,6 +17,29 @@
 #include "expression.h"
 
 #include "exceptions.h"
+#include "jsenginepool.h"
+
+#include <QVarLengthArray>
+#include <QElapsedTimer>
+
+class Expression::StatsRecorder {
+public:
+    StatsRecorder(Expression& expression, const int count = 1) :
+        mExpression(expression), mCount(count) {
+        mTimer.start();
+    }
+
+    ~StatsRecorder() {
+        mExpression.mEvaluationCount += mCount;
+        mExpression.mEvaluationNsecs += mTimer.nsecsElapsed();
+    }
+private:
+    Expression& mExpression;
+    const int mCount;
+    QElapsedTimer mTimer;
+};
+
+static std::atomic<quint64> sNextId{0};
 
 Expression::ResultTester Expression::sQrealAnimatorTester =
         [](const QJSValue& val) {
@@ -26,55 +49,67 @@ Expression::ResultTester Expression::sQrealAnimatorTester =
 Expression::Expression(const QString& definitionsStr,
                        const QString& scriptStr,
                        PropertyBindingMap&& bindings,
-                       std::unique_ptr<QJSEngine>&& engine,
-                       QJSValue&& eEvaluate) :
+                       std::unique_ptr<NativeExpression>&& native) :
     mDefinitionsStr(definitionsStr),
     mScriptStr(scriptStr),
-    mEEvaluate(std::move(eEvaluate)),
     mBindings(std::move(bindings)),
-    mEngine(std::move(engine)) {
+    mNative(std::move(native)),
+    mId(sNextId++),
+    mSource(sScriptSource(definitionsStr, scriptStr, mBindings)) {
     for(const auto& binding : mBindings) {
         connect(binding.second.get(), &PropertyBinding::currentValueChanged,
                 this, &Expression::currentValueChanged);
         connect(binding.second.get(), &PropertyBinding::relRangeChanged,
                 this, &Expression::relRangeChanged);
+        connect(binding.second.get(), &PropertyBinding::dependenciesChanged,
+                this, &Expression::dependenciesChanged);
     }
 }
 
+Expression::~Expression() {
+    JSEnginePool::sReleaseInstance(mId);
+}
+
 
-void throwIfError(const QJSValue& value, const QString& name) {
+void throwIfError(const QJSValue& value, const QString& name,
+                  const int lineOffset = 0) {
     if(value.isError()) {
+        const int line = value.property("lineNumber").toInt() - lineOffset;
         PrettyRuntimeThrow("Uncaught exception in " + name + " at line "
-                           + value.property("lineNumber").toString() +
+                           + QString::number(line) +
                            ":\n" + value.toString());
     }
 }
 
-void Expression::sAddDefinitionsTo(const QString& definitionsStr,
-                                   QJSEngine& e) {
-    const auto defRet = e.evaluate(definitionsStr);
+void Expression::sValidateDefinitions(const QString& definitionsStr) {
+    auto& e = JSEnginePool::sEngine();
+    // definitions are evaluated in a function scope,
+    // not to leak into the shared global scope
+    const auto defs = e.evaluate("(function() {" + definitionsStr + "\n})");
+    throwIfError(defs, "Definitions");
+    const auto defRet = defs.call();
     throwIfError(defRet, "Definitions");
 }
 
-void Expression::sAddScriptTo(const QString& scriptStr,
-                              const PropertyBindingMap& bindings,
-                              QJSEngine& e, QJSValue& eEvaluate,
-                              const ResultTester& resultTester) {
-    QStringList bindingVars;
+void Expression::sValidateScript(const QString& definitionsStr,
+                                 const QString& scriptStr,
+                                 const PropertyBindingMap& bindings,
+                                 const ResultTester& resultTester) {
+    auto& e = JSEnginePool::sEngine();
+    // evaluated outside of the pool caches,
+    // the test call should not affect the state of any expression
+    const auto source = sScriptSource(definitionsStr, scriptStr, bindings);
+    const auto eFactory = e.evaluate(source);
+    // the script starts after the definitions and the function header line
+    throwIfError(eFactory, "Script", definitionsStr.count('\n') + 1);
+    const auto eEvaluate = eFactory.call();
+    throwIfError(eEvaluate, "Definitions");
+    if(!eEvaluate.isCallable())
+        PrettyRuntimeThrow("Uncallable script.");
     QJSValueList testArgs;
     for(const auto& binding : bindings) {
-        bindingVars << binding.first;
         testArgs << binding.second->getJSValue(e);
     }
-    const QString evalVars = bindingVars.join(", ");
-    eEvaluate = e.evaluate(
-            "var eEvaluate;"
-            "eEvaluate = function(" + evalVars + ") {" +
-                scriptStr +
-            "}");
-    throwIfError(eEvaluate, "Script");
-    if(!eEvaluate.isCallable())
-        PrettyRuntimeThrow("Uncallable script.");
     const auto testResult = eEvaluate.call(testArgs);
     if(testResult.isError()) {
         PrettyRuntimeThrow("Script test error:\n" +
@@ -89,37 +124,105 @@ qsptr<Expression> Expression::sCreate(const QString& bindingsStr,
                                       const ResultTester& resultTester) {
     auto bindings = PropertyBindingParser::parseBindings(
                               bindingsStr, nullptr, context);
-    auto engine = std::make_unique<QJSEngine>();
-    sAddDefinitionsTo(definitionsStr, *engine);
-    QJSValue eEvaluate;
-    sAddScriptTo(scriptStr, bindings, *engine, eEvaluate, resultTester);
-    return sCreate(definitionsStr, scriptStr,
-                   std::move(bindings),
-                   std::move(engine),
-                   std::move(eEvaluate));
+    auto native = sCompileNative(definitionsStr, scriptStr, bindings);
+    // native scripts only run with numeric binding values,
+    // otherwise the script is evaluated in JS and has to be validated
+    if(!native || !sNumericBindings(bindings)) {
+        sValidateDefinitions(definitionsStr);
+        sValidateScript(definitionsStr, scriptStr, bindings, resultTester);
+    }
+    return qsptr<Expression>(new Expression(definitionsStr, scriptStr,
+                                            std::move(bindings),
+                                            std::move(native)));
 }
 
 qsptr<Expression> Expression::sCreate(const QString& definitionsStr,
                                       const QString& scriptStr,
-                                      PropertyBindingMap&& bindings,
-                                      std::unique_ptr<QJSEngine>&& engine,
-                                      QJSValue&& eEvaluate) {
-    if(!eEvaluate.isCallable())
-        RuntimeThrow("Uncallable script:\n" + scriptStr);
+                                      PropertyBindingMap&& bindings) {
+    auto native = sCompileNative(definitionsStr, scriptStr, bindings);
     return qsptr<Expression>(new Expression(definitionsStr, scriptStr,
                                             std::move(bindings),
-                                            std::move(engine),
-                                            std::move(eEvaluate)));
+                                            std::move(native)));
+}
+
+bool Expression::sNumericBindings(const PropertyBindingMap& bindings) {
+    for(const auto& binding : bindings) {
+        qreal value;
+        if(!binding.second->getNumber(value)) return false;
+    }
+    return true;
+}
+
+std::unique_ptr<NativeExpression> Expression::sCompileNative(
+        const QString& definitionsStr,
+        const QString& scriptStr,
+        const PropertyBindingMap& bindings) {
+    QStringList bindingVars;
+    for(const auto& binding : bindings) {
+        bindingVars << binding.first;
+    }
+    return NativeExpression::sCompile(definitionsStr, scriptStr,
+                                      bindingVars);
+}
+
+QString Expression::sScriptSource(const QString& definitionsStr,
+                                  const QString& scriptStr,
+                                  const PropertyBindingMap& bindings) {
+    QStringList bindingVars;
+    for(const auto& binding : bindings) {
+        bindingVars << binding.first;
+    }
+    const QString evalVars = bindingVars.join(", ");
+    return "(function() {" + definitionsStr + "\n"
+               "return function(" + evalVars + ") {" +
+                   scriptStr +
+               "\n};"
+           "})";
+}
+
+QJSValue Expression::scriptFunction() const {
+    return JSEnginePool::sInstance(mId, mSource);
+}
+
+bool Expression::evaluateNative(qreal& result) {
+    if(!mNative) return false;
+    QVarLengthArray<qreal, 8> values;
+    for(const auto& binding : mBindings) {
+        qreal value;
+        if(!binding.second->getNumber(value)) return false;
+        values.append(value);
+    }
+    result = mNative->evaluate(values.constData());
+    return true;
+}
+
+bool Expression::evaluateNative(const qreal relFrame, qreal& result) {
+    if(!mNative) return false;
+    QVarLengthArray<qreal, 8> values;
+    for(const auto& binding : mBindings) {
+        qreal value;
+        if(!binding.second->getNumber(value, relFrame)) return false;
+        values.append(value);
+    }
+    result = mNative->evaluate(values.constData());
+    return true;
 }
 
 bool Expression::setAbsFrame(const int absFrame) {
     bool changed = false;
     for(const auto& binding : mBindings) {
-        changed = changed || binding.second->setAbsFrame(absFrame);
+        // every binding needs the new frame, do not short-circuit
+        const bool bindingChanged = binding.second->setAbsFrame(absFrame);
+        changed = changed || bindingChanged;
     }
     return changed;
 }
 
+void Expression::resetEvaluationStats() {
+    mEvaluationCount = 0;
+    mEvaluationNsecs = 0;
+}
+
 bool Expression::isStatic() const {
     return identicalRelRange(0) == FrameRange::EMINMAX;
 }
@@ -140,20 +243,81 @@ bool Expression::dependsOn(const Property* const prop) {
     return false;
 }
 
+QList<Property*> Expression::boundProperties() const {
+    QList<Property*> result;
+    for(const auto& binding : mBindings) {
+        const auto prop = binding.second->getBindProperty();
+        if(prop) result << prop;
+    }
+    return result;
+}
+
 QJSValue Expression::evaluate() {
+    const StatsRecorder stats(*this);
+    qreal result;
+    if(evaluateNative(result)) return result;
+    const auto eEvaluate = scriptFunction();
+    if(!eEvaluate.isCallable()) return QJSValue();
+    auto& e = JSEnginePool::sEngine();
     QJSValueList values;
     for(const auto& binding : mBindings) {
-        values << binding.second->getJSValue(*mEngine);
+        values << binding.second->getJSValue(e);
     }
-    return mEEvaluate.call(values);
+    return eEvaluate.call(values);
 }
 
 QJSValue Expression::evaluate(const qreal relFrame) {
+    const StatsRecorder stats(*this);
+    qreal result;
+    if(evaluateNative(relFrame, result)) return result;
+    const auto eEvaluate = scriptFunction();
+    if(!eEvaluate.isCallable()) return QJSValue();
+    auto& e = JSEnginePool::sEngine();
     QJSValueList values;
     for(const auto& binding : mBindings) {
-        values << binding.second->getJSValue(*mEngine, relFrame);
+        values << binding.second->getJSValue(e, relFrame);
+    }
+    return eEvaluate.call(values);
+}
+
+QJSValueList Expression::evaluate(const QVector<qreal>& relFrames) {
+    const int count = relFrames.count();
+    const StatsRecorder stats(*this, count);
+    QJSValueList results;
+    results.reserve(count);
+    for(const qreal relFrame : relFrames) {
+        qreal result;
+        if(!evaluateNative(relFrame, result)) break;
+        results << result;
+    }
+    if(results.count() == count) return results;
+    results.clear();
+
+    const auto eEvaluate = scriptFunction();
+    const auto eBatchEvaluate = JSEnginePool::sCompiled(
+            "(function(f, args) {"
+                "var n = args.length;"
+                "var r = new Array(n);"
+                "for(var i = 0; i < n; i++) r[i] = f.apply(null, args[i]);"
+                "return r;"
+            "})");
+    auto& e = JSEnginePool::sEngine();
+    auto args = e.newArray(static_cast<uint>(count));
+    for(int i = 0; i < count; i++) {
+        const qreal relFrame = relFrames.at(i);
+        auto iArgs = e.newArray(static_cast<uint>(mBindings.size()));
+        quint32 j = 0;
+        for(const auto& binding : mBindings) {
+            iArgs.setProperty(j++, binding.second->getJSValue(e, relFrame));
+        }
+        args.setProperty(static_cast<quint32>(i), iArgs);
+    }
+    const auto ret = eEvaluate.isCallable() ?
+                eBatchEvaluate.call({eEvaluate, args}) : QJSValue();
+    for(int i = 0; i < count; i++) {
+        results << ret.property(static_cast<quint32>(i));
     }
-    return mEEvaluate.call(values);
+    return results;
 }
 
 FrameRange Expression::identicalRelRange(const int absFrame) const {
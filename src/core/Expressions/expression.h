@@ -19,29 +19,32 @@
 
 #include <QObject>
 #include <QJSEngine>
+#include <atomic>
 
 #include "propertybindingparser.h"
+#include "nativeexpression.h"
 
 class CORE_EXPORT Expression : public QObject {
     Q_OBJECT
     Expression(const QString& definitionsStr,
                const QString& scriptStr,
                PropertyBindingMap&& bindings,
-               std::unique_ptr<QJSEngine>&& engine,
-               QJSValue&& eEvaluate);
+               std::unique_ptr<NativeExpression>&& native);
 public:
-    static void sAddDefinitionsTo(const QString& definitionsStr,
-                                  QJSEngine& e);
+    ~Expression();
+
+    //! @brief Throws if the definitions fail to evaluate
+    static void sValidateDefinitions(const QString& definitionsStr);
     using ResultTester = std::function<void(const QJSValue&)>;
-    static void sAddScriptTo(const QString& scriptStr,
-                             const PropertyBindingMap& bindings,
-                             QJSEngine& e, QJSValue& eEvaluate,
-                             const ResultTester& resultTester);
+    //! @brief Throws if the script fails to compile or to run
+    //! with the current binding values
+    static void sValidateScript(const QString& definitionsStr,
+                                const QString& scriptStr,
+                                const PropertyBindingMap& bindings,
+                                const ResultTester& resultTester);
     static qsptr<Expression> sCreate(const QString& definitionsStr,
                                      const QString& scriptStr,
-                                     PropertyBindingMap&& bindings,
-                                     std::unique_ptr<QJSEngine>&& engine,
-                                     QJSValue&& eEvaluate);
+                                     PropertyBindingMap&& bindings);
     static qsptr<Expression> sCreate(const QString& bindingsStr,
                                      const QString& definitionsStr,
                                      const QString& scriptStr,
@@ -53,11 +56,19 @@ public:
     bool setAbsFrame(const int absFrame);
 
     bool isStatic() const;
+    bool isNative() const { return mNative.get(); }
     bool isValid();
     bool dependsOn(const Property* const prop);
+    //! @brief Properties read by the bindings
+    QList<Property*> boundProperties() const;
 
     QJSValue evaluate();
     QJSValue evaluate(const qreal relFrame);
+    //! @brief Evaluates the script for all relFrames,
+    //! non-native scripts are run with a single call into the engine.
+    //! Expressions are evaluated in the calling thread's JSEnginePool
+    //! engine and can be used from any thread.
+    QJSValueList evaluate(const QVector<qreal>& relFrames);
 
     int nextDifferentRelFrame(const int absFrame) const
     { return identicalRelRange(absFrame).adjusted(0, 1).fMax; }
@@ -66,19 +77,54 @@ public:
     FrameRange identicalRelRange(const int absFrame) const;
     FrameRange nextNonUnaryIdenticalRelRange(const int absFrame) const;
 
+    //! @brief Number of evaluations since the last stats reset
+    int evaluationCount() const { return mEvaluationCount; }
+    //! @brief Total time spent evaluating since the last stats reset
+    qint64 evaluationNsecs() const { return mEvaluationNsecs; }
+    void resetEvaluationStats();
+
     QString bindingsString() const;
     const QString& definitionsString() const { return mDefinitionsStr; }
     const QString& scriptString() const { return mScriptStr; }
 signals:
     void relRangeChanged(const FrameRange& range);
     void currentValueChanged();
+    void dependenciesChanged();
 private:
+    class StatsRecorder;
+
+    //! @brief Returns false if any binding value is not a number
+    static bool sNumericBindings(const PropertyBindingMap& bindings);
+    static std::unique_ptr<NativeExpression> sCompileNative(
+            const QString& definitionsStr,
+            const QString& scriptStr,
+            const PropertyBindingMap& bindings);
+    //! @brief Source of a function that evaluates the definitions
+    //! and returns the script function
+    static QString sScriptSource(const QString& definitionsStr,
+                                 const QString& scriptStr,
+                                 const PropertyBindingMap& bindings);
+
+    //! @brief Script function of this expression in the calling thread,
+    //! its definitions state is not shared with other expressions
+    QJSValue scriptFunction() const;
+
+    bool evaluateNative(qreal& result);
+    bool evaluateNative(const qreal relFrame, qreal& result);
+
     const QString mDefinitionsStr;
     const QString mScriptStr;
 
-    QJSValue mEEvaluate;
     const PropertyBindingMap mBindings;
-    const std::unique_ptr<QJSEngine> mEngine;
+    const std::unique_ptr<NativeExpression> mNative;
+    //! @brief Unique key of the script function instances in JSEnginePool
+    const quint64 mId;
+    //! @brief Source of the function creating the script function,
+    //! used only if the script can not be evaluated natively
+    const QString mSource;
+
+    std::atomic<int> mEvaluationCount{0};
+    std::atomic<qint64> mEvaluationNsecs{0};
 };
 
 #endif // EXPRESSION_H
@@ -0,0 +1,203 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "expressiongraph.h"
+
+#include "Animators/qrealanimator.h"
+#include "Animators/complexanimator.h"
+#include "expression.h"
+
+#include <QDebug>
+#include <deque>
+
+std::vector<ExpressionGraph::Node> ExpressionGraph::sNodes;
+QHash<const QrealAnimator*, int> ExpressionGraph::sIds;
+bool ExpressionGraph::sOrderValid = true;
+bool ExpressionGraph::sUpdating = false;
+int ExpressionGraph::sBatchDepth = 0;
+int ExpressionGraph::sDirtyCount = 0;
+int ExpressionGraph::sCycles = 0;
+
+ExpressionGraph::Batch::Batch() {
+    sBatchDepth++;
+}
+
+ExpressionGraph::Batch::~Batch() {
+    if(--sBatchDepth == 0) sUpdate();
+}
+
+void ExpressionGraph::sAddNode(QrealAnimator* const node) {
+    if(sIds.contains(node)) return sUpdateDependencies(node);
+    sIds.insert(node, static_cast<int>(sNodes.size()));
+    sNodes.push_back({node, sDependencies(node), {}, true});
+    sDirtyCount++;
+    sOrderValid = false;
+}
+
+void ExpressionGraph::sRemoveNode(QrealAnimator* const node) {
+    const auto it = sIds.find(node);
+    if(it == sIds.end()) return;
+    const int id = it.value();
+    if(sNodes[static_cast<size_t>(id)].fDirty) sDirtyCount--;
+    sNodes.erase(sNodes.begin() + id);
+    sIds.erase(it);
+    for(auto& nodeId : sIds) {
+        if(nodeId > id) nodeId--;
+    }
+    sOrderValid = false;
+}
+
+void ExpressionGraph::sUpdateDependencies(QrealAnimator* const node) {
+    const auto it = sIds.constFind(node);
+    if(it == sIds.constEnd()) return;
+    auto& graphNode = sNodes[static_cast<size_t>(it.value())];
+    graphNode.fDependencies = sDependencies(node);
+    sOrderValid = false;
+}
+
+std::vector<qptr<QrealAnimator>> ExpressionGraph::sDependencies(
+        const QrealAnimator* const node) {
+    std::vector<qptr<QrealAnimator>> result;
+    const auto expression = node->getExpression();
+    if(!expression) return result;
+    for(const auto prop : expression->boundProperties()) {
+        if(const auto qa = enve_cast<QrealAnimator*>(prop)) {
+            result.push_back(qa);
+        } else if(const auto ca = enve_cast<ComplexAnimator*>(prop)) {
+            ca->ca_execOnDescendants([&result](Property* const desc) {
+                if(const auto qa = enve_cast<QrealAnimator*>(desc)) {
+                    result.push_back(qa);
+                }
+            });
+        }
+    }
+    return result;
+}
+
+void ExpressionGraph::sMarkDirty(QrealAnimator* const node) {
+    const auto it = sIds.constFind(node);
+    if(it == sIds.constEnd()) return;
+    auto& graphNode = sNodes[static_cast<size_t>(it.value())];
+    if(!graphNode.fDirty) {
+        graphNode.fDirty = true;
+        sDirtyCount++;
+    }
+    if(sBatchDepth == 0) sUpdate();
+}
+
+void ExpressionGraph::sUpdate() {
+    // nodes marked while updating are handled by the running update
+    if(sUpdating || sDirtyCount == 0) return;
+    sUpdating = true;
+    // more than one pass is only needed with cycles
+    // or if the graph changes during evaluation
+    const int maxPasses = 4;
+    for(int pass = 0; pass < maxPasses && sDirtyCount > 0; pass++) {
+        if(!sOrderValid) sSort();
+        for(size_t i = 0; i < sNodes.size(); i++) {
+            if(!sNodes[i].fDirty) continue;
+            sNodes[i].fDirty = false;
+            sDirtyCount--;
+            const auto animator = sNodes[i].fAnimator;
+            const bool changed = animator->updateCurrentEffectiveValue();
+            if(!sOrderValid) break;
+            if(!changed) continue;
+            for(const int depId : sNodes[i].fDependents) {
+                auto& dep = sNodes[static_cast<size_t>(depId)];
+                if(dep.fDirty) continue;
+                dep.fDirty = true;
+                sDirtyCount++;
+            }
+        }
+    }
+    if(sDirtyCount > 0) {
+        qWarning() << "Expression dependencies did not settle";
+        for(auto& node : sNodes) node.fDirty = false;
+        sDirtyCount = 0;
+    }
+    sUpdating = false;
+}
+
+int ExpressionGraph::sCycleCount() {
+    if(!sOrderValid) sSort();
+    return sCycles;
+}
+
+void ExpressionGraph::sSort() {
+    const int count = static_cast<int>(sNodes.size());
+    std::vector<std::vector<int>> dependents(static_cast<size_t>(count));
+    std::vector<int> inDegree(static_cast<size_t>(count), 0);
+    for(int i = 0; i < count; i++) {
+        const auto& node = sNodes[static_cast<size_t>(i)];
+        for(const auto& dependency : node.fDependencies) {
+            if(!dependency) continue;
+            const auto it = sIds.constFind(dependency);
+            if(it == sIds.constEnd()) continue;
+            const int j = it.value();
+            if(i == j) continue;
+            auto& jDependents = dependents[static_cast<size_t>(j)];
+            // a node can be read through several bindings
+            if(!jDependents.empty() && jDependents.back() == i) continue;
+            jDependents.push_back(i);
+            inDegree[static_cast<size_t>(i)]++;
+        }
+    }
+
+    std::vector<int> order;
+    order.reserve(static_cast<size_t>(count));
+    std::deque<int> ready;
+    for(int i = 0; i < count; i++) {
+        if(inDegree[static_cast<size_t>(i)] == 0) ready.push_back(i);
+    }
+    while(!ready.empty()) {
+        const int id = ready.front();
+        ready.pop_front();
+        order.push_back(id);
+        for(const int depId : dependents[static_cast<size_t>(id)]) {
+            if(--inDegree[static_cast<size_t>(depId)] == 0)
+                ready.push_back(depId);
+        }
+    }
+    sCycles = count - static_cast<int>(order.size());
+    if(sCycles > 0) {
+        qWarning() << sCycles << "expressions are part of a dependency cycle";
+        for(int i = 0; i < count; i++) {
+            if(inDegree[static_cast<size_t>(i)] > 0) order.push_back(i);
+        }
+    }
+
+    std::vector<int> newIds(static_cast<size_t>(count));
+    for(int i = 0; i < count; i++) {
+        newIds[static_cast<size_t>(order[static_cast<size_t>(i)])] = i;
+    }
+    std::vector<Node> nodes;
+    nodes.reserve(static_cast<size_t>(count));
+    for(const int oldId : order) {
+        auto node = sNodes[static_cast<size_t>(oldId)];
+        node.fDependents.clear();
+        for(const int depId : dependents[static_cast<size_t>(oldId)]) {
+            node.fDependents.push_back(newIds[static_cast<size_t>(depId)]);
+        }
+        nodes.push_back(node);
+    }
+    sNodes = std::move(nodes);
+    sIds.clear();
+    for(int i = 0; i < count; i++) {
+        sIds.insert(sNodes[static_cast<size_t>(i)].fAnimator, i);
+    }
+    sOrderValid = true;
+}
@@ -0,0 +1,81 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef EXPRESSIONGRAPH_H
+#define EXPRESSIONGRAPH_H
+
+#include "../core_global.h"
+#include "../smartPointers/ememory.h"
+
+#include <QHash>
+#include <vector>
+
+class QrealAnimator;
+
+//! @brief Dependency graph of animators driven by expressions.
+//! Changes only mark nodes dirty, dirty nodes are then evaluated once each
+//! in topological order, so a chain of bound expressions is settled in a
+//! single pass. Nodes that changed value mark their dependents dirty.
+//! Main thread only.
+class CORE_EXPORT ExpressionGraph {
+public:
+    //! @brief Defers evaluation of dirty nodes until the outermost
+    //! batch is destroyed, e.g. for the duration of a frame change.
+    class Batch {
+    public:
+        Batch();
+        ~Batch();
+    };
+
+    //! @brief Adds the node, or updates its dependencies if already added
+    static void sAddNode(QrealAnimator* const node);
+    static void sRemoveNode(QrealAnimator* const node);
+    //! @brief Call when expression bindings of the node changed target
+    static void sUpdateDependencies(QrealAnimator* const node);
+
+    //! @brief Evaluates the node now, or at the end of the current batch
+    static void sMarkDirty(QrealAnimator* const node);
+
+    //! @brief Evaluates all dirty nodes, even inside a batch
+    static void sUpdate();
+
+    //! @brief Number of nodes that are part of a dependency cycle
+    static int sCycleCount();
+private:
+    struct Node {
+        QrealAnimator* fAnimator;
+        //! @brief Animators read by the node expression bindings,
+        //! only those that are nodes themselves become edges
+        std::vector<qptr<QrealAnimator>> fDependencies;
+        std::vector<int> fDependents;
+        bool fDirty;
+    };
+
+    static std::vector<qptr<QrealAnimator>> sDependencies(
+            const QrealAnimator* const node);
+    static void sSort();
+
+    static std::vector<Node> sNodes;
+    static QHash<const QrealAnimator*, int> sIds;
+    static bool sOrderValid;
+    static bool sUpdating;
+    static int sBatchDepth;
+    static int sDirtyCount;
+    static int sCycles;
+};
+
+#endif // EXPRESSIONGRAPH_H
@@ -35,6 +35,17 @@ QJSValue FrameBinding::getJSValue(QJSEngine& e, const qreal relFrame) {
     return this->relFrame();
 }
 
+bool FrameBinding::getNumber(qreal& value) {
+    value = relFrame();
+    return true;
+}
+
+bool FrameBinding::getNumber(qreal& value, const qreal relFrame) {
+    Q_UNUSED(relFrame)
+    value = this->relFrame();
+    return true;
+}
+
 FrameRange FrameBinding::identicalRelRange(const int absFrame) {
     if(mContext) {
         const int relFrame = mContext->prp_absFrameToRelFrame(absFrame);
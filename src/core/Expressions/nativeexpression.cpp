@@ -0,0 +1,614 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "nativeexpression.h"
+
+#include <QVarLengthArray>
+#include <QMap>
+#include <QSet>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+enum class TokenType { number, identifier, symbol, end };
+
+struct Token {
+    TokenType fType;
+    QString fText;
+    qreal fValue;
+    int fLine;
+};
+
+bool isIdentifierStart(const QChar c) {
+    return c.isLetter() || c == '_' || c == '$';
+}
+
+bool isIdentifierPart(const QChar c) {
+    return isIdentifierStart(c) || c.isDigit();
+}
+
+bool tokenize(const QString& src, QList<Token>& tokens) {
+    static const QStringList sSymbols{
+        "===", "!==", "==", "!=", "<=", ">=", "&&", "||",
+        "++", "--", "**", "+=", "-=", "*=", "/=", "%=", "=>", "<<", ">>"
+    };
+    static const QString sSingle = "+-*/%(),;<>!?:.=";
+    int line = 1;
+    int i = 0;
+    const int len = src.length();
+    while(i < len) {
+        const QChar c = src.at(i);
+        const QChar next = i + 1 < len ? src.at(i + 1) : QChar();
+        if(c == '\n') {
+            line++;
+            i++;
+        } else if(c.isSpace()) {
+            i++;
+        } else if(c == '/' && next == '/') {
+            while(i < len && src.at(i) != '\n') i++;
+        } else if(c == '/' && next == '*') {
+            i += 2;
+            while(i < len && !(src.at(i) == '*' && i + 1 < len &&
+                               src.at(i + 1) == '/')) {
+                if(src.at(i) == '\n') line++;
+                i++;
+            }
+            if(i >= len) return false;
+            i += 2;
+        } else if(c.isDigit() || (c == '.' && next.isDigit())) {
+            const int start = i;
+            if(c == '0' && (next == 'x' || next == 'X' ||
+                            next == 'o' || next == 'O' ||
+                            next == 'b' || next == 'B')) return false;
+            while(i < len && src.at(i).isDigit()) i++;
+            if(i < len && src.at(i) == '.') {
+                i++;
+                while(i < len && src.at(i).isDigit()) i++;
+            }
+            if(i < len && (src.at(i) == 'e' || src.at(i) == 'E')) {
+                i++;
+                if(i < len && (src.at(i) == '+' || src.at(i) == '-')) i++;
+                if(i >= len || !src.at(i).isDigit()) return false;
+                while(i < len && src.at(i).isDigit()) i++;
+            }
+            if(i < len && isIdentifierPart(src.at(i))) return false;
+            bool ok;
+            const qreal value = src.mid(start, i - start).toDouble(&ok);
+            if(!ok) return false;
+            tokens.append({TokenType::number, QString(), value, line});
+        } else if(isIdentifierStart(c)) {
+            const int start = i;
+            while(i < len && isIdentifierPart(src.at(i))) i++;
+            tokens.append({TokenType::identifier, src.mid(start, i - start),
+                           0, line});
+        } else {
+            bool found = false;
+            for(const auto& sym : sSymbols) {
+                if(src.midRef(i, sym.length()) == sym) {
+                    tokens.append({TokenType::symbol, sym, 0, line});
+                    i += sym.length();
+                    found = true;
+                    break;
+                }
+            }
+            if(found) continue;
+            if(!sSingle.contains(c)) return false;
+            tokens.append({TokenType::symbol, QString(c), 0, line});
+            i++;
+        }
+    }
+    tokens.append({TokenType::end, QString(), 0, line});
+    return true;
+}
+
+qreal jsRound(const qreal x) {
+    const qreal r = std::floor(x);
+    return x - r >= 0.5 ? r + 1 : r;
+}
+
+qreal jsSign(const qreal x) {
+    if(x > 0) return 1;
+    if(x < 0) return -1;
+    return x;
+}
+
+qreal jsPow(const qreal x, const qreal y) {
+    if(std::isnan(y)) return y;
+    if(std::abs(x) == 1 && std::isinf(y))
+        return std::numeric_limits<qreal>::quiet_NaN();
+    return std::pow(x, y);
+}
+
+struct Func1 {
+    const char* fName;
+    qreal (*fFunc)(qreal);
+};
+
+const Func1 sFuncs1[] = {
+    {"abs", [](qreal x) { return std::abs(x); }},
+    {"acos", [](qreal x) { return std::acos(x); }},
+    {"acosh", [](qreal x) { return std::acosh(x); }},
+    {"asin", [](qreal x) { return std::asin(x); }},
+    {"asinh", [](qreal x) { return std::asinh(x); }},
+    {"atan", [](qreal x) { return std::atan(x); }},
+    {"atanh", [](qreal x) { return std::atanh(x); }},
+    {"cbrt", [](qreal x) { return std::cbrt(x); }},
+    {"ceil", [](qreal x) { return std::ceil(x); }},
+    {"cos", [](qreal x) { return std::cos(x); }},
+    {"cosh", [](qreal x) { return std::cosh(x); }},
+    {"exp", [](qreal x) { return std::exp(x); }},
+    {"expm1", [](qreal x) { return std::expm1(x); }},
+    {"floor", [](qreal x) { return std::floor(x); }},
+    {"log", [](qreal x) { return std::log(x); }},
+    {"log10", [](qreal x) { return std::log10(x); }},
+    {"log1p", [](qreal x) { return std::log1p(x); }},
+    {"log2", [](qreal x) { return std::log2(x); }},
+    {"round", &jsRound},
+    {"sign", &jsSign},
+    {"sin", [](qreal x) { return std::sin(x); }},
+    {"sinh", [](qreal x) { return std::sinh(x); }},
+    {"sqrt", [](qreal x) { return std::sqrt(x); }},
+    {"tan", [](qreal x) { return std::tan(x); }},
+    {"tanh", [](qreal x) { return std::tanh(x); }},
+    {"trunc", [](qreal x) { return std::trunc(x); }}
+};
+
+struct Func2 {
+    const char* fName;
+    qreal (*fFunc)(qreal, qreal);
+};
+
+const Func2 sFuncs2[] = {
+    {"atan2", [](qreal y, qreal x) { return std::atan2(y, x); }},
+    {"hypot", [](qreal x, qreal y) { return std::hypot(x, y); }},
+    {"pow", &jsPow}
+};
+
+struct Constant {
+    const char* fName;
+    qreal fValue;
+};
+
+const Constant sConstants[] = {
+    {"E", M_E}, {"LN10", M_LN10}, {"LN2", M_LN2},
+    {"LOG10E", M_LOG10E}, {"LOG2E", M_LOG2E}, {"PI", M_PI},
+    {"SQRT1_2", M_SQRT1_2}, {"SQRT2", M_SQRT2}
+};
+
+using Op = NativeExpression::Op;
+using Instruction = NativeExpression::Instruction;
+
+enum class ValueType { number, boolean };
+
+class Compiler {
+public:
+    Compiler(const QList<Token>& tokens, const QStringList& bindings) :
+        mTokens(tokens), mBindings(bindings) {}
+
+    bool compile();
+
+    std::vector<Instruction> fCode;
+    int fStackSize = 0;
+    int fLocalCount = 0;
+private:
+    const Token& peek() const { return mTokens.at(mPos); }
+
+    bool isSymbol(const char* const sym) const {
+        const auto& token = peek();
+        return token.fType == TokenType::symbol && token.fText == sym;
+    }
+
+    bool acceptSymbol(const char* const sym) {
+        if(!isSymbol(sym)) return false;
+        mPos++;
+        return true;
+    }
+
+    bool isKeyword(const char* const word) const {
+        const auto& token = peek();
+        return token.fType == TokenType::identifier && token.fText == word;
+    }
+
+    int emit(const Op op, const int stackChange,
+             const int arg = 0, const qreal value = 0) {
+        Instruction ins;
+        ins.fOp = op;
+        ins.fArg = arg;
+        ins.fValue = value;
+        fCode.push_back(ins);
+        mDepth += stackChange;
+        fStackSize = qMax(fStackSize, mDepth);
+        return static_cast<int>(fCode.size()) - 1;
+    }
+
+    void patchJump(const int id) {
+        fCode[static_cast<size_t>(id)].fArg = static_cast<int>(fCode.size());
+    }
+
+    bool declaration();
+    bool expression(ValueType& type);
+    bool logicalOr(ValueType& type);
+    bool logicalAnd(ValueType& type);
+    bool equality(ValueType& type);
+    bool relational(ValueType& type);
+    bool additive(ValueType& type);
+    bool multiplicative(ValueType& type);
+    bool unary(ValueType& type);
+    bool primary(ValueType& type);
+    bool mathMember(ValueType& type);
+
+    const QList<Token>& mTokens;
+    const QStringList& mBindings;
+    int mPos = 0;
+    int mDepth = 0;
+    QMap<QString, int> mLocals;
+    QMap<QString, ValueType> mLocalTypes;
+    //! @brief Names declared with let or const
+    QSet<QString> mLexicalLocals;
+};
+
+bool Compiler::compile() {
+    while(isKeyword("var") || isKeyword("let") || isKeyword("const")) {
+        if(!declaration()) return false;
+    }
+    if(!isKeyword("return")) return false;
+    const int returnLine = peek().fLine;
+    mPos++;
+    // a line break after return makes it return undefined
+    if(peek().fLine != returnLine) return false;
+    ValueType type;
+    if(!expression(type)) return false;
+    if(type != ValueType::number) return false;
+    acceptSymbol(";");
+    return peek().fType == TokenType::end;
+}
+
+bool Compiler::declaration() {
+    const bool var = isKeyword("var");
+    mPos++;
+    do {
+        const auto& nameToken = peek();
+        if(nameToken.fType != TokenType::identifier) return false;
+        const QString name = nameToken.fText;
+        mPos++;
+        if(!acceptSymbol("=")) return false;
+        ValueType type;
+        if(!expression(type)) return false;
+        // bindings are the script function parameters, redeclaring
+        // them or any let and const name is a syntax error in JS
+        if(!var && mBindings.contains(name)) return false;
+        if(mLexicalLocals.contains(name)) return false;
+        int id;
+        const auto it = mLocals.find(name);
+        if(it == mLocals.end()) {
+            id = fLocalCount++;
+            mLocals.insert(name, id);
+        } else {
+            if(!var) return false;
+            id = it.value();
+        }
+        if(!var) mLexicalLocals.insert(name);
+        mLocalTypes.insert(name, type);
+        emit(Op::store, -1, id);
+    } while(acceptSymbol(","));
+    acceptSymbol(";");
+    return true;
+}
+
+bool Compiler::expression(ValueType& type) {
+    ValueType condType;
+    if(!logicalOr(condType)) return false;
+    if(!acceptSymbol("?")) {
+        type = condType;
+        return true;
+    }
+    const int elseJump = emit(Op::jumpIfFalse, -1);
+    ValueType trueType;
+    if(!expression(trueType)) return false;
+    if(!acceptSymbol(":")) return false;
+    const int endJump = emit(Op::jump, 0);
+    mDepth--;
+    patchJump(elseJump);
+    ValueType falseType;
+    if(!expression(falseType)) return false;
+    patchJump(endJump);
+    if(trueType != falseType) return false;
+    type = trueType;
+    return true;
+}
+
+bool Compiler::logicalOr(ValueType& type) {
+    if(!logicalAnd(type)) return false;
+    while(acceptSymbol("||")) {
+        const int jump = emit(Op::jumpIfTrueKeep, -1);
+        ValueType rhsType;
+        if(!logicalAnd(rhsType)) return false;
+        if(rhsType != type) return false;
+        patchJump(jump);
+    }
+    return true;
+}
+
+bool Compiler::logicalAnd(ValueType& type) {
+    if(!equality(type)) return false;
+    while(acceptSymbol("&&")) {
+        const int jump = emit(Op::jumpIfFalseKeep, -1);
+        ValueType rhsType;
+        if(!equality(rhsType)) return false;
+        if(rhsType != type) return false;
+        patchJump(jump);
+    }
+    return true;
+}
+
+bool Compiler::equality(ValueType& type) {
+    if(!relational(type)) return false;
+    while(true) {
+        const bool strict = isSymbol("===") || isSymbol("!==");
+        const bool equal = isSymbol("===") || isSymbol("==");
+        if(!strict && !isSymbol("==") && !isSymbol("!=")) return true;
+        mPos++;
+        ValueType rhsType;
+        if(!relational(rhsType)) return false;
+        if(strict && rhsType != type) return false;
+        emit(equal ? Op::eq : Op::ne, -1);
+        type = ValueType::boolean;
+    }
+}
+
+bool Compiler::relational(ValueType& type) {
+    if(!additive(type)) return false;
+    while(true) {
+        Op op;
+        if(isSymbol("<")) op = Op::lt;
+        else if(isSymbol(">")) op = Op::gt;
+        else if(isSymbol("<=")) op = Op::le;
+        else if(isSymbol(">=")) op = Op::ge;
+        else return true;
+        mPos++;
+        ValueType rhsType;
+        if(!additive(rhsType)) return false;
+        emit(op, -1);
+        type = ValueType::boolean;
+    }
+}
+
+bool Compiler::additive(ValueType& type) {
+    if(!multiplicative(type)) return false;
+    while(true) {
+        Op op;
+        if(isSymbol("+")) op = Op::add;
+        else if(isSymbol("-")) op = Op::sub;
+        else return true;
+        mPos++;
+        ValueType rhsType;
+        if(!multiplicative(rhsType)) return false;
+        emit(op, -1);
+        type = ValueType::number;
+    }
+}
+
+bool Compiler::multiplicative(ValueType& type) {
+    if(!unary(type)) return false;
+    while(true) {
+        Op op;
+        if(isSymbol("*")) op = Op::mul;
+        else if(isSymbol("/")) op = Op::div;
+        else if(isSymbol("%")) op = Op::mod;
+        else return true;
+        mPos++;
+        ValueType rhsType;
+        if(!unary(rhsType)) return false;
+        emit(op, -1);
+        type = ValueType::number;
+    }
+}
+
+bool Compiler::unary(ValueType& type) {
+    if(acceptSymbol("-")) {
+        if(!unary(type)) return false;
+        emit(Op::neg, 0);
+        type = ValueType::number;
+        return true;
+    } else if(acceptSymbol("+")) {
+        if(!unary(type)) return false;
+        type = ValueType::number;
+        return true;
+    } else if(acceptSymbol("!")) {
+        if(!unary(type)) return false;
+        emit(Op::nott, 0);
+        type = ValueType::boolean;
+        return true;
+    }
+    return primary(type);
+}
+
+bool Compiler::primary(ValueType& type) {
+    const auto& token = peek();
+    if(token.fType == TokenType::number) {
+        mPos++;
+        emit(Op::constant, 1, 0, token.fValue);
+        type = ValueType::number;
+        return true;
+    } else if(acceptSymbol("(")) {
+        if(!expression(type)) return false;
+        return acceptSymbol(")");
+    } else if(token.fType != TokenType::identifier) return false;
+
+    const QString name = token.fText;
+    mPos++;
+    const auto localIt = mLocals.find(name);
+    const int bindingId = mBindings.indexOf(name);
+    if(localIt != mLocals.end()) {
+        emit(Op::local, 1, localIt.value());
+        type = mLocalTypes.value(name);
+    } else if(bindingId != -1) {
+        emit(Op::binding, 1, bindingId);
+        type = ValueType::number;
+    } else if(name == "Math") {
+        return mathMember(type);
+    } else if(name == "true" || name == "false") {
+        emit(Op::constant, 1, 0, name == "true" ? 1 : 0);
+        type = ValueType::boolean;
+    } else if(name == "NaN") {
+        emit(Op::constant, 1, 0, std::numeric_limits<qreal>::quiet_NaN());
+        type = ValueType::number;
+    } else if(name == "Infinity") {
+        emit(Op::constant, 1, 0, std::numeric_limits<qreal>::infinity());
+        type = ValueType::number;
+    } else return false;
+    // member access and calls on values need full JS
+    return !isSymbol(".") && !isSymbol("(");
+}
+
+bool Compiler::mathMember(ValueType& type) {
+    if(!acceptSymbol(".")) return false;
+    const auto& member = peek();
+    if(member.fType != TokenType::identifier) return false;
+    const QString name = member.fText;
+    mPos++;
+    type = ValueType::number;
+    if(!acceptSymbol("(")) {
+        for(const auto& constant : sConstants) {
+            if(name == constant.fName) {
+                emit(Op::constant, 1, 0, constant.fValue);
+                return true;
+            }
+        }
+        return false;
+    }
+    int argc = 0;
+    if(!acceptSymbol(")")) {
+        do {
+            ValueType argType;
+            if(!expression(argType)) return false;
+            argc++;
+        } while(acceptSymbol(","));
+        if(!acceptSymbol(")")) return false;
+    }
+    if(name == "min" || name == "max") {
+        emit(name == "min" ? Op::min : Op::max, 1 - argc, argc);
+        return true;
+    }
+    if(argc == 1) {
+        for(const auto& func : sFuncs1) {
+            if(name == func.fName) {
+                const int id = emit(Op::func1, 0);
+                fCode[static_cast<size_t>(id)].fFunc1 = func.fFunc;
+                return true;
+            }
+        }
+    } else if(argc == 2) {
+        for(const auto& func : sFuncs2) {
+            if(name == func.fName) {
+                const int id = emit(Op::func2, -1);
+                fCode[static_cast<size_t>(id)].fFunc2 = func.fFunc;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool isTruthy(const qreal value) {
+    return value != 0 && !std::isnan(value);
+}
+
+}
+
+std::unique_ptr<NativeExpression> NativeExpression::sCompile(
+        const QString& definitionsStr,
+        const QString& scriptStr,
+        const QStringList& bindings) {
+    if(!definitionsStr.trimmed().isEmpty()) return nullptr;
+    QList<Token> tokens;
+    if(!tokenize(scriptStr, tokens)) return nullptr;
+    Compiler compiler(tokens, bindings);
+    if(!compiler.compile()) return nullptr;
+    std::unique_ptr<NativeExpression> result(new NativeExpression);
+    result->mCode = std::move(compiler.fCode);
+    result->mStackSize = compiler.fStackSize;
+    result->mLocalCount = compiler.fLocalCount;
+    return result;
+}
+
+qreal NativeExpression::evaluate(const qreal* const bindings) const {
+    QVarLengthArray<qreal, 32> stack(mStackSize);
+    QVarLengthArray<qreal, 16> locals(mLocalCount);
+    int sp = 0;
+    const int codeSize = static_cast<int>(mCode.size());
+    for(int pc = 0; pc < codeSize; pc++) {
+        const auto& ins = mCode[static_cast<size_t>(pc)];
+        switch(ins.fOp) {
+        case Op::constant: stack[sp++] = ins.fValue; break;
+        case Op::binding: stack[sp++] = bindings[ins.fArg]; break;
+        case Op::local: stack[sp++] = locals[ins.fArg]; break;
+        case Op::store: locals[ins.fArg] = stack[--sp]; break;
+        case Op::neg: stack[sp - 1] = -stack[sp - 1]; break;
+        case Op::nott: stack[sp - 1] = isTruthy(stack[sp - 1]) ? 0 : 1; break;
+        case Op::add: sp--; stack[sp - 1] += stack[sp]; break;
+        case Op::sub: sp--; stack[sp - 1] -= stack[sp]; break;
+        case Op::mul: sp--; stack[sp - 1] *= stack[sp]; break;
+        case Op::div: sp--; stack[sp - 1] /= stack[sp]; break;
+        case Op::mod:
+            sp--;
+            stack[sp - 1] = std::fmod(stack[sp - 1], stack[sp]);
+            break;
+        case Op::lt: sp--; stack[sp - 1] = stack[sp - 1] < stack[sp]; break;
+        case Op::gt: sp--; stack[sp - 1] = stack[sp - 1] > stack[sp]; break;
+        case Op::le: sp--; stack[sp - 1] = stack[sp - 1] <= stack[sp]; break;
+        case Op::ge: sp--; stack[sp - 1] = stack[sp - 1] >= stack[sp]; break;
+        case Op::eq: sp--; stack[sp - 1] = stack[sp - 1] == stack[sp]; break;
+        case Op::ne: sp--; stack[sp - 1] = stack[sp - 1] != stack[sp]; break;
+        case Op::jump: pc = ins.fArg - 1; break;
+        case Op::jumpIfFalse:
+            if(!isTruthy(stack[--sp])) pc = ins.fArg - 1;
+            break;
+        case Op::jumpIfFalseKeep:
+            if(!isTruthy(stack[sp - 1])) pc = ins.fArg - 1;
+            else sp--;
+            break;
+        case Op::jumpIfTrueKeep:
+            if(isTruthy(stack[sp - 1])) pc = ins.fArg - 1;
+            else sp--;
+            break;
+        case Op::func1: stack[sp - 1] = ins.fFunc1(stack[sp - 1]); break;
+        case Op::func2:
+            sp--;
+            stack[sp - 1] = ins.fFunc2(stack[sp - 1], stack[sp]);
+            break;
+        case Op::min:
+        case Op::max: {
+            const bool min = ins.fOp == Op::min;
+            const qreal inf = std::numeric_limits<qreal>::infinity();
+            qreal result = min ? inf : -inf;
+            for(int i = sp - ins.fArg; i < sp; i++) {
+                const qreal value = stack[i];
+                if(std::isnan(value)) {
+                    result = value;
+                    break;
+                }
+                if(min ? value < result : value > result) result = value;
+            }
+            sp -= ins.fArg;
+            stack[sp++] = result;
+        } break;
+        }
+    }
+    return stack[sp - 1];
+}
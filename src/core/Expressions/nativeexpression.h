@@ -0,0 +1,68 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef NATIVEEXPRESSION_H
+#define NATIVEEXPRESSION_H
+
+#include "../core_global.h"
+
+#include <QStringList>
+#include <memory>
+#include <vector>
+
+//! @brief Expression scripts compiled to bytecode evaluated without JS.
+//! Supports scripts made only of local variable declarations and a return
+//! of a numeric expression using arithmetic, comparisons, logical
+//! operators, the conditional operator, Math functions and constants,
+//! and numeric bindings.
+class CORE_EXPORT NativeExpression {
+public:
+    enum class Op {
+        constant, binding, local, store,
+        neg, nott, add, sub, mul, div, mod,
+        lt, gt, le, ge, eq, ne,
+        jump, jumpIfFalse, jumpIfFalseKeep, jumpIfTrueKeep,
+        func1, func2, min, max
+    };
+
+    struct Instruction {
+        Op fOp;
+        int fArg = 0;
+        qreal fValue = 0;
+        qreal (*fFunc1)(qreal) = nullptr;
+        qreal (*fFunc2)(qreal, qreal) = nullptr;
+    };
+
+    //! @brief Returns nullptr if the script needs full JavaScript.
+    //! @param bindings Names of the script arguments, in argument order.
+    static std::unique_ptr<NativeExpression> sCompile(
+            const QString& definitionsStr,
+            const QString& scriptStr,
+            const QStringList& bindings);
+
+    //! @brief Evaluates the script with numeric binding values,
+    //! given in the order passed to sCompile.
+    qreal evaluate(const qreal* const bindings) const;
+private:
+    NativeExpression() {}
+
+    std::vector<Instruction> mCode;
+    int mStackSize = 0;
+    int mLocalCount = 0;
+};
+
+#endif // NATIVEEXPRESSION_H
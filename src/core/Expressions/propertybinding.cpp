@@ -74,6 +74,22 @@ QJSValue PropertyBinding::getJSValue(QJSEngine& e, const qreal relFrame) {
     else return QJSValue::NullValue;
 }
 
+bool PropertyBinding::getNumber(qreal& value) {
+    if(!mBindPathValid) return false;
+    const auto qa = enve_cast<QrealAnimator*>(mBindProperty.get());
+    if(!qa) return false;
+    value = qa->getEffectiveValue();
+    return true;
+}
+
+bool PropertyBinding::getNumber(qreal& value, const qreal relFrame) {
+    if(!mBindPathValid) return false;
+    const auto qa = enve_cast<QrealAnimator*>(mBindProperty.get());
+    if(!qa) return false;
+    value = qa->getEffectiveValue(relFrame);
+    return true;
+}
+
 bool PropertyBinding::dependsOn(const Property* const prop) {
     if(!mBindProperty) return false;
     return mBindProperty == prop || mBindProperty->prp_dependsOn(prop);
@@ -149,6 +165,7 @@ bool PropertyBinding::bindProperty(const QString& path, Property * const newBind
         conn << connect(newBinding, &Property::prp_pathChanged,
                         this, [this]() { pathChanged(); });
     }
+    emit dependenciesChanged();
     emit currentValueChanged();
     emit relRangeChanged(FrameRange::EMINMAX);
     return true;
@@ -157,6 +174,7 @@ bool PropertyBinding::bindProperty(const QString& path, Property * const newBind
 void PropertyBinding::setBindPathValid(const bool valid) {
     if(mBindPathValid == valid) return;
     mBindPathValid = valid;
+    emit dependenciesChanged();
     emit currentValueChanged();
     emit relRangeChanged(FrameRange::EMINMAX);
 }
@@ -43,6 +43,8 @@ public:
 
     QJSValue getJSValue(QJSEngine& e);
     QJSValue getJSValue(QJSEngine& e, const qreal relFrame);
+    bool getNumber(qreal& value);
+    bool getNumber(qreal& value, const qreal relFrame);
 
     FrameRange identicalRelRange(const int absFrame);
     FrameRange nextNonUnaryIdenticalRelRange(const int absFrame);
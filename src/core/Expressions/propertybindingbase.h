@@ -31,6 +31,17 @@ protected:
 public:
     virtual QJSValue getJSValue(QJSEngine& e) = 0;
     virtual QJSValue getJSValue(QJSEngine& e, const qreal relFrame) = 0;
+    //! @brief Value for native expression evaluation,
+    //! returns false if the value is not a number.
+    virtual bool getNumber(qreal& value) {
+        Q_UNUSED(value)
+        return false;
+    }
+    virtual bool getNumber(qreal& value, const qreal relFrame) {
+        Q_UNUSED(value)
+        Q_UNUSED(relFrame)
+        return false;
+    }
     virtual FrameRange identicalRelRange(const int absFrame) = 0;
     virtual FrameRange nextNonUnaryIdenticalRelRange(const int absFrame) = 0;
     virtual QString path() const = 0;
@@ -39,11 +50,15 @@ public:
         return false;
     }
     virtual bool isValid() const { return true; }
+    //! @brief Property the binding reads the value of, if any
+    virtual Property* getBindProperty() const { return nullptr; }
 
     bool setAbsFrame(const int absFrame);
 signals:
     void relRangeChanged(const FrameRange& range);
     void currentValueChanged();
+    //! @brief Emitted when the binding changed what it depends on
+    void dependenciesChanged();
 protected:
     qreal relFrame() const { return mRelFrame; }
 
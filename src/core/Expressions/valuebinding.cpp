@@ -16,6 +16,8 @@
 
 #include "valuebinding.h"
 
+#include "Animators/qrealanimator.h"
+
 ValueBinding::ValueBinding(const Property* const context) :
     PropertyBindingBase(context) {}
 
@@ -34,6 +36,20 @@ QJSValue ValueBinding::getJSValue(QJSEngine& e, const qreal relFrame) {
     else return QJSValue::NullValue;
 }
 
+bool ValueBinding::getNumber(qreal& value) {
+    const auto qa = enve_cast<const QrealAnimator*>(mContext.data());
+    if(!qa) return false;
+    value = qa->getCurrentBaseValue();
+    return true;
+}
+
+bool ValueBinding::getNumber(qreal& value, const qreal relFrame) {
+    const auto qa = enve_cast<const QrealAnimator*>(mContext.data());
+    if(!qa) return false;
+    value = qa->getBaseValue(relFrame);
+    return true;
+}
+
 FrameRange ValueBinding::identicalRelRange(const int absFrame) {
     Q_UNUSED(absFrame)
     return FrameRange::EMINMAX;
@@ -26,7 +26,7 @@ AnimatedSurface::AnimatedSurface() : Animator("canvas"),
         updateCurrent();
         if(!mUseRange.inRange(key->getRelFrame())) return;
         const auto asKey = static_cast<ASKey*>(key);
-        const auto dSurf = asKey->dSurface();
+        const auto& dSurf = asKey->dSurface();
         if(!dSurf.storesDataInMemory())
             asKey->dSurface().scheduleLoadFromTmpFile();
         mUsed.append(&asKey->dSurface());
@@ -64,14 +64,28 @@ void AnimatedSurface::setupOnionSkinFor(
 
 void AnimatedSurface::prp_readProperty(eReadStream& src) {
     Animator::prp_readProperty(src);
-    anim_readKeys(src);
-    mBaseValue->read(src);
+    TilePoolReader pool;
+    int nKeys; src >> nKeys;
+    if(nKeys < 0 || nKeys > 10000)
+        RuntimeThrow("Invalid key count " + std::to_string(nKeys));
+    for(int i = 0; i < nKeys; i++) {
+        const auto key = enve::make_shared<ASKey>(this);
+        key->readKey(src, pool);
+        anim_appendKey(key);
+    }
+    mBaseValue->read(src, pool);
 }
 
 void AnimatedSurface::prp_writeProperty(eWriteStream& dst) const {
     Animator::prp_writeProperty(dst);
-    anim_writeKeys(dst);
-    mBaseValue->write(dst);
+    // tiles identical across frames are stored only once
+    TilePoolWriter pool;
+    const auto& keys = anim_getKeys();
+    dst << keys.count();
+    for(const auto& key : keys) {
+        static_cast<ASKey*>(key)->writeKey(dst, pool);
+    }
+    mBaseValue->write(dst, pool);
 }
 
 void savePaintImageXEV(const QString& path, const XevExporter& exp,
@@ -82,6 +96,23 @@ void savePaintImageXEV(const QString& path, const XevExporter& exp,
     }, false);
 }
 
+//! @brief Saves the image once the surface data is loaded
+void scheduleSavePaintImageXEV(const QString& path, const XevExporter& exp,
+                               DrawableAutoTiledSurface& surf) {
+    const auto loadTask = surf.scheduleLoadFromTmpFile();
+    if(loadTask) {
+        const stdptr<DrawableAutoTiledSurface> surfPtr = &surf;
+        const auto expPtr = exp.ref<const XevExporter>();
+        const auto saveImage = [surfPtr, expPtr, path]() {
+            if(!surfPtr) return;
+            savePaintImageXEV(path, *expPtr, *surfPtr);
+        };
+        loadTask->addDependent({saveImage, nullptr});
+    } else {
+        savePaintImageXEV(path, exp, surf);
+    }
+}
+
 QDomElement AnimatedSurface::prp_writePropertyXEV_impl(const XevExporter& exp) const {
     auto result = exp.createElement("PaintSurface");
     if(anim_hasKeys()) {
@@ -98,18 +129,7 @@ QDomElement AnimatedSurface::prp_writePropertyXEV_impl(const XevExporter& exp) c
             const auto pivot = surf.zeroTilePos();
             pivots += QString("%1 %2").arg(pivot.x()).
                                        arg(pivot.y());
-            const auto loadTask = surf.scheduleLoadFromTmpFile();
-            if(loadTask) {
-                const stdptr<DrawableAutoTiledSurface> surfPtr = &surf;
-                const auto expPtr = exp.ref<const XevExporter>();
-                const auto saveImage = [surfPtr, expPtr, frameStr]() {
-                    if(!surfPtr) return;
-                    savePaintImageXEV(frameStr + ".png", *expPtr, *surfPtr);
-                };
-                loadTask->addDependent({saveImage, nullptr});
-            } else {
-                savePaintImageXEV(frameStr + ".png", exp, surf);
-            }
+            scheduleSavePaintImageXEV(frameStr + ".png", exp, surf);
         }
         result.setAttribute("frames", frames);
         result.setAttribute("pivots", pivots);
@@ -118,7 +138,7 @@ QDomElement AnimatedSurface::prp_writePropertyXEV_impl(const XevExporter& exp) c
         const auto pivotStr = QString("%1 %2").arg(pivot.x()).
                                                arg(pivot.y());
         result.setAttribute("pivot", pivotStr);
-        savePaintImageXEV("value.png", exp, *mBaseValue);
+        scheduleSavePaintImageXEV("value.png", exp, *mBaseValue);
     }
     return result;
 }
@@ -233,6 +253,7 @@ void AnimatedSurface::loadPixmapT(const T &src) {
     const bool createNewFrame = anim_isRecording() &&
                                 !anim_getKeyOnCurrentFrame();
     if(createNewFrame) newEmptyFrame();
+    mCurrent_d->finishPendingChanges();
     auto& target = mCurrent_d->surface();
     const bool undoRedo = getParentScene();
     if(undoRedo) {
@@ -290,17 +311,23 @@ void AnimatedSurface::afterChangedCurrentContent() {
 }
 
 void AnimatedSurface::addUndoRedo(const QString& name, const QRect& roi) {
-    auto& target = mCurrent_d->surface();
+    addUndoRedo(name, roi, mCurrent_d);
+}
+
+void AnimatedSurface::addUndoRedo(const QString& name, const QRect& roi,
+                                  DrawableAutoTiledSurface * const surface) {
+    auto& target = surface->surface();
     auto undoList = target.takeUndoList();
     if(undoList.isEmpty()) return;
     {
         prp_pushUndoRedoName(name);
-        const stdptr<DrawableAutoTiledSurface> ptr = mCurrent_d;
+        const stdptr<DrawableAutoTiledSurface> ptr = surface;
         UndoRedo ur;
 
         const auto replaceTile = [this, undoList, ptr, roi](
                                  const stdsptr<Tile>& (UndoTile::*getter)() const) {
             if(!ptr) return;
+            ptr->finishPendingChanges();
             auto& surface = ptr->surface();
             for(const auto& undoTile : undoList) {
                 surface.replaceTile(undoTile.tileX(),
@@ -310,7 +337,7 @@ void AnimatedSurface::addUndoRedo(const QString& name, const QRect& roi) {
             surface.autoCrop();
             ptr->updateTileDimensions();
             ptr->pixelRectChanged(roi);
-            afterChangedCurrentContent();
+            afterSurfaceChanged(ptr);
         };
 
         ur.fUndo = [replaceTile]() {
@@ -348,9 +375,10 @@ public:
             const int span = mExp.fAbsRange.span();
 
             if(idRange.inRange(mVisRage) || span == 1) {
-                addSurface(mVisRage.fMin, nullptr);
                 mKeyRelFrame = mVisRage.fMax;
-                return nextStep();
+                const bool wait = addSurface(mVisRage.fMin, nullptr);
+                if(!wait) nextStep();
+                return;
             }
         }
 
@@ -382,26 +410,34 @@ public:
 
 private:
     //! @brief Returns true if there is a task, does have to wait.
+    //! The surface is loaded first, its pivot is only known once loaded,
+    //! nextStep is called once the surface and its image are saved.
     bool addSurface(const int relFrame, DrawableAutoTiledSurface* surf) {
         if(!surf) surf = mSrc->getSurface(relFrame);
-        const QString imageId = SvgExportHelpers::ptrToStr(surf);
-        const QPoint pos = -surf->zeroTilePos();
         sk_sp<SkImage> image;
-        const auto task = mSrc->getFrameImage(relFrame, image);
+        eTask* task;
+        if(surf->storesDataInMemory()) {
+            task = mSrc->getFrameImage(relFrame, image);
+        } else task = surf->scheduleLoadFromTmpFile();
         if(task) {
-            const auto imgTask = static_cast<ImgLoader*>(task);
             const QPointer<ASurfaceSaverSVG> ptr = this;
-            task->addDependent({[ptr, imgTask, relFrame, imageId, pos]() {
+            const stdptr<DrawableAutoTiledSurface> surfPtr = surf;
+            // query again once loaded, the loaded data may be unloaded again
+            // or the image may need to be loaded after the surface
+            const auto loaded = [ptr, surfPtr, relFrame]() {
                 if(!ptr) return;
-                const auto image = imgTask->image();
-                ptr->saveSurfaceValues(relFrame, image, imageId, pos);
-            }, nullptr});
-            addTask(task->ref<eTask>());
+                if(!surfPtr) return ptr->cancel();
+                const bool wait = ptr->addSurface(relFrame, surfPtr.get());
+                if(!wait) ptr->nextStep();
+            };
+            const auto canceled = [ptr]() { if(ptr) ptr->cancel(); };
+            task->addDependent({loaded, canceled});
             return true;
-        } else {
-            saveSurfaceValues(relFrame, image, imageId, pos);
-            return false;
         }
+        const QString imageId = SvgExportHelpers::ptrToStr(surf);
+        const QPoint pos = -surf->zeroTilePos();
+        saveSurfaceValues(relFrame, image, imageId, pos);
+        return false;
     }
 
     void saveSurfaceValues(const int relFrame, const sk_sp<SkImage>& image,
@@ -50,6 +50,16 @@ public:
         mValue->read(src);
     }
 
+    void writeKey(eWriteStream& dst, TilePoolWriter& pool) {
+        Key::writeKey(dst);
+        mValue->write(dst, pool);
+    }
+
+    void readKey(eReadStream& src, TilePoolReader& pool) {
+        Key::readKey(src);
+        mValue->read(src, pool);
+    }
+
     DrawableAutoTiledSurface& dSurface() { return *mValue.get(); }
 private:
     const stdsptr<DrawableAutoTiledSurface> mValue;
@@ -173,6 +183,10 @@ public:
 
     void afterChangedCurrentContent();
     void addUndoRedo(const QString &name, const QRect &roi);
+    //! @brief Adds the undo step for the changes of the given surface,
+    //! which does not have to be the current one
+    void addUndoRedo(const QString &name, const QRect &roi,
+                     DrawableAutoTiledSurface * const surface);
 
     eTaskBase* savePaintSVG(SvgExporter& exp, QDomElement& use,
                             const FrameRange& visRelRange);
@@ -31,11 +31,10 @@ AutoTiledSurfaceBase::AutoTiledSurfaceBase(const TileCreator tileCreator,
     mRequestEnd(requestEnd) {
     mypaint_tiled_surface_init(&mParent, requestStart, requestEnd);
     mParent.parent.destroy = sFree;
-//#ifdef _OPENMP
+    // libmypaint built with OpenMP rasterizes the queued dabs of each dirty
+    // tile on its own thread, every tile is processed by a single thread
+    // in dab order, so the result does not depend on the thread count
     mParent.threadsafe_tile_requests = true;
-//#else
-//    mParent.threadsafe_tile_requests = false;
-//#endif
 }
 
 AutoTiledSurfaceBase::AutoTiledSurfaceBase(const AutoTiledSurfaceBase &other) :
@@ -120,15 +119,12 @@ void AutoTiledSurfaceBase::free() {
 void AutoTiledSurface::sRequestStart(MyPaintTiledSurface *surface,
                                      MyPaintTileRequest *request) {
     const auto self = reinterpret_cast<AutoTiledSurface*>(surface);
+    stdsptr<Tile> tile;
+    // only the tile map is shared between the threads
     #pragma omp critical
-    {
-        // make copy for undo/redo if not yet done,
-        // keep references to tiles,
-        // flush undo/redo later
-        const auto tile = self->requestTile(request->tx, request->ty);
-        if(tile) request->buffer = tile->requestZeroedData();
-        else request->buffer = nullptr;
-    }
+    tile = self->requestTile(request->tx, request->ty);
+    if(tile) request->buffer = tile->requestZeroedData();
+    else request->buffer = nullptr;
 }
 
 void AutoTiledSurface::sRequestEnd(MyPaintTiledSurface *,
@@ -142,18 +138,20 @@ AutoTiledSurface::AutoTiledSurface() :
 void UndoableAutoTiledSurface::sRequestStart(MyPaintTiledSurface *surface,
                                              MyPaintTileRequest *request) {
     const auto self = reinterpret_cast<UndoableAutoTiledSurface*>(surface);
+    stdsptr<Tile> tile;
     #pragma omp critical
     {
         // make copy for undo/redo if not yet done,
         // keep references to tiles,
         // flush undo/redo later
-        const auto tile = self->requestTile(request->tx, request->ty);
+        tile = self->requestTile(request->tx, request->ty);
         const auto undoableTile = std::static_pointer_cast<UndoableTile>(tile);
         if(!undoableTile->fUndo) {
             self->addToUndoList(UndoTile(request->tx, request->ty, undoableTile));
         }
-        request->buffer = tile->requestZeroedData();
     }
+    // the undo copy shares the data, detaching it can run in parallel
+    request->buffer = tile->requestZeroedData();
 }
 
 void UndoableAutoTiledSurface::sRequestEnd(MyPaintTiledSurface *,
@@ -164,14 +162,12 @@ UndoableAutoTiledSurface::UndoableAutoTiledSurface() :
 }, sRequestStart, sRequestEnd) {}
 
 void UndoableAutoTiledSurface::triggerAllChange() {
-    const QRect tiles = tileBoundingRect();
-    for(int tx = tiles.left(); tx <= tiles.right(); tx++) {
-        for(int ty = tiles.top(); ty <= tiles.bottom(); ty++) {
-            const auto tile = requestTile(tx, ty);
-            const auto undoableTile = std::static_pointer_cast<UndoableTile>(tile);
-            if(!undoableTile->fUndo) {
-                addToUndoList(UndoTile(tx, ty, undoableTile));
-            }
+    // only the stored tiles, the bounding rect can be mostly empty
+    tilesData().forEachTile([this](const int tx, const int ty,
+                                   const stdsptr<Tile>& tile) {
+        const auto undoableTile = std::static_pointer_cast<UndoableTile>(tile);
+        if(!undoableTile->fUndo) {
+            addToUndoList(UndoTile(tx, ty, undoableTile));
         }
-    }
+    });
 }
@@ -89,6 +89,10 @@ public:
         set.execute(brush, mMyPaintSurface, 5);
     }
 
+    stdsptr<Tile> getTile(const int tx, const int ty) const {
+        return mAutoTilesData.getTile(tx, ty);
+    }
+
     bool tileToBitmap(const int tx, const int ty, SkBitmap& bitmap) {
         return mAutoTilesData.tileToBitmap(tx, ty, bitmap);
     }
@@ -119,6 +123,10 @@ public:
     }
 
     bool isEmpty() const { return mAutoTilesData.isEmpty(); }
+    int tileCount() const { return mAutoTilesData.tileCount(); }
+
+    //! @brief Copies share the tile data, use to snapshot the tiles
+    const AutoTilesData& tilesData() const { return mAutoTilesData; }
 
     void write(eWriteStream& dst) const {
         mAutoTilesData.write(dst);
@@ -128,6 +136,18 @@ public:
         mAutoTilesData.read(src);
     }
 
+    void write(eWriteStream& dst, TilePoolWriter& pool) const {
+        mAutoTilesData.write(dst, pool);
+    }
+
+    void read(eReadStream& src, TilePoolReader& pool) {
+        mAutoTilesData.read(src, pool);
+    }
+
+    void loadCompressed(const CompressedTiles& tiles) {
+        mAutoTilesData.loadCompressed(tiles);
+    }
+
     void clear() { mAutoTilesData.clear(); }
 
     void replaceTile(const int tx, const int ty,
@@ -17,28 +17,29 @@
 #include "autotilesdata.h"
 
 #include <QImage>
+#include <algorithm>
 
 #include "exceptions.h"
 #include "skia/skiahelpers.h"
+#include "colorconversions.h"
+#include "ReadWrite/evformat.h"
 
 AutoTilesData::AutoTilesData(const TileCreator& tileCreator) :
     mTileCreator(tileCreator) {}
 
 AutoTilesData::AutoTilesData(const AutoTilesData &other) :
     AutoTilesData(other.mTileCreator) {
-    mZeroTileCol = other.mZeroTileCol;
-    mZeroTileRow = other.mZeroTileRow;
-    mColumnCount = other.mColumnCount;
-    mRowCount = other.mRowCount;
-
-    for(auto& column : other.mColumns) {
-        mColumns.append(QList<stdsptr<Tile>>());
-        QList<stdsptr<Tile>> &col = mColumns.last();
-        for(auto& srcTile : column) {
-            const auto dstTile = mTileCreator(TILE_SPIXEL_SIZE);
-            dstTile->copyFrom(*srcTile.get());
-            col << dstTile;
-        }
+    mMinCol = other.mMinCol;
+    mMaxCol = other.mMaxCol;
+    mMinRow = other.mMinRow;
+    mMaxRow = other.mMaxRow;
+    mTileBoundingRect = other.mTileBoundingRect;
+
+    mTiles.reserve(other.mTiles.size());
+    for(const auto& srcTile : other.mTiles) {
+        const auto dstTile = mTileCreator(TILE_SPIXEL_SIZE);
+        dstTile->copyFrom(*srcTile.second.get());
+        mTiles.emplace(srcTile.first, dstTile);
     }
 }
 
@@ -175,16 +176,21 @@ void premul_16_to_15(uint16_t const *& srcLine, uint16_t*& dstLine) {
 }
 
 template <typename Addr, void (*To15Bit)(Addr const *& srcLine, uint16_t*& dstLine)>
+void per_pixel_to_15(const Addr* srcLine, uint16_t* dstLine, const int count) {
+    for(int i = 0; i < count; i++) To15Bit(srcLine, dstLine);
+}
+
+template <typename Addr, void (*To15Bit)(const Addr* srcLine, uint16_t* dstLine, const int count)>
 void AutoTilesData::loadPixmap(const Addr * const src, const int width, const int height) {
     clear();
     const int nCols = qCeil(static_cast<qreal>(width)/TILE_SIZE);
     const int nRows = qCeil(static_cast<qreal>(height)/TILE_SIZE);
 
+    mTiles.reserve(static_cast<size_t>(nCols*nRows));
     for(int col = 0; col < nCols; col++) {
         const bool lastCol = col == (nCols - 1);
         const int x0 = col*TILE_SIZE;
         const int maxX = qMin(x0 + TILE_SIZE, width);
-        QList<stdsptr<Tile>> colRows;
         for(int row = 0; row < nRows; row++) {
             const auto tile = mTileCreator(TILE_SPIXEL_SIZE);
 
@@ -198,18 +204,12 @@ void AutoTilesData::loadPixmap(const Addr * const src, const int width, const in
             for(int y = y0; y < maxY; y++) {
                 const Addr * srcLine = src + (y*width + x0)*4;
                 uint16_t* dstLine = tileP + (y - y0)*TILE_SIZE*4;
-                for(int x = x0; x < maxX; x++) {
-                    To15Bit(srcLine, dstLine);
-                }
+                To15Bit(srcLine, dstLine, maxX - x0);
             }
-            colRows << tile;
+            mTiles.emplace(sTileKey(col, row), tile);
         }
-        mColumns << colRows;
     }
-    mColumnCount = nCols;
-    mRowCount = nRows;
-    mZeroTileCol = 0;
-    mZeroTileRow = 0;
+    mTileBoundingRect = QRect(0, 0, nCols, nRows);
 }
 
 template <typename T>
@@ -245,11 +245,19 @@ void AutoTilesData::loadPixmap_XXXA_8888(const uint8_t* const addr8,
                                          const int height,
                                          const SkAlphaType alphaType) {
     if(alphaType == kUnpremul_SkAlphaType) {
-        loadPixmap<uint8_t, unpremul_8_to_15<Swapper>>(addr8, width, height);
+        // the most common case (e.g. PNG) has a vectorized conversion
+        if(Swapper == RGBA_to_RGBA<uint8_t>) {
+            loadPixmap<uint8_t, rgba8_to_rgba16_row>(addr8, width, height);
+        } else {
+            loadPixmap<uint8_t, per_pixel_to_15<uint8_t, unpremul_8_to_15<Swapper>>>(
+                        addr8, width, height);
+        }
     } else if(alphaType == kPremul_SkAlphaType) {
-        loadPixmap<uint8_t, premul_8_to_15<Swapper>>(addr8, width, height);
+        loadPixmap<uint8_t, per_pixel_to_15<uint8_t, premul_8_to_15<Swapper>>>(
+                    addr8, width, height);
     } else if(alphaType == kOpaque_SkAlphaType) {
-        loadPixmap<uint8_t, opaque_8_to_15<Swapper>>(addr8, width, height);
+        loadPixmap<uint8_t, per_pixel_to_15<uint8_t, opaque_8_to_15<Swapper>>>(
+                    addr8, width, height);
     } else RuntimeThrow("Unsupported alpha type");
 }
 
@@ -259,11 +267,14 @@ void AutoTilesData::loadPixmap_XXXA_16161616(const uint16_t* const addr16,
                                              const int height,
                                              const SkAlphaType alphaType) {
     if(alphaType == kUnpremul_SkAlphaType) {
-        loadPixmap<uint16_t, unpremul_16_to_15<Swapper>>(addr16, width, height);
+        loadPixmap<uint16_t, per_pixel_to_15<uint16_t, unpremul_16_to_15<Swapper>>>(
+                    addr16, width, height);
     } else if(alphaType == kPremul_SkAlphaType) {
-        loadPixmap<uint16_t, premul_16_to_15<Swapper>>(addr16, width, height);
+        loadPixmap<uint16_t, per_pixel_to_15<uint16_t, premul_16_to_15<Swapper>>>(
+                    addr16, width, height);
     } else if(alphaType == kOpaque_SkAlphaType) {
-        loadPixmap<uint16_t, opaque_16_to_15<Swapper>>(addr16, width, height);
+        loadPixmap<uint16_t, per_pixel_to_15<uint16_t, opaque_16_to_15<Swapper>>>(
+                    addr16, width, height);
     } else RuntimeThrow("Unsupported alpha type");
 }
 
@@ -334,30 +345,68 @@ AutoTilesData::~AutoTilesData() {
 }
 
 void AutoTilesData::clear() {
-    mColumns.clear();
-    mZeroTileCol = 0;
-    mZeroTileRow = 0;
-    mColumnCount = 0;
-    mRowCount = 0;
+    mTiles.clear();
+    mTileBoundingRect = QRect();
 }
 
 stdsptr<Tile> AutoTilesData::getTile(const int tx, const int ty) const {
-    return getTileByIndex(tx + mZeroTileCol, ty + mZeroTileRow);
+    const auto it = mTiles.find(sTileKey(tx, ty));
+    if(it == mTiles.end()) return nullptr;
+    return it->second;
 }
 
 stdsptr<Tile> AutoTilesData::getTileByIndex(const int colId,
                                             const int rowId) const {
-    if(colId < 0 || colId >= mColumnCount ||
-       rowId < 0 || rowId >= mRowCount) return nullptr;
-    return mColumns.at(colId).at(rowId);
+    return getTile(colId + mTileBoundingRect.left(),
+                   rowId + mTileBoundingRect.top());
 }
 
 int AutoTilesData::width() const {
-    return mColumnCount*TILE_SIZE;
+    return mTileBoundingRect.width()*TILE_SIZE;
 }
 
 int AutoTilesData::height() const {
-    return mRowCount*TILE_SIZE;
+    return mTileBoundingRect.height()*TILE_SIZE;
+}
+
+AutoTilesData::TileKey AutoTilesData::sTileKey(const int tx, const int ty) {
+    return (static_cast<TileKey>(static_cast<quint32>(tx)) << 32) |
+            static_cast<quint32>(ty);
+}
+
+QPoint AutoTilesData::sTilePos(const TileKey key) {
+    return QPoint(static_cast<qint32>(key >> 32),
+                  static_cast<qint32>(key & 0xFFFFFFFF));
+}
+
+void AutoTilesData::forEachTile(const TileFunc& func) const {
+    for(const auto& tile : mTiles) {
+        const QPoint pos = sTilePos(tile.first);
+        func(pos.x(), pos.y(), tile.second);
+    }
+}
+
+const stdsptr<Tile>& AutoTilesData::tileAt(const int tx, const int ty) {
+    auto& tile = mTiles[sTileKey(tx, ty)];
+    if(!tile) {
+        tile = mTileCreator(TILE_SPIXEL_SIZE);
+        mTileBoundingRect |= QRect(tx, ty, 1, 1);
+    }
+    return tile;
+}
+
+void AutoTilesData::insertTile(const int tx, const int ty,
+                               const stdsptr<Tile>& tile) {
+    mTiles[sTileKey(tx, ty)] = tile;
+    mTileBoundingRect |= QRect(tx, ty, 1, 1);
+}
+
+void AutoTilesData::updateTileBoundingRect() {
+    mTileBoundingRect = QRect();
+    for(const auto& tile : mTiles) {
+        const QPoint pos = sTilePos(tile.first);
+        mTileBoundingRect |= QRect(pos, QSize(1, 1));
+    }
 }
 
 bool AutoTilesData::tileToBitmap(const Tile &srcTile, SkBitmap &bitmap) {
@@ -382,17 +431,7 @@ bool AutoTilesData::tileToBitmap(const Tile &srcTile, SkBitmap &bitmap) {
     for(int y = 0; y < TILE_SIZE; y++) {
         uint8_t * dstLine = dstP + y*bitmap.width()*4;
         const uint16_t * srcLine = srcP + y*TILE_SIZE*4;
-        for(int x = 0; x < TILE_SIZE; x++) {
-            const uint32_t r = *srcLine++;
-            const uint32_t g = *srcLine++;
-            const uint32_t b = *srcLine++;
-            const uint32_t a = *srcLine++;
-
-            *dstLine++ = (r * 255 + (1<<15)/2) / (1<<15);
-            *dstLine++ = (g * 255 + (1<<15)/2) / (1<<15);
-            *dstLine++ = (b * 255 + (1<<15)/2) / (1<<15);
-            *dstLine++ = (a * 255 + (1<<15)/2) / (1<<15);
-        }
+        rgba16_to_rgba8_premultiplied_row(srcLine, dstLine, TILE_SIZE);
     }
     return true;
 }
@@ -400,7 +439,7 @@ bool AutoTilesData::tileToBitmap(const Tile &srcTile, SkBitmap &bitmap) {
 SkBitmap AutoTilesData::tileToBitmap(const int tx, const int ty) {
     SkBitmap bitmap;
     const auto srcTile = getTile(tx, ty);
-    if(!srcTile->data()) return bitmap;
+    if(!srcTile || !srcTile->data()) return bitmap;
     const auto info = SkiaHelpers::getPremulRGBAInfo(TILE_SIZE, TILE_SIZE);
     bitmap.allocPixels(info);
     tileToBitmap(*srcTile, bitmap);
@@ -409,7 +448,8 @@ SkBitmap AutoTilesData::tileToBitmap(const int tx, const int ty) {
 
 bool AutoTilesData::tileToBitmap(const int tx, const int ty, SkBitmap &bitmap) {
     const auto srcTile = getTile(tx, ty);
-    return tileToBitmap(*srcTile, bitmap);
+    if(srcTile) return tileToBitmap(*srcTile, bitmap);
+    return tileToBitmap(Tile(TILE_SPIXEL_SIZE), bitmap);
 }
 
 template<typename Addr>
@@ -441,17 +481,15 @@ void clearMarginPixels(const QMargins& margin,
     clearRect(QRect(lM, dstHeight - bM, dstWidth - lM - rM - 1, bM - 1), dstWidth, dst);
 }
 
-void premul_15_to_permul_8(uint8_t* dstLine, const uint16_t* srcLine) {
-    const uint32_t src = *srcLine;
-    *dstLine = (src * 255 + (1<<15)/2) / (1<<15);
-}
-
-void premul_15_to_permul_16(uint16_t* dstLine, const uint16_t* srcLine) {
-    const uint32_t src = *srcLine;
-    *dstLine = (src * USHRT_MAX + (1<<15)/2) / (1<<15);
+void premul_15_to_permul_16(const uint16_t* srcLine, uint16_t* dstLine,
+                            const int count) {
+    for(int i = 0; i < 4*count; i++) {
+        const uint32_t src = *srcLine++;
+        *dstLine++ = (src * USHRT_MAX + (1<<15)/2) / (1<<15);
+    }
 }
 
-template<typename Addr, void (*From15Bit)(Addr *dstLine, const uint16_t* srcLine)>
+template<typename Addr, void (*From15Bit)(const uint16_t* srcLine, Addr *dstLine, const int count)>
 void AutoTilesData::toBitmap(Addr * const dst, const QMargins &margin,
                              const int dstWidth, const int dstHeight) const {
     const int lM = margin.left();
@@ -491,7 +529,7 @@ void AutoTilesData::toBitmap(Addr * const dst, const QMargins &margin,
             const QRect tClippedSrcRect = tSrcRect.intersected(srcRect);
             const QRect tileDstRect = tClippedSrcRect.translated(lM, tM);
             const auto srcTile = getTileByIndex(srcCol, srcRow);
-            const uint16_t * const srcP = srcTile->data();
+            const uint16_t * const srcP = srcTile ? srcTile->data() : nullptr;
             // if no tile data
             if(!srcP) {
                 clearRect(tileDstRect, dstWidth, dst);
@@ -505,7 +543,7 @@ void AutoTilesData::toBitmap(Addr * const dst, const QMargins &margin,
                 const int maxSrcY = relTileRect.bottom();
                 const int minDstX = tileDstRect.x();
                 const int minDstY = tileDstRect.y();
-                const int iMax = (maxSrcX - minSrcX + 1)*4; // for every subpixel (4)
+                const int iMax = maxSrcX - minSrcX + 1;
                 const int jMax = maxSrcY - minSrcY + 1;
                 for(int j = 0; j < jMax; j++) {
                     const int srcY = minSrcY + j;
@@ -514,9 +552,7 @@ void AutoTilesData::toBitmap(Addr * const dst, const QMargins &margin,
                     const int dstY = minDstY + j;
                     const int dstPixelId = dstY*dstWidth + minDstX;
                     Addr * dstLine = dst + dstPixelId*4;
-                    for(int i = 0; i < iMax; i++) {
-                        From15Bit(dstLine++, srcLine++);
-                    }
+                    From15Bit(srcLine, dstLine, iMax);
                 }
             }
 
@@ -536,7 +572,7 @@ SkBitmap AutoTilesData::toBitmap(const QMargins& margin) const {
     SkBitmap dst;
     dst.allocPixels(info);
     uint8_t * const dstP = static_cast<uint8_t*>(dst.getPixels());
-    toBitmap<uint8_t, premul_15_to_permul_8>(dstP, margin, dstWidth, dstHeight);
+    toBitmap<uint8_t, rgba16_to_rgba8_premultiplied_row>(dstP, margin, dstWidth, dstHeight);
     return dst;
 }
 
@@ -558,14 +594,14 @@ QImage AutoTilesData::toImage(const bool use16Bit,
     } else {
         dst = QImage(dstWidth, dstHeight, QImage::Format_RGBA8888_Premultiplied);
         uint8_t * const dstP = static_cast<uint8_t*>(dst.bits());
-        toBitmap<uint8_t, premul_15_to_permul_8>(dstP, margin, dstWidth, dstHeight);
+        toBitmap<uint8_t, rgba16_to_rgba8_premultiplied_row>(dstP, margin, dstWidth, dstHeight);
     }
     return dst;
 }
 
 bool AutoTilesData::drawOnPixmap(SkPixmap &dst, int drawX, int drawY) const {
-    drawX -= mZeroTileCol*TILE_SIZE;
-    drawY -= mZeroTileRow*TILE_SIZE;
+    drawX += mTileBoundingRect.left()*TILE_SIZE;
+    drawY += mTileBoundingRect.top()*TILE_SIZE;
     const qreal qDrawX = drawX;
     const qreal qDrawY = drawY;
     uint8_t * const dstP = static_cast<uint8_t*>(dst.writable_addr());
@@ -592,10 +628,10 @@ bool AutoTilesData::drawOnPixmap(SkPixmap &dst, int drawX, int drawY) const {
 
     const int minDstCol = qMax(0, qCeil(qDrawX/TILE_SIZE));
     const int maxDstCol = qMin(dstCols - 1,
-                               minDstCol + mColumnCount - 1);
+                               minDstCol + mTileBoundingRect.width() - 1);
     const int minDstRow = qMax(0, qCeil(qDrawY/TILE_SIZE));
     const int maxDstRow = qMin(dstRows - 1,
-                               minDstRow + mRowCount - 1);
+                               minDstRow + mTileBoundingRect.height() - 1);
 
     const int nCols = maxDstCol - minDstCol;
     const int nRows = maxDstRow - minDstRow;
@@ -618,7 +654,7 @@ bool AutoTilesData::drawOnPixmap(SkPixmap &dst, int drawX, int drawY) const {
             const int dstRow = minDstRow + row;
             const int srcRow = minSrcRow + row;
             const auto srcTile = getTileByIndex(srcCol, srcRow);
-            const uint16_t * const srcP = srcTile->data();
+            const uint16_t * const srcP = srcTile ? srcTile->data() : nullptr;
             const int dstY0 = dstRow*TILE_SIZE;
             const int minTileDstY = qMax(dstY0, minDstY);
             const int maxTileDstY = qMin((dstRow + 1)*TILE_SIZE - 1, maxDstY);
@@ -665,7 +701,7 @@ bool AutoTilesData::drawOnPixmap(SkPixmap &dst, int drawX, int drawY) const {
 }
 
 QPoint AutoTilesData::zeroTile() const {
-    return QPoint(mZeroTileCol, mZeroTileRow);
+    return -mTileBoundingRect.topLeft();
 }
 
 QPoint AutoTilesData::zeroTilePos() const {
@@ -677,8 +713,7 @@ QRect AutoTilesData::pixelBoundingRect() const {
 }
 
 QRect AutoTilesData::tileBoundingRect() const {
-    return QRect(-mZeroTileCol, -mZeroTileRow,
-                 mColumnCount, mRowCount);
+    return mTileBoundingRect;
 }
 
 QRect AutoTilesData::tileRectToPixRect(const QRect &tileRect) const {
@@ -705,153 +740,116 @@ void AutoTilesData::setPixelClamp(const QRect &pixRect) {
 }
 
 void AutoTilesData::swap(AutoTilesData &other) {
-    mColumns.swap(other.mColumns);
+    mTiles.swap(other.mTiles);
+    std::swap(mTileBoundingRect, other.mTileBoundingRect);
 
     std::swap(mMinCol, other.mMinCol);
     std::swap(mMaxCol, other.mMaxCol);
     std::swap(mMinRow, other.mMinRow);
     std::swap(mMaxRow, other.mMaxRow);
-
-    std::swap(mZeroTileCol, other.mZeroTileCol);
-    std::swap(mZeroTileRow, other.mZeroTileRow);
-    std::swap(mColumnCount, other.mColumnCount);
-    std::swap(mRowCount, other.mRowCount);
 }
 
 void AutoTilesData::write(eWriteStream& dst) const {
-    dst << mZeroTileCol;
-    dst << mZeroTileRow;
-    dst << mColumnCount;
-    dst << mRowCount;
-    const int nCols = mColumns.count();
-    dst << nCols;
-    const int nRows = mColumns.isEmpty() ? 0 : mColumns.first().count();
-    dst << nRows;
-    for(const auto& col : mColumns) {
-        for(const auto& tile : col) {
-            tile->write(dst);
-        }
-    }
+    TilePoolWriter pool;
+    write(dst, pool);
 }
 
 void AutoTilesData::read(eReadStream &src) {
+    TilePoolReader pool;
+    read(src, pool);
+}
+
+void AutoTilesData::write(eWriteStream& dst, TilePoolWriter& pool) const {
+    std::vector<TilePoolWriter::TilePos> tiles;
+    tiles.reserve(mTiles.size());
+    for(const auto& tile : mTiles) {
+        tiles.push_back({sTilePos(tile.first), tile.second.get()});
+    }
+    // keep the output independent of the hash map order
+    std::sort(tiles.begin(), tiles.end(),
+              [](const TilePoolWriter::TilePos& a,
+                 const TilePoolWriter::TilePos& b) {
+        if(a.first.x() == b.first.x()) return a.first.y() < b.first.y();
+        return a.first.x() < b.first.x();
+    });
+    pool.writeTiles(dst, tiles);
+}
+
+void AutoTilesData::read(eReadStream &src, TilePoolReader& pool) {
+    clear();
+    if(src.evFileVersion() < EvFormat::paintTilePool) {
+        readDense(src);
+        return;
+    }
+    pool.readTiles(src, mTileCreator,
+                   [this](const int tx, const int ty,
+                          const stdsptr<Tile>& tile) {
+        insertTile(tx, ty, tile);
+    });
+}
+
+void AutoTilesData::loadCompressed(const CompressedTiles& tiles) {
     clear();
-    src >> mZeroTileCol;
-    src >> mZeroTileRow;
-    src >> mColumnCount;
-    src >> mRowCount;
+    tiles.decompress(mTileCreator, [this](const int tx, const int ty,
+                                          const stdsptr<Tile>& tile) {
+        insertTile(tx, ty, tile);
+    });
+}
+
+void AutoTilesData::readDense(eReadStream &src) {
+    int zeroTileCol;
+    src >> zeroTileCol;
+    int zeroTileRow;
+    src >> zeroTileRow;
+    int columnCount;
+    src >> columnCount;
+    int rowCount;
+    src >> rowCount;
     int nCols;
     src >> nCols;
     int nRows;
     src >> nRows;
     for(int col = 0; col < nCols; col++) {
-        mColumns << QList<stdsptr<Tile>>();
-        QList<stdsptr<Tile>>& column = mColumns.last();
         for(int row = 0; row < nRows; row++) {
-            column << Tile::sRead(src, mTileCreator);
+            const auto tile = Tile::sRead(src, mTileCreator);
+            if(!tile->data()) continue;
+            insertTile(col - zeroTileCol, row - zeroTileRow, tile);
         }
     }
 }
 
 void AutoTilesData::discardTransparentTiles() {
-    for(QList<stdsptr<Tile>>& col : mColumns) {
-        for(auto& tile : col) {
-            if(!tile->data()) continue;
-            if(!tile->dataTransparent()) continue;
-            tile->removeData();
-        }
+    for(const auto& tile : mTiles) {
+        if(!tile.second->data()) continue;
+        if(!tile.second->dataTransparent()) continue;
+        tile.second->removeData();
     }
 }
 
-bool AutoTilesData::columnEmpty(const int colId) {
-    const auto& col = mColumns.at(colId);
-    for(const auto& tile : col) {
-        if(tile->data()) return false;
+void AutoTilesData::autoCrop() {
+    discardTransparentTiles();
+    for(auto it = mTiles.begin(); it != mTiles.end();) {
+        if(it->second->data()) it++;
+        else it = mTiles.erase(it);
     }
-    return true;
+    updateTileBoundingRect();
 }
 
-bool AutoTilesData::rowEmpty(const int rowId) {
-    for(const auto& col : mColumns) {
-        if(col.at(rowId)->data()) return false;
+void zeroTileOutside(Tile& tile, const QRect& relRect) {
+    if(!tile.data()) return;
+    uint16_t* const data = tile.requestData();
+    for(int y = 0; y < TILE_SIZE; y++) {
+        uint16_t* const line = data + y*TILE_SIZE*4;
+        if(y < relRect.top() || y > relRect.bottom()) {
+            memset(line, 0, TILE_SIZE*4*sizeof(uint16_t));
+            continue;
+        }
+        const int left = qBound(0, relRect.left(), TILE_SIZE);
+        const int right = qBound(-1, relRect.right(), TILE_SIZE - 1);
+        memset(line, 0, left*4*sizeof(uint16_t));
+        memset(line + (right + 1)*4, 0,
+               (TILE_SIZE - right - 1)*4*sizeof(uint16_t));
     }
-    return true;
-}
-
-void AutoTilesData::removeFirstColumn() {
-    mColumns.removeFirst();
-    mColumnCount--;
-    mZeroTileCol--;
-}
-
-void AutoTilesData::removeLastColumn() {
-    mColumns.removeLast();
-    mColumnCount--;
-}
-
-void AutoTilesData::removeFirstRow() {
-    for(auto& col : mColumns) col.removeFirst();
-    mRowCount--;
-    mZeroTileRow--;
-}
-
-void AutoTilesData::removeLastRow() {
-    for(auto& col : mColumns) col.removeLast();
-    mRowCount--;
-}
-
-void AutoTilesData::zeroFirstColumn() {
-    const auto& col = mColumns.first();
-    for(const auto& tile : col) tile->zeroData();
-}
-
-void AutoTilesData::zeroLastColumn() {
-    const auto& col = mColumns.last();
-    for(const auto& tile : col) tile->zeroData();
-}
-
-void AutoTilesData::zeroFirstRow() {
-    for(auto& col : mColumns) col.first()->zeroData();
-}
-
-void AutoTilesData::zeroLastRow() {
-    for(auto& col : mColumns) col.last()->zeroData();
-}
-
-bool AutoTilesData::cropFirstColumnIfEmpty() {
-    if(mColumns.isEmpty()) return false;
-    if(!columnEmpty(0)) return false;
-    removeFirstColumn();
-    return true;
-}
-
-bool AutoTilesData::cropLastColumnIfEmpty() {
-    if(mColumns.isEmpty()) return false;
-    if(!columnEmpty(mColumnCount - 1)) return false;
-    removeLastColumn();
-    return true;
-}
-
-bool AutoTilesData::cropFirstRowIfEmpty() {
-    if(mColumns.isEmpty()) return false;
-    if(!rowEmpty(0)) return false;
-    removeFirstRow();
-    return true;
-}
-
-bool AutoTilesData::cropLastRowIfEmpty() {
-    if(mColumns.isEmpty()) return false;
-    if(!rowEmpty(mRowCount - 1)) return false;
-    removeLastRow();
-    return true;
-}
-
-void AutoTilesData::autoCrop() {
-    discardTransparentTiles();
-    while(cropFirstColumnIfEmpty()) continue;
-    while(cropLastColumnIfEmpty()) continue;
-    while(cropFirstRowIfEmpty()) continue;
-    while(cropLastRowIfEmpty()) continue;
 }
 
 void AutoTilesData::crop(const QRect &cropRect) {
@@ -859,324 +857,149 @@ void AutoTilesData::crop(const QRect &cropRect) {
     const QRect normalizedCrop = cropRect.normalized();
     const QRect clampedCrop = normalizedCrop.intersected(iniRect);
 
-    {
-        const int dl = clampedCrop.left() - iniRect.left();
-        const int dtl = dl/TILE_SIZE;
-        const int dpl = dl - dtl*TILE_SIZE;
-
-        moveX(-dpl, false);
-        for(int i = 0; i < dtl; i++) {
-            zeroFirstColumn();
-            removeFirstColumn();
-        }
-        moveX(dpl, false);
-    }
-
-    {
-        const int dr = clampedCrop.right() - iniRect.right();
-        const int dtr = dr/TILE_SIZE;
-        const int dpr = dr - dtr*TILE_SIZE;
-
-        moveX(-dpr, false);
-        for(int i = 0; i < -dtr; i++) {
-            zeroLastColumn();
-            removeLastColumn();
-        }
-        moveX(dpr, false);
-    }
-
-    {
-        const int dt = clampedCrop.top() - iniRect.top();
-        const int dtt = dt/TILE_SIZE;
-        const int dpt = dt - dtt*TILE_SIZE;
-
-        moveY(-dpt, false);
-        for(int i = 0; i < dtt; i++) {
-            zeroFirstRow();
-            removeFirstRow();
+    for(const auto& tile : mTiles) {
+        const QPoint pos = sTilePos(tile.first);
+        const QRect tileRect = tileRectToPixRect(QRect(pos, QSize(1, 1)));
+        if(clampedCrop.contains(tileRect)) continue;
+        // zeroed, not only removed, tiles can be referenced for undo/redo
+        if(clampedCrop.intersects(tileRect)) {
+            const QRect relRect = clampedCrop.translated(-tileRect.topLeft());
+            zeroTileOutside(*tile.second, relRect);
+        } else if(tile.second->data()) {
+            tile.second->zeroData();
         }
-        moveY(dpt, false);
     }
 
-    {
-        const int db = clampedCrop.bottom() - iniRect.bottom();
-        const int dtb = db/TILE_SIZE;
-        const int dpb = db - dtb*TILE_SIZE;
+    autoCrop();
+}
 
-        moveY(-dpb, false);
-        for(int i = 0; i < -dtb; i++) {
-            zeroLastRow();
-            removeLastRow();
-        }
-        moveY(dpb, false);
+void AutoTilesData::translateTiles(const int dtx, const int dty) {
+    std::unordered_map<TileKey, stdsptr<Tile>> tiles;
+    tiles.reserve(mTiles.size());
+    for(const auto& tile : mTiles) {
+        const QPoint pos = sTilePos(tile.first);
+        // the tile bitmap at the new position is outdated
+        tile.second->setChanged(true);
+        tiles.emplace(sTileKey(pos.x() + dtx, pos.y() + dty), tile.second);
     }
-
-    autoCrop();
+    mTiles.swap(tiles);
+    mTileBoundingRect.translate(dtx, dty);
 }
 
-void AutoTilesData::moveX(const int dx, const bool extend) {
+void AutoTilesData::moveX(const int dx) {
     const int dtx = dx/TILE_SIZE;
     const int dpx = dx - dtx*TILE_SIZE;
 
-    mZeroTileCol -= dtx;
-
+    if(dtx != 0) translateTiles(dtx, 0);
     if(dpx == 0) return;
 
-    if(extend) {
-        prependColumns(1);
-        appendColumns(1);
-    }
-
-    const auto emptyTile = mTileCreator(TILE_SPIXEL_SIZE);
-    emptyTile->requestZeroedData();
-
-    if(dpx > 0) {
-        for(int i = mColumnCount - 1; i >= 0; i--) {
-            const bool isFirst = i == 0;
-            const auto& col = mColumns.at(i);
-            const auto& prevCol = isFirst ? col : mColumns.at(i - 1);
-            for(int j = 0; j < mRowCount; j++) {
-                const auto& dstTile = col.at(j);
-                // move pixels inside tile
-                if(uint16_t* const dstData = dstTile->data()) {
-                    const int dstXDP = TILE_SIZE*4;
-                    const int srcXDP = (TILE_SIZE - dpx)*4;
-                    for(int y = 0; y < TILE_SIZE; y++) {
-                        const int rowDP = y*TILE_SIZE*4;
-                        uint16_t* dst = dstData + rowDP + dstXDP;
-                        uint16_t* src = dstData + rowDP + srcXDP;
-                        for(int dstX = TILE_SIZE - 1; dstX >= dpx; dstX--) {
-                            for(int sp = 0; sp < 4; sp++) *(--dst) = *(--src);
-                        }
-                    }
-                }
-                uint16_t* const dstData = dstTile->requestZeroedData();
-
-                const auto& srcTile = isFirst ? emptyTile : prevCol.at(j);
-                uint16_t* const srcData = srcTile->requestZeroedData();
-
-                // move pixels from the previous tile
-                const int srcXDP = (TILE_SIZE - dpx)*4;
-                for(int y = 0; y < TILE_SIZE; y++) {
-                    const int rowDP = y*TILE_SIZE*4;
-                    uint16_t* dst = dstData + rowDP;
-                    uint16_t* src = srcData + rowDP + srcXDP;
-                    for(int dstX = 0; dstX < dpx; dstX++) {
-                        for(int sp = 0; sp < 4; sp++) *(dst++) = *(src++);
-                    }
-                }
-            }
-        }
-    } else if(dpx < 0) {
-        for(int i = 0; i < mColumnCount; i++) {
-            const bool isLast = i == (mColumnCount - 1);
-            const auto& col = mColumns.at(i);
-            const auto& nextCol = isLast ? col : mColumns.at(i + 1);
-            for(int j = 0; j < mRowCount; j++) {
-                const auto& dstTile = col.at(j);
-                // move pixels inside tile
-                const int maxX = TILE_SIZE + dpx;
-                if(uint16_t* const dstData = dstTile->data()) {
-                    const int srcXDP = -dpx*4;
-                    for(int y = 0; y < TILE_SIZE; y++) {
-                        const int rowDP = y*TILE_SIZE*4;
-                        uint16_t* dst = dstData + rowDP;
-                        uint16_t* src = dst + srcXDP;
-
-                        for(int dstX = 0; dstX < maxX; dstX++) {
-                            for(int sp = 0; sp < 4; sp++) *(dst++) = *(src++);
-                        }
-                    }
-                }
-
-                uint16_t* const dstData = dstTile->requestZeroedData();
-
-                const auto& srcTile = isLast ? emptyTile : nextCol.at(j);
-                uint16_t* const srcData = srcTile->requestZeroedData();
-
-                // move pixels from the next tile
-                const int dstX0 = TILE_SIZE + dpx;
-                const int dstXDP = dstX0*4;
-                for(int y = 0; y < TILE_SIZE; y++) {
-                    const int rowDP = y*TILE_SIZE*4;
-                    uint16_t* dst = dstData + rowDP + dstXDP;
-                    uint16_t* src = srcData + rowDP;
-                    for(int dstX = dstX0; dstX < TILE_SIZE; dstX++) {
-                        for(int sp = 0; sp < 4; sp++) *(dst++) = *(src++);
-                    }
-                }
+    // pixels move from every stored tile to its neighbour,
+    // tiles are processed so that their source neighbour is not moved yet
+    const int srcDTx = dpx > 0 ? -1 : 1;
+    std::vector<QPoint> dstTiles;
+    dstTiles.reserve(2*mTiles.size());
+    for(const auto& tile : mTiles) {
+        const QPoint pos = sTilePos(tile.first);
+        dstTiles.push_back(pos);
+        const QPoint neighbour(pos.x() - srcDTx, pos.y());
+        if(!getTile(neighbour.x(), neighbour.y())) dstTiles.push_back(neighbour);
+    }
+    std::sort(dstTiles.begin(), dstTiles.end(),
+              [srcDTx](const QPoint& a, const QPoint& b) {
+        return srcDTx*a.x() < srcDTx*b.x();
+    });
+
+    const int movedPx = qAbs(dpx);
+    const int keptPx = TILE_SIZE - movedPx;
+    const size_t movedBytes = static_cast<size_t>(movedPx)*4*sizeof(uint16_t);
+    const size_t keptBytes = static_cast<size_t>(keptPx)*4*sizeof(uint16_t);
+    for(const auto& pos : dstTiles) {
+        uint16_t* const dstData = tileAt(pos.x(), pos.y())->requestZeroedData();
+        const auto srcTile = getTile(pos.x() + srcDTx, pos.y());
+        const uint16_t* const srcData = srcTile ? srcTile->data() : nullptr;
+        for(int y = 0; y < TILE_SIZE; y++) {
+            uint16_t* const dstLine = dstData + y*TILE_SIZE*4;
+            const uint16_t* const srcLine = srcData ? srcData + y*TILE_SIZE*4 :
+                                                      nullptr;
+            if(dpx > 0) {
+                // move pixels inside tile and from the previous tile
+                memmove(dstLine + movedPx*4, dstLine, keptBytes);
+                if(srcLine) memcpy(dstLine, srcLine + keptPx*4, movedBytes);
+                else memset(dstLine, 0, movedBytes);
+            } else {
+                // move pixels inside tile and from the next tile
+                memmove(dstLine, dstLine + movedPx*4, keptBytes);
+                if(srcLine) memcpy(dstLine + keptPx*4, srcLine, movedBytes);
+                else memset(dstLine + keptPx*4, 0, movedBytes);
             }
         }
     }
 }
 
-void AutoTilesData::moveY(const int dy, const bool extend) {
+void AutoTilesData::moveY(const int dy) {
     const int dty = dy/TILE_SIZE;
     const int dpy = dy - dty*TILE_SIZE;
 
-    mZeroTileRow -= dty;
-
+    if(dty != 0) translateTiles(0, dty);
     if(dpy == 0) return;
 
-    if(extend) {
-        prependRows(1);
-        appendRows(1);
-    }
-
-    const auto emptyTile = mTileCreator(TILE_SPIXEL_SIZE);
-    emptyTile->requestZeroedData();
-
-    if(dpy > 0) {
-        for(const auto& col : mColumns) {
-            for(int j = mRowCount - 1; j >= 0; j--) {
-                const auto& dstTile = col.at(j);
-                // move pixels inside tile
-                if(uint16_t* const dstData = dstTile->data()) {
-                    for(int dstY = TILE_SIZE - 1; dstY >= dpy; dstY--) {
-                        uint16_t* dst = dstData + dstY*TILE_SIZE*4;
-                        uint16_t* src = dstData + (dstY - dpy)*TILE_SIZE*4;
-                        for(int x = 0; x < TILE_SIZE; x++) {
-                            for(int sp = 0; sp < 4; sp++) *(dst++) = *(src++);
-                        }
-                    }
-                }
-
-                uint16_t* const dstData = dstTile->requestZeroedData();
-
-                const bool isFirst = j == 0;
-                const auto& srcTile = isFirst ? emptyTile : col.at(j - 1);
-                uint16_t* const srcData = srcTile->requestZeroedData();
-
-                // move pixels from the previous tile
-                uint16_t* dst = dstData;
-                uint16_t* src = srcData + (TILE_SIZE - dpy)*TILE_SIZE*4;
-                for(int dstY = 0; dstY < dpy; dstY++) {
-                    for(int x = 0; x < TILE_SIZE; x++) {
-                        for(int sp = 0; sp < 4; sp++) *(dst++) = *(src++);
-                    }
-                }
-            }
-        }
-    } else if(dpy < 0) {
-        for(const auto& col : mColumns) {
-            for(int j = 0; j < mRowCount; j++) {
-                const auto& dstTile = col.at(j);
-                // move pixels inside tile
-                if(uint16_t* const dstData = dstTile->data()) {
-                    const int maxY = TILE_SIZE + dpy;
-                    uint16_t* dst = dstData;
-                    uint16_t* src = dstData - dpy*TILE_SIZE*4;
-                    for(int dstY = 0; dstY < maxY; dstY++) {
-                        for(int x = 0; x < TILE_SIZE; x++) {
-                            for(int sp = 0; sp < 4; sp++) *(dst++) = *(src++);
-                        }
-                    }
-                }
-
-                // the last row has no next row to get data from
-                uint16_t* const dstData = dstTile->requestZeroedData();
-
-                const bool isLast = j == (mRowCount - 1);
-                const auto& srcTile = isLast ? emptyTile : col.at(j + 1);
-                uint16_t* const srcData = srcTile->requestZeroedData();
-
-                // move pixels from the next tile
-                const int dstY0 = TILE_SIZE + dpy;
-                uint16_t* dst = dstData + dstY0*TILE_SIZE*4;
-                uint16_t* src = srcData;
-                for(int dstY = dstY0; dstY < TILE_SIZE; dstY++) {
-                    for(int x = 0; x < TILE_SIZE; x++) {
-                        for(int sp = 0; sp < 4; sp++) *(dst++) = *(src++);
-                    }
-                }
-            }
+    const int srcDTy = dpy > 0 ? -1 : 1;
+    std::vector<QPoint> dstTiles;
+    dstTiles.reserve(2*mTiles.size());
+    for(const auto& tile : mTiles) {
+        const QPoint pos = sTilePos(tile.first);
+        dstTiles.push_back(pos);
+        const QPoint neighbour(pos.x(), pos.y() - srcDTy);
+        if(!getTile(neighbour.x(), neighbour.y())) dstTiles.push_back(neighbour);
+    }
+    std::sort(dstTiles.begin(), dstTiles.end(),
+              [srcDTy](const QPoint& a, const QPoint& b) {
+        return srcDTy*a.y() < srcDTy*b.y();
+    });
+
+    const int movedPx = qAbs(dpy);
+    const int keptPx = TILE_SIZE - movedPx;
+    const int rowSPixels = TILE_SIZE*4;
+    const size_t movedBytes = static_cast<size_t>(movedPx*rowSPixels)*sizeof(uint16_t);
+    const size_t keptBytes = static_cast<size_t>(keptPx*rowSPixels)*sizeof(uint16_t);
+    for(const auto& pos : dstTiles) {
+        uint16_t* const dstData = tileAt(pos.x(), pos.y())->requestZeroedData();
+        const auto srcTile = getTile(pos.x(), pos.y() + srcDTy);
+        const uint16_t* const srcData = srcTile ? srcTile->data() : nullptr;
+        if(dpy > 0) {
+            // move rows inside tile and from the previous tile
+            memmove(dstData + movedPx*rowSPixels, dstData, keptBytes);
+            if(srcData) memcpy(dstData, srcData + keptPx*rowSPixels, movedBytes);
+            else memset(dstData, 0, movedBytes);
+        } else {
+            // move rows inside tile and from the next tile
+            memmove(dstData, dstData + movedPx*rowSPixels, keptBytes);
+            uint16_t* const dstLast = dstData + keptPx*rowSPixels;
+            if(srcData) memcpy(dstLast, srcData, movedBytes);
+            else memset(dstLast, 0, movedBytes);
         }
     }
 }
 
 void AutoTilesData::move(const int dx, const int dy) {
-    moveX(dx, true);
-    moveY(dy, true);
+    moveX(dx);
+    moveY(dy);
     if(dx % TILE_SIZE != 0 || dy % TILE_SIZE != 0) autoCrop();
 }
 
 stdsptr<Tile> AutoTilesData::requestTile(const int tx, const int ty) {
-    stretchToTile(tx, ty);
+    if(!stretchToTile(tx, ty)) return nullptr;
     return getTile(tx, ty);
 }
 
 bool AutoTilesData::stretchToTile(const int tx, const int ty) {
     if(tx > mMaxCol || tx < mMinCol) return false;
     if(ty > mMaxRow || ty < mMinRow) return false;
-
-    if(mColumns.isEmpty()) {
-        mZeroTileCol = -tx;
-        mZeroTileRow = -ty;
-        appendRows(1);
-        appendColumns(1);
-        return true;
-    }
-
-    const int colId = tx + mZeroTileCol;
-    const int rowId = ty + mZeroTileRow;
-
-    if(rowId < 0) {
-        prependRows(qAbs(rowId));
-    } else if(rowId >= mRowCount) {
-        appendRows(qAbs(rowId - mRowCount + 1));
-    }
-    if(colId < 0) {
-        prependColumns(qAbs(colId));
-    } else if(colId >= mColumnCount) {
-        appendColumns(qAbs(colId - mColumnCount + 1));
-    }
+    tileAt(tx, ty);
     return true;
 }
 
 void AutoTilesData::replaceTile(const int tx, const int ty,
                                 const stdsptr<Tile> &tile) {
-    stretchToTile(tx, ty);
-    getTile(tx, ty)->copyFrom(*tile);
-}
-
-QList<stdsptr<Tile>> AutoTilesData::newColumn() {
-    QList<stdsptr<Tile>> col;
-    for(int j = 0; j < mRowCount; j++) {
-        col.append(mTileCreator(TILE_SPIXEL_SIZE));
-    }
-    return col;
-}
-
-void AutoTilesData::prependRows(const int count) {
-    for(QList<stdsptr<Tile>>& col : mColumns) {
-        for(int i = 0; i < count; i++) {
-            col.prepend(mTileCreator(TILE_SPIXEL_SIZE));
-        }
-    }
-    mRowCount += count;
-    mZeroTileRow += count;
-}
-
-void AutoTilesData::appendRows(const int count) {
-    for(QList<stdsptr<Tile>>& col : mColumns) {
-        for(int i = 0; i < count; i++) {
-            col.append(mTileCreator(TILE_SPIXEL_SIZE));
-        }
-    }
-    mRowCount += count;
-}
-
-void AutoTilesData::prependColumns(const int count) {
-    for(int i = 0; i < count; i++) {
-        mColumns.prepend(newColumn());
-    }
-    mColumnCount += count;
-    mZeroTileCol += count;
-}
-
-void AutoTilesData::appendColumns(const int count) {
-    for(int i = 0; i < count; i++) {
-        mColumns.append(newColumn());
-    }
-    mColumnCount += count;
+    if(const auto dst = requestTile(tx, ty)) dst->copyFrom(*tile);
 }
@@ -18,10 +18,12 @@
 #define AUTOTILESDATA_H
 #include <QtCore>
 #include <QList>
+#include <unordered_map>
 #include "skia/skiaincludes.h"
 #include "../ReadWrite/basicreadwrite.h"
 #include "glhelpers.h"
 #include "tile.h"
+#include "tilepool.h"
 #include "smartPointers/stdselfref.h"
 
 #ifndef TILE_SIZE
@@ -76,13 +78,25 @@ struct CORE_EXPORT AutoTilesData {
 
     void setPixelClamp(const QRect& pixRect);
 
-    bool isEmpty() const { return mColumnCount == 0 || mRowCount == 0; }
+    bool isEmpty() const { return mTiles.empty(); }
+    //! @brief Number of stored (painted) tiles
+    int tileCount() const { return static_cast<int>(mTiles.size()); }
+
+    using TileFunc = std::function<void(const int tx, const int ty,
+                                        const stdsptr<Tile>& tile)>;
+    //! @brief Calls func for every stored tile, in no particular order
+    void forEachTile(const TileFunc& func) const;
 
     void swap(AutoTilesData& other);
 
     void write(eWriteStream &dst) const;
     void read(eReadStream& src);
 
+    void write(eWriteStream &dst, TilePoolWriter& pool) const;
+    void read(eReadStream& src, TilePoolReader& pool);
+
+    void loadCompressed(const CompressedTiles& tiles);
+
     void discardTransparentTiles();
     void autoCrop();
 
@@ -91,11 +105,11 @@ struct CORE_EXPORT AutoTilesData {
 protected:
     stdsptr<Tile> getTileByIndex(const int colId, const int rowId) const;
 private:
-    template <typename Addr, void (*From15Bit)(Addr* dstLine, const uint16_t* srcLine)>
+    template <typename Addr, void (*From15Bit)(const uint16_t* srcLine, Addr* dstLine, const int count)>
     void toBitmap(Addr * const dst, const QMargins &margin,
                   const int dstWidth, const int dstHeight) const;
 
-    template <typename Addr, void (*To15Bit)(Addr const *& srcLine, uint16_t*& dstLine)>
+    template <typename Addr, void (*To15Bit)(const Addr* srcLine, uint16_t* dstLine, const int count)>
     void loadPixmap(const Addr * const src, const int width, const int height);
 
     template <void (*Swapper)(uint8_t&, uint8_t&, uint8_t&, uint8_t&)>
@@ -107,43 +121,31 @@ private:
                                   const int width, const int height,
                                   const SkAlphaType alphaType);
 
-    void moveX(const int dx, const bool extend);
-    void moveY(const int dy, const bool extend);
-
-    bool columnEmpty(const int colId);
-    bool rowEmpty(const int rowId);
-
-    void removeFirstColumn();
-    void removeLastColumn();
-    void removeFirstRow();
-    void removeLastRow();
+    //! @brief Reads the dense grid stored before EvFormat::paintTilePool
+    void readDense(eReadStream& src);
 
-    void zeroFirstColumn();
-    void zeroLastColumn();
-    void zeroFirstRow();
-    void zeroLastRow();
+    void moveX(const int dx);
+    void moveY(const int dy);
+    void translateTiles(const int dtx, const int dty);
 
-    bool cropFirstColumnIfEmpty();
-    bool cropLastColumnIfEmpty();
-    bool cropFirstRowIfEmpty();
-    bool cropLastRowIfEmpty();
+    using TileKey = quint64;
+    static TileKey sTileKey(const int tx, const int ty);
+    static QPoint sTilePos(const TileKey key);
 
-    QList<stdsptr<Tile>> newColumn();
-    void prependRows(const int count);
-    void appendRows(const int count);
-    void prependColumns(const int count);
-    void appendColumns(const int count);
+    //! @brief Returns the tile at (tx, ty), creates it if not stored yet
+    const stdsptr<Tile>& tileAt(const int tx, const int ty);
+    void insertTile(const int tx, const int ty, const stdsptr<Tile>& tile);
+    void updateTileBoundingRect();
 
     int mMinCol = -100;
     int mMaxCol = 100;
     int mMinRow = -100;
     int mMaxRow = 100;
 
-    int mZeroTileCol = 0;
-    int mZeroTileRow = 0;
-    int mColumnCount = 0;
-    int mRowCount = 0;
-    QList<QList<stdsptr<Tile>>> mColumns;
+    //! @brief Only the requested tiles, keyed by their tile coordinates
+    std::unordered_map<TileKey, stdsptr<Tile>> mTiles;
+    //! @brief Tile bounding rect of mTiles
+    QRect mTileBoundingRect;
 
     const TileCreator mTileCreator;
 };
@@ -16,6 +16,461 @@
 
 #include "colorconversions.h"
 
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define COLORCONV_SSE2
+    #include <emmintrin.h>
+    #if defined(__GNUC__)
+        #define COLORCONV_AVX2
+        #define COLORCONV_AVX2_FUNC __attribute__((target("avx2")))
+        #include <immintrin.h>
+    #endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #define COLORCONV_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace {
+
+using Rgba8To16Kernel = void(*)(const uint8_t* src, uint16_t* dst,
+                                const int count);
+using Rgba16To8Kernel = void(*)(const uint16_t* src, uint8_t* dst,
+                                const int count);
+
+// Scalar reference, every vector kernel has to produce identical output,
+// including the wrap around of out of range 15-bit values
+
+void rgba8To16Scalar(const uint8_t* src, uint16_t* dst, const int count) {
+    for(int j = 0; j < count; j++) {
+        uint32_t r, g, b, a;
+        r = *src++;
+        g = *src++;
+        b = *src++;
+        a = *src++;
+
+        // convert to fixed point (with rounding)
+        r = (r * (1<<15) + 255/2) / 255;
+        g = (g * (1<<15) + 255/2) / 255;
+        b = (b * (1<<15) + 255/2) / 255;
+        a = (a * (1<<15) + 255/2) / 255;
+
+        // premultiply alpha (with rounding), save back
+        *dst++ = (r * a + (1<<15)/2) / (1<<15);
+        *dst++ = (g * a + (1<<15)/2) / (1<<15);
+        *dst++ = (b * a + (1<<15)/2) / (1<<15);
+        *dst++ = a;
+    }
+}
+
+void rgba16To8UnpremultipliedScalar(const uint16_t* src, uint8_t* dst,
+                                    const int count) {
+    for(int j = 0; j < count; j++) {
+        uint32_t r, g, b, a;
+        r = *src++;
+        g = *src++;
+        b = *src++;
+        a = *src++;
+
+        // un-premultiply alpha (with rounding)
+        if(a != 0) {
+            r = ((r << 15) + a/2) / a;
+            g = ((g << 15) + a/2) / a;
+            b = ((b << 15) + a/2) / a;
+        } else {
+            r = g = b = 0;
+        }
+
+        *dst++ = (r * 255 + (1<<15)/2) / (1<<15);
+        *dst++ = (g * 255 + (1<<15)/2) / (1<<15);
+        *dst++ = (b * 255 + (1<<15)/2) / (1<<15);
+        *dst++ = (a * 255 + (1<<15)/2) / (1<<15);
+    }
+}
+
+void rgba16To8PremultipliedScalar(const uint16_t* src, uint8_t* dst,
+                                  const int count) {
+    for(int j = 0; j < 4*count; j++) {
+        const uint32_t c = *src++;
+        *dst++ = (c * 255 + (1<<15)/2) / (1<<15);
+    }
+}
+
+#if defined(COLORCONV_SSE2)
+// 15-bit (at most 32-bit intermediate) to 8-bit, truncated like uint8_t
+inline __m128i sse2To8(const __m128i v) {
+    const __m128i v255 = _mm_sub_epi32(_mm_slli_epi32(v, 8), v);
+    const __m128i half = _mm_set1_epi32(1 << 14);
+    const __m128i shifted = _mm_srli_epi32(_mm_add_epi32(v255, half), 15);
+    return _mm_and_si128(shifted, _mm_set1_epi32(0xFF));
+}
+
+// two pixels of 8-bit channels widened to 16-bit lanes
+inline __m128i sse2Premultiply8To16(const __m128i x) {
+    // (x*2^15 + 127)/255 == 128x + (128x + 127)/255
+    const __m128i x128 = _mm_slli_epi16(x, 7);
+    const __m128i n = _mm_add_epi16(x128, _mm_set1_epi16(127));
+    const __m128i magic = _mm_set1_epi16(static_cast<short>(0x8081));
+    const __m128i div255 = _mm_srli_epi16(_mm_mulhi_epu16(n, magic), 7);
+    const __m128i v = _mm_add_epi16(x128, div255);
+
+    __m128i a = _mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+    const __m128i lo = _mm_mullo_epi16(v, a);
+    const __m128i hi = _mm_mulhi_epu16(v, a);
+    const __m128i half = _mm_set1_epi32(1 << 14);
+    // results are at most 2^15, bias for the signed saturating pack
+    const __m128i bias = _mm_set1_epi32(1 << 15);
+    __m128i p0 = _mm_add_epi32(_mm_unpacklo_epi16(lo, hi), half);
+    __m128i p1 = _mm_add_epi32(_mm_unpackhi_epi16(lo, hi), half);
+    p0 = _mm_sub_epi32(_mm_srli_epi32(p0, 15), bias);
+    p1 = _mm_sub_epi32(_mm_srli_epi32(p1, 15), bias);
+    const __m128i p = _mm_add_epi16(_mm_packs_epi32(p0, p1),
+                                    _mm_set1_epi16(static_cast<short>(0x8000)));
+    const __m128i alphaMask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    return _mm_or_si128(_mm_and_si128(alphaMask, v),
+                        _mm_andnot_si128(alphaMask, p));
+}
+
+void rgba8To16Sse2(const uint8_t* src, uint16_t* dst, const int count) {
+    const __m128i zero = _mm_setzero_si128();
+    int j = 0;
+    for(; j + 4 <= count; j += 4) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        const __m128i v0 = sse2Premultiply8To16(_mm_unpacklo_epi8(x, zero));
+        const __m128i v1 = sse2Premultiply8To16(_mm_unpackhi_epi8(x, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), v0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8), v1);
+        src += 16;
+        dst += 16;
+    }
+    rgba8To16Scalar(src, dst, count - j);
+}
+
+// one pixel in 32-bit lanes, lanes are divided with double precision,
+// exact for the at most 31-bit numerators and 16-bit divisors
+inline __m128i sse2UnpremultiplyTo8(const __m128i v) {
+    const __m128i a = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+    const __m128i n = _mm_add_epi32(_mm_slli_epi32(v, 15),
+                                    _mm_srli_epi32(a, 1));
+    const __m128d aD = _mm_cvtepi32_pd(a);
+    const __m128i n23 = _mm_shuffle_epi32(n, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m128d q01 = _mm_div_pd(_mm_cvtepi32_pd(n), aD);
+    const __m128d q23 = _mm_div_pd(_mm_cvtepi32_pd(n23), aD);
+    __m128i q = _mm_unpacklo_epi64(_mm_cvttpd_epi32(q01),
+                                   _mm_cvttpd_epi32(q23));
+    const __m128i alphaMask = _mm_set_epi32(-1, 0, 0, 0);
+    q = _mm_or_si128(_mm_and_si128(alphaMask, v),
+                     _mm_andnot_si128(alphaMask, q));
+    const __m128i transparent = _mm_cmpeq_epi32(a, _mm_setzero_si128());
+    return sse2To8(_mm_andnot_si128(transparent, q));
+}
+
+void rgba16To8UnpremultipliedSse2(const uint16_t* src, uint8_t* dst,
+                                  const int count) {
+    const __m128i zero = _mm_setzero_si128();
+    int j = 0;
+    for(; j + 4 <= count; j += 4) {
+        const auto src128 = reinterpret_cast<const __m128i*>(src);
+        const __m128i x0 = _mm_loadu_si128(src128);
+        const __m128i x1 = _mm_loadu_si128(src128 + 1);
+        const __m128i p0 = sse2UnpremultiplyTo8(_mm_unpacklo_epi16(x0, zero));
+        const __m128i p1 = sse2UnpremultiplyTo8(_mm_unpackhi_epi16(x0, zero));
+        const __m128i p2 = sse2UnpremultiplyTo8(_mm_unpacklo_epi16(x1, zero));
+        const __m128i p3 = sse2UnpremultiplyTo8(_mm_unpackhi_epi16(x1, zero));
+        const __m128i p = _mm_packus_epi16(_mm_packs_epi32(p0, p1),
+                                           _mm_packs_epi32(p2, p3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), p);
+        src += 16;
+        dst += 16;
+    }
+    rgba16To8UnpremultipliedScalar(src, dst, count - j);
+}
+
+void rgba16To8PremultipliedSse2(const uint16_t* src, uint8_t* dst,
+                                const int count) {
+    const __m128i zero = _mm_setzero_si128();
+    int j = 0;
+    for(; j + 4 <= count; j += 4) {
+        const auto src128 = reinterpret_cast<const __m128i*>(src);
+        const __m128i x0 = _mm_loadu_si128(src128);
+        const __m128i x1 = _mm_loadu_si128(src128 + 1);
+        const __m128i p0 = sse2To8(_mm_unpacklo_epi16(x0, zero));
+        const __m128i p1 = sse2To8(_mm_unpackhi_epi16(x0, zero));
+        const __m128i p2 = sse2To8(_mm_unpacklo_epi16(x1, zero));
+        const __m128i p3 = sse2To8(_mm_unpackhi_epi16(x1, zero));
+        const __m128i p = _mm_packus_epi16(_mm_packs_epi32(p0, p1),
+                                           _mm_packs_epi32(p2, p3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), p);
+        src += 16;
+        dst += 16;
+    }
+    rgba16To8PremultipliedScalar(src, dst, count - j);
+}
+#endif
+
+#if defined(COLORCONV_AVX2)
+COLORCONV_AVX2_FUNC
+inline __m256i avx2To8(const __m256i v) {
+    const __m256i v255 = _mm256_sub_epi32(_mm256_slli_epi32(v, 8), v);
+    const __m256i half = _mm256_set1_epi32(1 << 14);
+    const __m256i shifted = _mm256_srli_epi32(_mm256_add_epi32(v255, half), 15);
+    return _mm256_and_si256(shifted, _mm256_set1_epi32(0xFF));
+}
+
+// four pixels of 8-bit channels widened to 16-bit lanes
+COLORCONV_AVX2_FUNC
+inline __m256i avx2Premultiply8To16(const __m256i x) {
+    const __m256i x128 = _mm256_slli_epi16(x, 7);
+    const __m256i n = _mm256_add_epi16(x128, _mm256_set1_epi16(127));
+    const __m256i magic = _mm256_set1_epi16(static_cast<short>(0x8081));
+    const __m256i div255 = _mm256_srli_epi16(_mm256_mulhi_epu16(n, magic), 7);
+    const __m256i v = _mm256_add_epi16(x128, div255);
+
+    __m256i a = _mm256_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm256_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+    const __m256i lo = _mm256_mullo_epi16(v, a);
+    const __m256i hi = _mm256_mulhi_epu16(v, a);
+    const __m256i half = _mm256_set1_epi32(1 << 14);
+    const __m256i bias = _mm256_set1_epi32(1 << 15);
+    // unpack and pack are both per 128-bit lane, the order is kept
+    __m256i p0 = _mm256_add_epi32(_mm256_unpacklo_epi16(lo, hi), half);
+    __m256i p1 = _mm256_add_epi32(_mm256_unpackhi_epi16(lo, hi), half);
+    p0 = _mm256_sub_epi32(_mm256_srli_epi32(p0, 15), bias);
+    p1 = _mm256_sub_epi32(_mm256_srli_epi32(p1, 15), bias);
+    const __m256i p = _mm256_add_epi16(
+                _mm256_packs_epi32(p0, p1),
+                _mm256_set1_epi16(static_cast<short>(0x8000)));
+    const __m256i alphaMask = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0,
+                                               -1, 0, 0, 0, -1, 0, 0, 0);
+    return _mm256_or_si256(_mm256_and_si256(alphaMask, v),
+                           _mm256_andnot_si256(alphaMask, p));
+}
+
+COLORCONV_AVX2_FUNC
+void rgba8To16Avx2(const uint8_t* src, uint16_t* dst, const int count) {
+    int j = 0;
+    for(; j + 8 <= count; j += 8) {
+        const auto src128 = reinterpret_cast<const __m128i*>(src);
+        const __m256i x0 = _mm256_cvtepu8_epi16(_mm_loadu_si128(src128));
+        const __m256i x1 = _mm256_cvtepu8_epi16(_mm_loadu_si128(src128 + 1));
+        const auto dst256 = reinterpret_cast<__m256i*>(dst);
+        _mm256_storeu_si256(dst256, avx2Premultiply8To16(x0));
+        _mm256_storeu_si256(dst256 + 1, avx2Premultiply8To16(x1));
+        src += 32;
+        dst += 32;
+    }
+    rgba8To16Sse2(src, dst, count - j);
+}
+
+// packs four vectors of two pixels in 32-bit lanes into eight 8-bit pixels
+COLORCONV_AVX2_FUNC
+inline __m256i avx2Pack8(const __m256i p0, const __m256i p1,
+                         const __m256i p2, const __m256i p3) {
+    const __m256i p = _mm256_packus_epi16(_mm256_packs_epi32(p0, p1),
+                                          _mm256_packs_epi32(p2, p3));
+    // pack instructions interleave 128-bit lanes, restore linear order
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    return _mm256_permutevar8x32_epi32(p, order);
+}
+
+COLORCONV_AVX2_FUNC
+void rgba16To8PremultipliedAvx2(const uint16_t* src, uint8_t* dst,
+                                const int count) {
+    int j = 0;
+    for(; j + 8 <= count; j += 8) {
+        const auto src128 = reinterpret_cast<const __m128i*>(src);
+        __m256i p[4];
+        for(int i = 0; i < 4; i++) {
+            const __m128i x = _mm_loadu_si128(src128 + i);
+            p[i] = avx2To8(_mm256_cvtepu16_epi32(x));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                            avx2Pack8(p[0], p[1], p[2], p[3]));
+        src += 32;
+        dst += 32;
+    }
+    rgba16To8PremultipliedSse2(src, dst, count - j);
+}
+
+// one pixel, all four lanes divided at once
+COLORCONV_AVX2_FUNC
+inline __m128i avx2UnpremultiplyTo8(const __m128i v) {
+    const __m128i a = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+    const __m128i n = _mm_add_epi32(_mm_slli_epi32(v, 15),
+                                    _mm_srli_epi32(a, 1));
+    const __m256d q = _mm256_div_pd(_mm256_cvtepi32_pd(n),
+                                    _mm256_cvtepi32_pd(a));
+    __m128i qi = _mm256_cvttpd_epi32(q);
+    const __m128i alphaMask = _mm_set_epi32(-1, 0, 0, 0);
+    qi = _mm_or_si128(_mm_and_si128(alphaMask, v),
+                      _mm_andnot_si128(alphaMask, qi));
+    const __m128i transparent = _mm_cmpeq_epi32(a, _mm_setzero_si128());
+    return sse2To8(_mm_andnot_si128(transparent, qi));
+}
+
+COLORCONV_AVX2_FUNC
+void rgba16To8UnpremultipliedAvx2(const uint16_t* src, uint8_t* dst,
+                                  const int count) {
+    const __m128i zero = _mm_setzero_si128();
+    int j = 0;
+    for(; j + 4 <= count; j += 4) {
+        const auto src128 = reinterpret_cast<const __m128i*>(src);
+        const __m128i x0 = _mm_loadu_si128(src128);
+        const __m128i x1 = _mm_loadu_si128(src128 + 1);
+        const __m128i p0 = avx2UnpremultiplyTo8(_mm_unpacklo_epi16(x0, zero));
+        const __m128i p1 = avx2UnpremultiplyTo8(_mm_unpackhi_epi16(x0, zero));
+        const __m128i p2 = avx2UnpremultiplyTo8(_mm_unpacklo_epi16(x1, zero));
+        const __m128i p3 = avx2UnpremultiplyTo8(_mm_unpackhi_epi16(x1, zero));
+        const __m128i p = _mm_packus_epi16(_mm_packs_epi32(p0, p1),
+                                           _mm_packs_epi32(p2, p3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), p);
+        src += 16;
+        dst += 16;
+    }
+    rgba16To8UnpremultipliedScalar(src, dst, count - j);
+}
+#endif
+
+#if defined(COLORCONV_NEON)
+inline uint32x4_t neonTo8(const uint32x4_t v) {
+    const uint32x4_t v255 = vmulq_n_u32(v, 255);
+    const uint32x4_t shifted = vshrq_n_u32(vaddq_u32(v255, vdupq_n_u32(1 << 14)), 15);
+    return vandq_u32(shifted, vdupq_n_u32(0xFF));
+}
+
+inline uint8x8_t neonNarrow(const uint32x4_t p0, const uint32x4_t p1) {
+    return vmovn_u16(vcombine_u16(vmovn_u32(p0), vmovn_u32(p1)));
+}
+
+void rgba8To16Neon(const uint8_t* src, uint16_t* dst, const int count) {
+    int j = 0;
+    for(; j + 2 <= count; j += 2) {
+        const uint16x8_t x = vmovl_u8(vld1_u8(src));
+        uint16x4_t result[2];
+        for(int i = 0; i < 2; i++) {
+            const uint32x4_t xi = vmovl_u16(i ? vget_high_u16(x) : vget_low_u16(x));
+            // (x*2^15 + 127)/255 == 128x + (128x + 127)/255
+            const uint32x4_t x128 = vshlq_n_u32(xi, 7);
+            const uint32x4_t n = vaddq_u32(x128, vdupq_n_u32(127));
+            const uint32x4_t div255 = vshrq_n_u32(vmulq_n_u32(n, 0x8081), 23);
+            const uint32x4_t v = vaddq_u32(x128, div255);
+            const uint32x4_t a = vdupq_laneq_u32(v, 3);
+            uint32x4_t p = vmulq_u32(v, a);
+            p = vshrq_n_u32(vaddq_u32(p, vdupq_n_u32(1 << 14)), 15);
+            p = vsetq_lane_u32(vgetq_lane_u32(v, 3), p, 3);
+            result[i] = vmovn_u32(p);
+        }
+        vst1q_u16(dst, vcombine_u16(result[0], result[1]));
+        src += 8;
+        dst += 8;
+    }
+    rgba8To16Scalar(src, dst, count - j);
+}
+
+inline uint32x4_t neonUnpremultiplyTo8(const uint32x4_t v) {
+    const uint32x4_t a = vdupq_laneq_u32(v, 3);
+    const uint32x4_t n = vaddq_u32(vshlq_n_u32(v, 15), vshrq_n_u32(a, 1));
+    const float64x2_t aD = vcvtq_f64_u64(vmovl_u32(vget_low_u32(a)));
+    const float64x2_t n01 = vcvtq_f64_u64(vmovl_u32(vget_low_u32(n)));
+    const float64x2_t n23 = vcvtq_f64_u64(vmovl_u32(vget_high_u32(n)));
+    const uint32x2_t q01 = vmovn_u64(vcvtq_u64_f64(vdivq_f64(n01, aD)));
+    const uint32x2_t q23 = vmovn_u64(vcvtq_u64_f64(vdivq_f64(n23, aD)));
+    uint32x4_t q = vcombine_u32(q01, q23);
+    q = vsetq_lane_u32(vgetq_lane_u32(v, 3), q, 3);
+    const uint32x4_t transparent = vceqq_u32(a, vdupq_n_u32(0));
+    return neonTo8(vbicq_u32(q, transparent));
+}
+
+void rgba16To8UnpremultipliedNeon(const uint16_t* src, uint8_t* dst,
+                                  const int count) {
+    int j = 0;
+    for(; j + 2 <= count; j += 2) {
+        const uint16x8_t x = vld1q_u16(src);
+        const uint32x4_t p0 = neonUnpremultiplyTo8(vmovl_u16(vget_low_u16(x)));
+        const uint32x4_t p1 = neonUnpremultiplyTo8(vmovl_u16(vget_high_u16(x)));
+        vst1_u8(dst, neonNarrow(p0, p1));
+        src += 8;
+        dst += 8;
+    }
+    rgba16To8UnpremultipliedScalar(src, dst, count - j);
+}
+
+void rgba16To8PremultipliedNeon(const uint16_t* src, uint8_t* dst,
+                                const int count) {
+    int j = 0;
+    for(; j + 2 <= count; j += 2) {
+        const uint16x8_t x = vld1q_u16(src);
+        const uint32x4_t p0 = neonTo8(vmovl_u16(vget_low_u16(x)));
+        const uint32x4_t p1 = neonTo8(vmovl_u16(vget_high_u16(x)));
+        vst1_u8(dst, neonNarrow(p0, p1));
+        src += 8;
+        dst += 8;
+    }
+    rgba16To8PremultipliedScalar(src, dst, count - j);
+}
+#endif
+
+struct Kernels {
+    Rgba8To16Kernel f8To16;
+    Rgba16To8Kernel fUnpremultiplied;
+    Rgba16To8Kernel fPremultiplied;
+    const char* fName;
+};
+
+//! @brief Kernel sets supported by this CPU, the best one is last
+std::vector<Kernels> supportedKernels() {
+    std::vector<Kernels> result;
+    result.push_back({rgba8To16Scalar, rgba16To8UnpremultipliedScalar,
+                      rgba16To8PremultipliedScalar, "scalar"});
+#if defined(COLORCONV_SSE2)
+    result.push_back({rgba8To16Sse2, rgba16To8UnpremultipliedSse2,
+                      rgba16To8PremultipliedSse2, "SSE2"});
+#endif
+#if defined(COLORCONV_AVX2)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        result.push_back({rgba8To16Avx2, rgba16To8UnpremultipliedAvx2,
+                          rgba16To8PremultipliedAvx2, "AVX2"});
+    }
+#endif
+#if defined(COLORCONV_NEON)
+    result.push_back({rgba8To16Neon, rgba16To8UnpremultipliedNeon,
+                      rgba16To8PremultipliedNeon, "NEON"});
+#endif
+    return result;
+}
+
+const Kernels& kernels() {
+    static const Kernels kernels = supportedKernels().back();
+    return kernels;
+}
+
+// deterministic test data, independent of the standard library
+uint32_t nextRandom(uint32_t& state) {
+    state = state*1664525u + 1013904223u;
+    return state >> 8;
+}
+
+template <typename Src, typename Dst, typename Kernel>
+bool sameOutput(const std::vector<Src>& src, const Kernel kernel,
+                const Kernel reference) {
+    const int count = static_cast<int>(src.size()/4);
+    // odd offsets and counts exercise unaligned loads and scalar tails
+    for(const int offset : {0, 1, 3}) {
+        const int iCount = count - offset;
+        std::vector<Dst> dst(4*static_cast<size_t>(iCount));
+        std::vector<Dst> expected(dst.size());
+        const Src* const iSrc = src.data() + 4*offset;
+        kernel(iSrc, dst.data(), iCount);
+        reference(iSrc, expected.data(), iCount);
+        if(dst != expected) return false;
+    }
+    return true;
+}
+
+}
 
 // used mainly for loading layers (transparent PNG)
 void rgba8_to_rgba16(uint8_t* src,
@@ -23,75 +478,25 @@ void rgba8_to_rgba16(uint8_t* src,
                      uint16_t* dst,
                      const int dstWidth,
                      const int height) {
+    const auto kernel = kernels().f8To16;
     for(int i = 0; i < height; i++) {
-        uint8_t *srcLine = src + i * srcWidth * 4;
+        const uint8_t *srcLine = src + i * srcWidth * 4;
         uint16_t *dstLine = dst + i * dstWidth * 4;
-        for(int j = 0; j < dstWidth; j++) {
-            uint32_t r, g, b, a;
-            r = *srcLine++;
-            g = *srcLine++;
-            b = *srcLine++;
-            a = *srcLine++;
-
-            // convert to fixed point (with rounding)
-            r = (r * (1<<15) + 255/2) / 255;
-            g = (g * (1<<15) + 255/2) / 255;
-            b = (b * (1<<15) + 255/2) / 255;
-            a = (a * (1<<15) + 255/2) / 255;
-
-            // premultiply alpha (with rounding), save back
-            *dstLine++ = (r * a + (1<<15)/2) / (1<<15);
-            *dstLine++ = (g * a + (1<<15)/2) / (1<<15);
-            *dstLine++ = (b * a + (1<<15)/2) / (1<<15);
-            *dstLine++ = a;
-        }
+        kernel(srcLine, dstLine, dstWidth);
     }
 }
 
-// Naive conversion code from the internal MyPaint format and 8 bit RGB
 void rgba16_to_rgba8_unpremultiplied(
         uint16_t* src,
         const int srcWidth,
         uint8_t* dst,
         const int dstWidth,
         const int height) {
+    const auto kernel = kernels().fUnpremultiplied;
     for(int i = 0; i < height; i++) {
-        uint16_t *srcLine = src + i * srcWidth * 4;
+        const uint16_t *srcLine = src + i * srcWidth * 4;
         uint8_t *dstLine = dst + i * dstWidth * 4;
-        for(int j = 0; j < srcWidth; j++) {
-            uint32_t r, g, b, a;
-
-            r = *srcLine++;
-            g = *srcLine++;
-            b = *srcLine++;
-            a = *srcLine++;
-
-            // un-premultiply alpha (with rounding)
-            if(a != 0) {
-//                r = ((r << 15)) / a;
-//                g = ((g << 15)) / a;
-//                b = ((b << 15)) / a;
-                r = ((r << 15) + a/2) / a;
-                g = ((g << 15) + a/2) / a;
-                b = ((b << 15) + a/2) / a;
-            } else {
-                r = g = b = 0;
-            }
-
-            // Variant A) rounding
-            const uint32_t add_r = (1<<15)/2;
-            const uint32_t add_g = (1<<15)/2;
-            const uint32_t add_b = (1<<15)/2;
-            const uint32_t add_a = (1<<15)/2;
-            *dstLine++ = (r * 255 + add_r) / (1<<15);
-            *dstLine++ = (g * 255 + add_g) / (1<<15);
-            *dstLine++ = (b * 255 + add_b) / (1<<15);
-            *dstLine++ = (a * 255 + add_a) / (1<<15);
-//            *dstLine++ = (r * 255) / (1<<15);
-//            *dstLine++ = (g * 255) / (1<<15);
-//            *dstLine++ = (b * 255) / (1<<15);
-//            *dstLine++ = (a * 255) / (1<<15);
-        }
+        kernel(srcLine, dstLine, srcWidth);
     }
 }
 
@@ -101,26 +506,65 @@ void rgba16_to_rgba8_premultiplied(
         uint8_t* dst,
         const int dstWidth,
         const int height) {
+    const auto kernel = kernels().fPremultiplied;
     for(int i = 0; i < height; i++) {
-        uint16_t *srcLine = src + i * srcWidth * 4;
+        const uint16_t *srcLine = src + i * srcWidth * 4;
         uint8_t *dstLine = dst + i * dstWidth * 4;
-        for(int j = 0; j < srcWidth; j++) {
-            uint32_t r, g, b, a;
-
-            r = *srcLine++;
-            g = *srcLine++;
-            b = *srcLine++;
-            a = *srcLine++;
-
-            const uint32_t add_r = (1<<15)/2;
-            const uint32_t add_g = (1<<15)/2;
-            const uint32_t add_b = (1<<15)/2;
-            const uint32_t add_a = (1<<15)/2;
-            *dstLine++ = (r * 255 + add_r) / (1<<15);
-            *dstLine++ = (g * 255 + add_g) / (1<<15);
-            *dstLine++ = (b * 255 + add_b) / (1<<15);
-            *dstLine++ = (a * 255 + add_a) / (1<<15);
-        }
+        kernel(srcLine, dstLine, srcWidth);
     }
 }
 
+void rgba8_to_rgba16_row(const uint8_t* src, uint16_t* dst,
+                         const int count) {
+    kernels().f8To16(src, dst, count);
+}
+
+void rgba16_to_rgba8_unpremultiplied_row(const uint16_t* src, uint8_t* dst,
+                                         const int count) {
+    kernels().fUnpremultiplied(src, dst, count);
+}
+
+void rgba16_to_rgba8_premultiplied_row(const uint16_t* src, uint8_t* dst,
+                                       const int count) {
+    kernels().fPremultiplied(src, dst, count);
+}
+
+const char* colorconversions_instruction_set() {
+    return kernels().fName;
+}
+
+bool colorconversions_compare_with_scalar() {
+    // every colour and alpha combination
+    std::vector<uint8_t> src8;
+    src8.reserve(4*256*256);
+    for(int a = 0; a < 256; a++) {
+        for(int c = 0; c < 256; c++) {
+            src8.insert(src8.end(), {uint8_t(c), uint8_t(255 - c),
+                                     uint8_t(c ^ 0x5A), uint8_t(a)});
+        }
+    }
+    // valid premultiplied values for every 15-bit alpha,
+    // followed by random, also out of range, values
+    std::vector<uint16_t> src16;
+    uint32_t state = 2020;
+    for(uint32_t a = 0; a <= (1 << 15); a++) {
+        const uint32_t c = a ? nextRandom(state) % (a + 1) : 0;
+        src16.insert(src16.end(), {uint16_t(c), uint16_t(a - c),
+                                   uint16_t(a/2), uint16_t(a)});
+    }
+    for(int i = 0; i < 4*(1 << 15); i++) {
+        src16.push_back(static_cast<uint16_t>(nextRandom(state)));
+    }
+
+    const auto all = supportedKernels();
+    const auto& reference = all.front();
+    for(const auto& iKernels : all) {
+        if(!sameOutput<uint8_t, uint16_t>(src8, iKernels.f8To16,
+                                          reference.f8To16)) return false;
+        if(!sameOutput<uint16_t, uint8_t>(src16, iKernels.fUnpremultiplied,
+                                          reference.fUnpremultiplied)) return false;
+        if(!sameOutput<uint16_t, uint8_t>(src16, iKernels.fPremultiplied,
+                                          reference.fPremultiplied)) return false;
+    }
+    return true;
+}
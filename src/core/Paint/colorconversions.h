@@ -18,6 +18,7 @@
 #define COLORCONVERSIONS_H
 
 #include <qglobal.h>
+#include "../core_global.h"
 
 #if defined(Q_OS_LINUX)
     #include <stdint-gcc.h>
@@ -44,4 +45,24 @@ void rgba16_to_rgba8_premultiplied(
         const int dstWidth,
         const int height);
 
+//! @brief Row conversions of count pixels, done with the best
+//! instruction set supported by the CPU, selected on first use.
+//! Output is identical to the scalar code for all inputs.
+void rgba8_to_rgba16_row(const uint8_t* src, uint16_t* dst,
+                         const int count);
+void rgba16_to_rgba8_unpremultiplied_row(const uint16_t* src, uint8_t* dst,
+                                         const int count);
+void rgba16_to_rgba8_premultiplied_row(const uint16_t* src, uint8_t* dst,
+                                       const int count);
+
+//! @brief Name of the instruction set used for the conversions
+CORE_EXPORT
+const char* colorconversions_instruction_set();
+
+//! @brief Compares every kernel supported by the CPU
+//! with the scalar code on exhaustive and random input,
+//! returns true if all outputs are bit-exact.
+CORE_EXPORT
+bool colorconversions_compare_with_scalar();
+
 #endif // COLORCONVERSIONS_H
@@ -16,6 +16,7 @@
 
 #include "drawableautotiledsurface.h"
 #include "skia/skiahelpers.h"
+#include "ReadWrite/evformat.h"
 
 DrawableAutoTiledSurface::DrawableAutoTiledSurface() :
     mRowCount(mTileBitmaps.fRowCount),
@@ -29,14 +30,19 @@ DrawableAutoTiledSurface::DrawableAutoTiledSurface() :
 DrawableAutoTiledSurface::DrawableAutoTiledSurface(
         const DrawableAutoTiledSurface &other) :
     DrawableAutoTiledSurface() {
-    mSurface = other.mSurface;
-    mTileBitmaps = other.mTileBitmaps;
+    *this = other;
 }
 
 DrawableAutoTiledSurface &DrawableAutoTiledSurface::operator=(
         const DrawableAutoTiledSurface &other) {
+    if(!other.storesDataInMemory() && other.mCompressedTiles) {
+        setCompressedTiles(other.mCompressedTiles);
+        return *this;
+    }
     mSurface = other.mSurface;
     mTileBitmaps = other.mTileBitmaps;
+    mCompressedTiles = other.mCompressedTiles;
+    mChangeId++;
     afterDataReplaced();
     return *this;
 }
@@ -65,32 +71,113 @@ void DrawableAutoTiledSurface::drawOnCanvas(SkCanvas * const canvas,
 
 void DrawableAutoTiledSurface::pixelRectChanged(const QRect &pixRect) {
     if(mTmpFile) scheduleDeleteTmpFile();
-    updateTileRecBitmaps(pixRectToTileRect(pixRect));
+    dataChanged();
+    if(inUse() || hasTileBitmaps())
+        updateTileRecBitmaps(pixRectToTileRect(pixRect));
+}
+
+void DrawableAutoTiledSurface::finishPendingChanges() {
+    if(!mFinishPendingChanges) return;
+    const auto finish = mFinishPendingChanges;
+    mFinishPendingChanges = nullptr;
+    finish();
 }
 
 void DrawableAutoTiledSurface::write(eWriteStream &dst) {
-    if(!storesDataInMemory()) {
+    finishPendingChanges();
+    if(mCompressedTiles) {
+        TilePoolWriter pool;
+        pool.writeTiles(dst, *mCompressedTiles);
+    } else if(!storesDataInMemory()) {
         if(!mTmpFile) RuntimeThrow("No tmp file, and no data in memory");
         dst.writeFile(mTmpFile.get());
     } else mSurface.write(dst);
 }
 
 void DrawableAutoTiledSurface::read(eReadStream &src) {
+    finishPendingChanges();
+    dataChanged();
     mSurface.read(src);
     afterDataReplaced();
-    updateTileBitmaps();
+    updateShownTileBitmaps();
+}
+
+void DrawableAutoTiledSurface::write(eWriteStream &dst, TilePoolWriter &pool) {
+    finishPendingChanges();
+    if(mCompressedTiles) {
+        // unchanged since read, no need to compress again
+        pool.writeTiles(dst, *mCompressedTiles);
+        return;
+    }
+    if(storesDataInMemory()) {
+        mSurface.write(dst, pool);
+        return;
+    }
+    if(!mTmpFile) RuntimeThrow("No tmp file, and no data in memory");
+    // the tiles have to go through the pool, load them from the tmp file
+    if(!mTmpFile->open())
+        RuntimeThrow("Could not open temporary file for reading.");
+    UndoableAutoTiledSurface surface;
+    eReadStream src(mTmpFile.get());
+    surface.read(src);
+    mTmpFile->close();
+    surface.write(dst, pool);
+}
+
+void DrawableAutoTiledSurface::read(eReadStream &src, TilePoolReader &pool) {
+    finishPendingChanges();
+    if(src.evFileVersion() < EvFormat::paintTilePool) {
+        dataChanged();
+        mSurface.read(src, pool);
+        afterDataReplaced();
+        updateShownTileBitmaps();
+        return;
+    }
+    const auto tiles = std::make_shared<CompressedTiles>(
+                pool.readCompressedTiles(src));
+    setCompressedTiles(tiles);
+}
+
+void DrawableAutoTiledSurface::dataChanged() {
+    mCompressedTiles.reset();
+    mChangeId++;
+}
+
+void DrawableAutoTiledSurface::setCompressedTiles(
+        const std::shared_ptr<const CompressedTiles>& tiles) {
+    if(mTmpFile) scheduleDeleteTmpFile();
+    mSurface.clear();
+    clearBitmaps();
+    mCompressedTiles = tiles;
+    QPoint minTile;
+    bool first = true;
+    for(const auto& entry : tiles->fTiles) {
+        if(first) minTile = QPoint(entry.fX, entry.fY);
+        else minTile = QPoint(qMin(minTile.x(), entry.fX),
+                              qMin(minTile.y(), entry.fY));
+        first = false;
+    }
+    mUnloadedZeroTilePos = -minTile*TILE_SIZE;
+    mChangeId++;
+    setDataInMemory(false);
+    // the compressed tiles take memory as well
+    updateInMemoryManagment();
 }
 
 void DrawableAutoTiledSurface::loadPixmap(const SkPixmap &src) {
+    finishPendingChanges();
+    dataChanged();
     mSurface.loadPixmap(src);
     afterDataReplaced();
-    updateTileBitmaps();
+    updateShownTileBitmaps();
 }
 
 void DrawableAutoTiledSurface::loadPixmap(const QImage &src) {
+    finishPendingChanges();
+    dataChanged();
     mSurface.loadPixmap(src);
     afterDataReplaced();
-    updateTileBitmaps();
+    updateShownTileBitmaps();
 }
 
 QImage DrawableAutoTiledSurface::toImage(const bool use16Bit,
@@ -103,6 +190,10 @@ void DrawableAutoTiledSurface::updateTileBitmaps() {
     updateTileRecBitmaps(mSurface.tileBoundingRect());
 }
 
+void DrawableAutoTiledSurface::updateShownTileBitmaps() {
+    if(inUse() || hasTileBitmaps()) updateTileBitmaps();
+}
+
 void DrawableAutoTiledSurface::clearBitmaps() {
     mTileBitmaps.clear();
 }
@@ -169,13 +260,17 @@ void DrawableAutoTiledSurface::updateTileDimensions() {
 }
 
 void DrawableAutoTiledSurface::crop(const QRect& crop) {
+    finishPendingChanges();
+    dataChanged();
     mSurface.crop(crop);
-    updateTileBitmaps();
+    updateShownTileBitmaps();
 }
 
 void DrawableAutoTiledSurface::move(const int dx, const int dy) {
+    finishPendingChanges();
+    dataChanged();
     mSurface.move(dx, dy);
-    updateTileBitmaps();
+    updateShownTileBitmaps();
 }
 
 void DrawableAutoTiledSurface::updateTileRecBitmaps(QRect tileRect) {
@@ -186,6 +281,9 @@ void DrawableAutoTiledSurface::updateTileRecBitmaps(QRect tileRect) {
     const auto max = tileRect.bottomRight();
     stretchBitmapsToTile(min.x(), min.y());
     stretchBitmapsToTile(max.x(), max.y());
+    // detach from copies sharing the lists before writing in parallel
+    for(int tx = tileRect.left(); tx <= tileRect.right(); tx++)
+        mBitmaps[tx + mZeroTileCol].detach();
     const int n = tileRect.width()*tileRect.height();
 #if defined (Q_OS_WIN)
     #pragma omp parallel for if(n > 4)
@@ -196,7 +294,16 @@ void DrawableAutoTiledSurface::updateTileRecBitmaps(QRect tileRect) {
         for(int ty = tileRect.top(); ty <= tileRect.bottom(); ty++) {
             const auto tileId = QPoint(tx, ty) + zeroTile();
             SkBitmap& btmp = mBitmaps[tileId.x()][tileId.y()];
-            if(btmp.isNull()) {
+            const auto tile = mSurface.getTile(tx, ty);
+            if(!tile || !tile->data()) {
+                btmp.reset();
+                continue;
+            }
+            if(!btmp.isNull() && !tile->changed()) continue;
+            tile->setChanged(false);
+            // pixels can be shared with a copy of this surface
+            const bool shared = btmp.pixelRef() && !btmp.pixelRef()->unique();
+            if(btmp.isNull() || shared) {
                 btmp = mSurface.tileToBitmap(tx, ty);
             } else {
                 mSurface.tileToBitmap(tx, ty, btmp);
@@ -356,7 +463,26 @@ private:
     const Func mFinishedFunc;
 };
 
+class CompressedSurfaceSaver : public TmpSaver {
+    e_OBJECT
+protected:
+    CompressedSurfaceSaver(DrawableAutoTiledSurface* const target,
+                           const std::shared_ptr<const CompressedTiles>& tiles) :
+        TmpSaver(target), mTiles(tiles) {}
+
+    void write(eWriteStream& dst) {
+        UndoableAutoTiledSurface surface;
+        surface.loadCompressed(*mTiles);
+        surface.write(dst);
+    }
+private:
+    const std::shared_ptr<const CompressedTiles> mTiles;
+};
+
 stdsptr<eHddTask> DrawableAutoTiledSurface::createTmpFileDataSaver() {
+    if(!storesDataInMemory() && mCompressedTiles) {
+        return enve::make_shared<CompressedSurfaceSaver>(this, mCompressedTiles);
+    }
     return enve::make_shared<SurfaceSaver>(this, std::move(mSurface));
 }
 
@@ -366,22 +492,87 @@ stdsptr<eHddTask> DrawableAutoTiledSurface::createTmpFileDataLoader() {
     [thisP](UndoableAutoTiledSurface&& surface) {
         if(thisP) {
             thisP->mSurface = std::move(surface);
-            thisP->updateTileBitmaps();
+            thisP->updateShownTileBitmaps();
             thisP->afterDataLoadedFromTmpFile();
         }
     };
     return enve::make_shared<SurfaceLoader>(mTmpFile, this, finishedFunc);
 }
 
+class CompressedSurfaceLoader : public eCpuTask {
+    e_OBJECT
+public:
+    typedef std::function<void(UndoableAutoTiledSurface&&)> Func;
+protected:
+    CompressedSurfaceLoader(const std::shared_ptr<const CompressedTiles>& tiles,
+                            const Func& finishedFunc) :
+        mTiles(tiles), mFinishedFunc(finishedFunc) {}
+
+    void process() {
+        mSurface.loadCompressed(*mTiles);
+    }
+    void afterProcessing() {
+        if(mFinishedFunc) mFinishedFunc(std::move(mSurface));
+    }
+private:
+    const std::shared_ptr<const CompressedTiles> mTiles;
+    UndoableAutoTiledSurface mSurface;
+    const Func mFinishedFunc;
+};
+
+stdsptr<eTask> DrawableAutoTiledSurface::createCompressedDataLoader() {
+    stdptr<DrawableAutoTiledSurface> thisP = this;
+    const CompressedSurfaceLoader::Func finishedFunc =
+    [thisP](UndoableAutoTiledSurface&& surface) {
+        if(thisP) {
+            thisP->mSurface = std::move(surface);
+            thisP->updateShownTileBitmaps();
+            thisP->afterDataLoadedFromTmpFile();
+        }
+    };
+    return enve::make_shared<CompressedSurfaceLoader>(mCompressedTiles,
+                                                      finishedFunc);
+}
+
 int DrawableAutoTiledSurface::getByteCount() {
-    const int spixels = mColumnCount*mRowCount*TILE_SPIXEL_SIZE;
-    return spixels*static_cast<int>(sizeof(uint16_t));
+    const int spixels = mSurface.tileCount()*TILE_SPIXEL_SIZE;
+    int bitmapBytes = 0;
+    for(const auto& col : mBitmaps) {
+        for(const auto& btmp : col) {
+            if(!btmp.isNull()) bitmapBytes += TILE_SPIXEL_SIZE;
+        }
+    }
+    return spixels*static_cast<int>(sizeof(uint16_t)) + bitmapBytes +
+            compressedByteCount();
+}
+
+int DrawableAutoTiledSurface::compressedByteCount() const {
+    if(!mCompressedTiles) return 0;
+    int bytes = 0;
+    for(const auto& entry : mCompressedTiles->fTiles) {
+        bytes += entry.fData.size();
+    }
+    return bytes;
 }
 
 int DrawableAutoTiledSurface::clearMemory() {
-    const int bytes = DrawableAutoTiledSurface::getByteCount();
+    if(!storesDataInMemory()) {
+        // only the compressed tiles are left, move them to a tmp file
+        const int bytes = compressedByteCount();
+        if(mCompressedTiles) {
+            scheduleSaveToTmpFile();
+            mCompressedTiles.reset();
+        }
+        return bytes;
+    }
+    const int bytes = DrawableAutoTiledSurface::getByteCount() -
+                      compressedByteCount();
+    mUnloadedZeroTilePos = mSurface.zeroTilePos();
     clearBitmaps();
-    scheduleSaveToTmpFile();
+    // unchanged data can be decompressed again instead
+    if(!mCompressedTiles) scheduleSaveToTmpFile();
     mSurface.clear();
+    // the compressed tiles are still kept, they can be freed later
+    if(mCompressedTiles) addToMemoryManagment();
     return bytes;
 }
@@ -21,6 +21,8 @@
 #include "CacheHandlers/hddcachablecont.h"
 #include "tilebitmaps.h"
 
+#include <functional>
+
 class CORE_EXPORT DrawableAutoTiledSurface : public HddCachableCont {
     e_OBJECT
     typedef QList<QList<SkBitmap>> Tiles;
@@ -32,6 +34,9 @@ protected:
     stdsptr<eHddTask> createTmpFileDataSaver();
     stdsptr<eHddTask> createTmpFileDataLoader();
 
+    bool storesCompressedData() const { return mCompressedTiles != nullptr; }
+    stdsptr<eTask> createCompressedDataLoader();
+
     int getByteCount();
     int clearMemory();
     void noDataLeft_k() { Q_ASSERT(false); }
@@ -61,6 +66,13 @@ public:
     UndoableAutoTiledSurface &surface()
     { return mSurface; }
 
+    const TileBitmaps& tileBitmaps() const
+    { return mTileBitmaps; }
+
+    //! @brief Incremented whenever the surface content changes
+    uint changeId() const
+    { return mChangeId; }
+
     void pixelRectChanged(const QRect& pixRect);
 
     QRect pixelBoundingRect() const
@@ -75,12 +87,19 @@ public:
     void write(eWriteStream& dst);
     void read(eReadStream& src);
 
+    //! @brief Shares tile data with other surfaces written to the pool
+    void write(eWriteStream& dst, TilePoolWriter& pool);
+    //! @brief Keeps the read tiles compressed,
+    //! they are decompressed when the surface is first used
+    void read(eReadStream& src, TilePoolReader& pool);
+
     void loadPixmap(const SkPixmap& src);
     void loadPixmap(const QImage &src);
 
     QImage toImage(const bool use16Bit,
                    const QMargins &margin = QMargins()) const;
 
+    //! @brief Converts tiles changed since their last conversion
     void updateTileBitmaps();
 
     void clearBitmaps();
@@ -90,17 +109,37 @@ public:
 
     void drawingDoneForNow() { afterDataReplaced(); }
 
+    //! @brief Set while the surface is changed in the background,
+    //! the function has to finish the changes before returning
+    void setPendingChanges(const std::function<void()>& finish)
+    { mFinishPendingChanges = finish; }
+    //! @brief Call before accessing the tiles outside of the code
+    //! that set the pending changes
+    void finishPendingChanges();
+
     void updateTileDimensions();
 
     void crop(const QRect& crop);
     void move(const int dx, const int dy);
 
+    //! @brief Zero tile in the tile bitmaps grid, only valid with bitmaps
     QPoint zeroTile() const
     { return QPoint(mZeroTileCol, mZeroTileRow); }
 
-    QPoint zeroTilePos() const
-    { return zeroTile()*TILE_SIZE; }
+    //! @brief Pixel position of the zero tile relative to the top left
+    //! corner of the tiles, known also while the data is not in memory
+    QPoint zeroTilePos() const {
+        if(storesDataInMemory()) return mSurface.zeroTilePos();
+        return mUnloadedZeroTilePos;
+    }
 private:
+    int compressedByteCount() const;
+    void setCompressedTiles(const std::shared_ptr<const CompressedTiles>& tiles);
+    //! @brief Tile bitmaps are only needed for displayed surfaces,
+    //! off-screen surfaces keep just the tiles
+    void updateShownTileBitmaps();
+    void dataChanged();
+
     void removeFirstColumn();
     void removeLastColumn();
     void removeFirstRow();
@@ -139,6 +178,12 @@ private:
     QRect pixRectToTileRect(const QRect& pixRect) const;
 
     UndoableAutoTiledSurface mSurface;
+    //! @brief Tiles as read from file, reset once the surface changes
+    std::shared_ptr<const CompressedTiles> mCompressedTiles;
+    uint mChangeId = 0;
+    QPoint mUnloadedZeroTilePos;
+    std::function<void()> mFinishPendingChanges;
+
     TileBitmaps mTileBitmaps;
     int &mRowCount;
     int &mColumnCount;
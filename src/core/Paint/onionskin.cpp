@@ -15,11 +15,12 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "onionskin.h"
-
+#include "Tasks/updatable.h"
 
 void OnionSkin::draw(SkCanvas * const canvas) {
-    fPrev.draw(canvas);
-    fNext.draw(canvas);
+    drawSide(canvas, fPrev);
+    drawSide(canvas, fNext);
+    pruneImages();
 }
 
 void OnionSkin::clear() {
@@ -27,67 +28,167 @@ void OnionSkin::clear() {
     fNext.clear();
 }
 
-SkIRect OnionSkin::Skin::boundingRect() const {
-    return toSkIRect(fSurface->pixelBoundingRect());
+void OnionSkin::SkinsSide::clear() {
+    fSkins.clear();
 }
 
-SkIRect OnionSkin::SkinsSide::boundingRect() const {
-    SkIRect result = SkIRect::MakeXYWH(0, 0, 0, 0);
-    bool first = true;
-    for(const auto& skin : fSkins) {
-        if(first) {
-            result = skin.boundingRect();
-            first = false;
-        } else result.join(skin.boundingRect());
+void OnionSkin::drawSide(SkCanvas * const canvas, const SkinsSide& side) {
+    if(side.fSkins.isEmpty()) return;
+    canvas->saveLayerAlpha(nullptr, 128);
+    for(const auto& skin : side.fSkins) {
+        const auto surface = skin.fSurface.data();
+        if(!surface) continue;
+        const auto& image = skinImage(surface, side.fColor);
+        if(!image.fImage) continue;
+        SkPaint paint;
+        paint.setAlphaf(skin.fWeight);
+        canvas->drawImage(image.fImage, image.fImageXY.x(),
+                          image.fImageXY.y(), &paint);
     }
-    return result;
+    canvas->restore();
 }
 
-void OnionSkin::SkinsSide::draw(SkCanvas * const canvas) {
-    if(fSkins.isEmpty()) return;
-    if(!fImage) setupImage(canvas->getGrContext());
-    SkPaint paint;
-    paint.setAlphaf(0.5f);
-    canvas->drawImage(fImage, fImageXY.x(), fImageXY.y(), &paint);
+OnionSkin::SkinImage& OnionSkin::skinImage(
+        DrawableAutoTiledSurface* const surface, const SkColor4f& color) {
+    stdsptr<SkinImage> result;
+    for(const auto& image : mImages) {
+        if(image->fSurface == surface && image->fColor == color) {
+            result = image;
+            break;
+        }
+    }
+    if(!result) {
+        result = std::make_shared<SkinImage>();
+        result->fSurface = surface;
+        result->fColor = color;
+        mImages << result;
+    }
+    const bool changed = result->fChangeId != surface->changeId();
+    if(!result->fOutdated && !changed) return *result;
+    // keep the last image of evicted surfaces until they are loaded
+    if(surface->storesDataInMemory()) scheduleImageUpdate(result);
+    else scheduleSurfaceLoad(result);
+    return *result;
 }
 
-void OnionSkin::SkinsSide::clear() {
-    fSkins.clear();
-    fImage.reset();
+void OnionSkin::scheduleSurfaceLoad(const stdsptr<SkinImage>& image) {
+    if(image->fLoading) return;
+    const auto task = image->fSurface->scheduleLoadFromTmpFile();
+    if(!task) return;
+    image->fLoading = true;
+    const std::weak_ptr<SkinImage> imageP = image;
+    const auto imageUpdated = fImageUpdated;
+    const auto loaded = [imageP, imageUpdated]() {
+        const auto image = imageP.lock();
+        if(!image) return;
+        image->fLoading = false;
+        // the image is rebuilt when drawn next
+        if(imageUpdated) imageUpdated();
+    };
+    const auto canceled = [imageP]() {
+        const auto image = imageP.lock();
+        if(image) image->fLoading = false;
+    };
+    task->addDependent({loaded, canceled});
 }
 
-void OnionSkin::SkinsSide::setupImage(GrContext * const grContext) {
-    const auto bRect = boundingRect();
-    if(bRect.width() <= 0 || bRect.height() <= 0) return;
-    fImageXY = bRect.topLeft();
-    const auto grTex = grContext->createBackendTexture(
-                bRect.width(), bRect.height(),
-                kRGBA_8888_SkColorType, GrMipMapped::kNo,
-                GrRenderable::kYes);
+void OnionSkin::scheduleImageUpdate(const stdsptr<SkinImage>& image) {
+    const auto surface = image->fSurface.data();
+    const uint changeId = surface->changeId();
+    image->fChangeId = changeId;
+    image->fOutdated = false;
+
+    struct Result {
+        sk_sp<SkImage> fImage;
+        SkIPoint fImageXY{0, 0};
+    };
+    const auto result = std::make_shared<Result>();
+    // bitmaps and tiles are copy-on-write, painting does not affect the copy
+    TileBitmaps bitmaps;
+    // off-screen surfaces do not keep tile bitmaps,
+    // their tiles are converted in the task instead
+    std::shared_ptr<AutoTilesData> tiles;
+    if(surface->hasTileBitmaps()) bitmaps = surface->tileBitmaps();
+    else tiles = std::make_shared<AutoTilesData>(surface->surface().tilesData());
+    const SkColor4f color = image->fColor;
+    const auto run = [bitmaps, tiles, color, result]() {
+        const QRect tileRect = tiles ? tiles->tileBoundingRect() :
+                                       QRect(-bitmaps.fZeroTileCol,
+                                             -bitmaps.fZeroTileRow,
+                                             bitmaps.fColumnCount,
+                                             bitmaps.fRowCount);
+        if(tileRect.isEmpty()) return;
+        const int width = tileRect.width()*TILE_SIZE;
+        const int height = tileRect.height()*TILE_SIZE;
+        SkBitmap bitmap;
+        bitmap.allocPixels(SkiaHelpers::getPremulRGBAInfo(width, height));
+        bitmap.eraseColor(SK_ColorTRANSPARENT);
+        SkCanvas canvas(bitmap);
 
-    sk_sp<SkSurface> gpuSurface = SkSurface::MakeFromBackendTexture(
-                grContext, grTex,
-                kTopLeft_GrSurfaceOrigin, 0,
-                kRGBA_8888_SkColorType,
-                nullptr, nullptr);
-    const auto texCanvas = gpuSurface->getCanvas();
-    texCanvas->clear(SK_ColorTRANSPARENT);
-    texCanvas->translate(-fImageXY.x(), -fImageXY.y());
-    for(const auto& skin : fSkins) {
         SkPaint paint;
-        const float rgbMax = qMax(fColor.fR, qMax(fColor.fG, fColor.fB));
+        const float rgbMax = qMax(color.fR, qMax(color.fG, color.fB));
         const float colM[20] = {
-            1 - rgbMax, 0, 0, fColor.fR, 0,
-            0, 1 - rgbMax, 0, fColor.fG, 0,
-            0, 0, 1 - rgbMax, fColor.fB, 0,
-            0, 0, 0, fColor.fA*skin.fWeight, 0};
-        const auto colF = SkColorFilters::Matrix(colM);
-        paint.setColorFilter(colF);
+            1 - rgbMax, 0, 0, color.fR, 0,
+            0, 1 - rgbMax, 0, color.fG, 0,
+            0, 0, 1 - rgbMax, color.fB, 0,
+            0, 0, 0, color.fA, 0};
+        paint.setColorFilter(SkColorFilters::Matrix(colM));
+        SkBitmap tileBitmap;
+        if(tiles) {
+            const auto info = SkiaHelpers::getPremulRGBAInfo(TILE_SIZE, TILE_SIZE);
+            tileBitmap.allocPixels(info);
+        }
+        for(int col = 0; col < tileRect.width(); col++) {
+            for(int row = 0; row < tileRect.height(); row++) {
+                if(tiles) {
+                    const auto tile = tiles->getTile(tileRect.x() + col,
+                                                     tileRect.y() + row);
+                    if(!tile || !tiles->tileToBitmap(*tile, tileBitmap))
+                        continue;
+                    tileBitmap.notifyPixelsChanged();
+                } else {
+                    tileBitmap = bitmaps.fBitmaps.at(col).at(row);
+                    if(tileBitmap.isNull()) continue;
+                }
+                canvas.drawBitmap(tileBitmap, col*TILE_SIZE, row*TILE_SIZE, &paint);
+            }
+        }
+        result->fImage = SkiaHelpers::transferDataToSkImage(bitmap);
+        result->fImageXY = {tileRect.x()*TILE_SIZE, tileRect.y()*TILE_SIZE};
+    };
+
+    const std::weak_ptr<SkinImage> imageP = image;
+    const auto imageUpdated = fImageUpdated;
+    const auto after = [imageP, changeId, result, imageUpdated]() {
+        const auto image = imageP.lock();
+        if(!image || image->fChangeId != changeId) return;
+        image->fImage = result->fImage;
+        image->fImageXY = result->fImageXY;
+        if(imageUpdated) imageUpdated();
+    };
+    const auto canceled = [imageP, changeId]() {
+        const auto image = imageP.lock();
+        if(!image || image->fChangeId != changeId) return;
+        image->fOutdated = true;
+    };
+    const auto task = enve::make_shared<eCustomCpuTask>(
+                nullptr, run, after, canceled);
+    task->queTask();
+}
 
-        skin.fSurface->drawOnCanvas(texCanvas, {0, 0}, &paint);
+void OnionSkin::pruneImages() {
+    const auto used = [this](const SkinImage& image) {
+        const auto surface = image.fSurface.data();
+        if(!surface) return false;
+        for(const auto side : {&fPrev, &fNext}) {
+            if(!(side->fColor == image.fColor)) continue;
+            for(const auto& skin : side->fSkins) {
+                if(skin.fSurface == surface) return true;
+            }
+        }
+        return false;
+    };
+    for(int i = mImages.count() - 1; i >= 0; i--) {
+        if(!used(*mImages.at(i))) mImages.removeAt(i);
     }
-    texCanvas->flush();
-    fImage = SkImage::MakeFromAdoptedTexture(grContext, grTex,
-                                             kTopLeft_GrSurfaceOrigin,
-                                             kRGBA_8888_SkColorType);
 }
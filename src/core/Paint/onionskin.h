@@ -20,29 +20,49 @@
 
 struct CORE_EXPORT OnionSkin {
     struct Skin {
-        DrawableAutoTiledSurface* fSurface;
+        stdptr<DrawableAutoTiledSurface> fSurface;
         float fWeight;
-
-        SkIRect boundingRect() const;
     };
 
     struct SkinsSide {
         SkColor4f fColor;
         QList<Skin> fSkins;
-        sk_sp<SkImage> fImage;
-        SkIPoint fImageXY;
 
-        SkIRect boundingRect() const;
-        void draw(SkCanvas * const canvas);
         void clear();
-        void setupImage(GrContext* const grContext);
     };
 
-    SkinsSide fPrev{{1, 0, 0, 1}, QList<Skin>(), nullptr, {0, 0}};
-    SkinsSide fNext{{0, 0.5f, 1, 1}, QList<Skin>(), nullptr, {0, 0}};
+    SkinsSide fPrev{{1, 0, 0, 1}, QList<Skin>()};
+    SkinsSide fNext{{0, 0.5f, 1, 1}, QList<Skin>()};
+
+    //! @brief Called after a skin image finished rebuilding
+    std::function<void()> fImageUpdated;
 
     void draw(SkCanvas * const canvas);
+    //! @brief Clears the skins, cached images are kept for reuse
     void clear();
+private:
+    //! @brief Skin tinted with side color, the weight is applied when drawn.
+    //! Rebuilt on a worker thread only when the surface changes.
+    struct SkinImage {
+        stdptr<DrawableAutoTiledSurface> fSurface;
+        SkColor4f fColor;
+        uint fChangeId = 0;
+        bool fOutdated = true;
+        bool fLoading = false;
+        sk_sp<SkImage> fImage;
+        SkIPoint fImageXY{0, 0};
+    };
+
+    void drawSide(SkCanvas * const canvas, const SkinsSide& side);
+    SkinImage& skinImage(DrawableAutoTiledSurface* const surface,
+                         const SkColor4f& color);
+    void scheduleImageUpdate(const stdsptr<SkinImage>& image);
+    //! @brief Loads an evicted surface, requests a redraw once loaded
+    void scheduleSurfaceLoad(const stdsptr<SkinImage>& image);
+    //! @brief Removes images of surfaces not used as skins anymore
+    void pruneImages();
+
+    QList<stdsptr<SkinImage>> mImages;
 };
 
 #endif // ONIONSKIN_H
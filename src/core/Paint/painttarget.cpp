@@ -17,6 +17,16 @@
 #include "painttarget.h"
 #include "canvas.h"
 #include "Private/document.h"
+#include "Tasks/updatable.h"
+
+#include <mutex>
+
+PaintTarget::PaintTarget(Canvas* const canvas) : mCanvas(canvas) {
+    const qptr<Canvas> canvasP = canvas;
+    mPaintOnion.fImageUpdated = [canvasP]() {
+        if(canvasP) emit canvasP->requestUpdate();
+    };
+}
 
 void PaintTarget::draw(SkCanvas * const canvas,
                        const QMatrix& viewTrans,
@@ -49,6 +59,8 @@ void PaintTarget::draw(SkCanvas * const canvas,
 
 void PaintTarget::setPaintDrawable(DrawableAutoTiledSurface * const surf,
                                    const int frame) {
+    // the pending stroke belongs to the previous drawable
+    finishStroke();
     if(mPaintDrawable) {
         if(mChanged) {
             mPaintDrawable->drawingDoneForNow();
@@ -123,6 +135,7 @@ void PaintTarget::cropMove(const QPointF &pos) {
 
 void PaintTarget::cropRelease(const QPointF &pos) {
     cropMove(pos);
+    finishStroke();
     startTransform();
     mChanged = true;
 
@@ -150,6 +163,7 @@ void PaintTarget::moveMove(const QPointF &pos) {
 }
 
 void PaintTarget::moveRelease(const QPointF &pos) {
+    finishStroke();
     moveMove(pos);
     const int dx = qRound(mRelDrawPos.x());
     const int dy = qRound(mRelDrawPos.y());
@@ -191,15 +205,11 @@ void PaintTarget::paintPress(const QPointF& pos,
     startTransform();
 
     if(mPaintDrawable && brush) {
-        const auto& target = mPaintDrawable->surface();
         const auto pDrawTrans = mPaintDrawableBox->getTotalTransform();
         const auto drawPos = pDrawTrans.inverted().map(pos);
-        const auto roi =
-                target.paintPressEvent(brush->getBrush(),
-                                       drawPos, 1, pressure, xTilt, yTilt);
-        const QRect qRoi(roi.x, roi.y, roi.width, roi.height);
-        mTotalRoi = qRoi;
-        mPaintDrawable->pixelRectChanged(qRoi);
+        queStrokeEvent({StrokeEvent::Type::press, drawPos, 1,
+                        pressure, xTilt, yTilt,
+                        brush->ref<SimpleBrushWrapper>()});
         mLastTs = ts;
         mChanged = true;
     }
@@ -210,32 +220,189 @@ void PaintTarget::paintMove(const QPointF& pos,
                             const qreal xTilt, const qreal yTilt,
                             const SimpleBrushWrapper * const brush) {
     if(mPaintDrawable && brush) {
-        const auto& target = mPaintDrawable->surface();
         const double dt = (ts - mLastTs);
         const auto pDrawTrans = mPaintDrawableBox->getTotalTransform();
         const auto drawPos = pDrawTrans.inverted().map(pos);
-        const auto roi =
-                target.paintMoveEvent(brush->getBrush(),
-                                      drawPos, dt/1000, pressure,
-                                      xTilt, yTilt);
-        const QRect qRoi(roi.x, roi.y, roi.width, roi.height);
-        mPaintDrawable->pixelRectChanged(qRoi);
-        if(mTotalRoi.isNull()) {
-            mTotalRoi = qRoi;
-        } else {
-            mTotalRoi = mTotalRoi.united(qRoi);
-        }
+        queStrokeEvent({StrokeEvent::Type::move, drawPos, dt/1000,
+                        pressure, xTilt, yTilt,
+                        brush->ref<SimpleBrushWrapper>()});
     }
     mLastTs = ts;
 }
 
 void PaintTarget::addUndoRedo(const QString& name, const QRect& roi) {
-    if(mPaintAnimSurface && mPaintDrawable) {
-        mPaintAnimSurface->addUndoRedo(name, roi);
+    addUndoRedo(name, roi, mPaintDrawable.get());
+}
+
+void PaintTarget::addUndoRedo(const QString& name, const QRect& roi,
+                              DrawableAutoTiledSurface * const target) {
+    if(mPaintAnimSurface && target) {
+        mPaintAnimSurface->addUndoRedo(name, roi, target);
         Document::sInstance->actionFinished();
     }
 }
 
 void PaintTarget::paintRelease() {
-    addUndoRedo("Paint", mTotalRoi);
+    if(mStrokeBatch || !mStrokeEvents.isEmpty()) {
+        queStrokeEvent({StrokeEvent::Type::release, QPointF(), 0,
+                        0, 0, 0, nullptr});
+    } else {
+        addUndoRedo("Paint", mTotalRoi);
+        mTotalRoi = QRect();
+    }
+}
+
+//! @brief Stroke events painted once, either by the stroke task,
+//! or by the main thread when it can not wait for the task
+class PaintStrokeBatch {
+public:
+    using Event = PaintTarget::StrokeEvent;
+
+    PaintStrokeBatch(DrawableAutoTiledSurface* const target,
+                     const QList<Event>& events) :
+        mTarget(target->ref<DrawableAutoTiledSurface>()),
+        mEvents(events) {}
+
+    //! @brief Blocks while the batch is being painted in another thread,
+    //! does nothing if the batch has already been painted
+    void process() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if(mProcessed) return;
+        mProcessed = true;
+        const auto& surface = mTarget->surface();
+        for(const auto& event : mEvents) {
+            if(event.fType == Event::Type::release) {
+                mReleased = true;
+                break;
+            }
+            const auto brush = event.fBrush->getBrush();
+            const bool press = event.fType == Event::Type::press;
+            const auto roi = press ?
+                        surface.paintPressEvent(brush, event.fPos,
+                                                event.fDTime, event.fPressure,
+                                                event.fXTilt, event.fYTilt) :
+                        surface.paintMoveEvent(brush, event.fPos,
+                                               event.fDTime, event.fPressure,
+                                               event.fXTilt, event.fYTilt);
+            const QRect qRoi(roi.x, roi.y, roi.width, roi.height);
+            mRoi = mRoi.united(qRoi);
+        }
+    }
+
+    DrawableAutoTiledSurface* target() const { return mTarget.get(); }
+    const QRect& roi() const { return mRoi; }
+    bool released() const { return mReleased; }
+private:
+    std::mutex mMutex;
+    bool mProcessed = false;
+    const stdsptr<DrawableAutoTiledSurface> mTarget;
+    const QList<Event> mEvents;
+    QRect mRoi;
+    bool mReleased = false;
+};
+
+class PaintStrokeTask : public eCpuTask {
+    e_OBJECT
+protected:
+    PaintStrokeTask(const stdsptr<PaintStrokeBatch>& batch,
+                    const std::function<void()>& finishedFunc) :
+        mBatch(batch), mFinishedFunc(finishedFunc) {}
+
+    void process() { mBatch->process(); }
+
+    void afterProcessing() {
+        if(mFinishedFunc) mFinishedFunc();
+    }
+
+    void afterCanceled() {
+        // canceled batches are painted in the main thread
+        if(mFinishedFunc) mFinishedFunc();
+    }
+private:
+    const stdsptr<PaintStrokeBatch> mBatch;
+    const std::function<void()> mFinishedFunc;
+};
+
+void PaintTarget::queStrokeEvent(const StrokeEvent& event) {
+    mStrokeEvents << event;
+    scheduleStrokeTask();
+}
+
+stdsptr<PaintStrokeBatch> PaintTarget::takeStrokeBatch() {
+    // events up to the end of the current stroke,
+    // the undo step is added before the next stroke starts
+    QList<StrokeEvent> events;
+    while(!mStrokeEvents.isEmpty()) {
+        const auto event = mStrokeEvents.takeFirst();
+        events << event;
+        if(event.fType == StrokeEvent::Type::release) break;
+    }
+    return std::make_shared<PaintStrokeBatch>(mPaintDrawable.get(), events);
+}
+
+void PaintTarget::scheduleStrokeTask() {
+    if(mStrokeBatch || mStrokeEvents.isEmpty() || !mPaintDrawable) return;
+    mStrokeBatch = takeStrokeBatch();
+    const auto batch = mStrokeBatch;
+    const qptr<Canvas> canvasP = mCanvas;
+    mPaintDrawable->setPendingChanges([this, canvasP]() {
+        if(canvasP) finishStroke();
+    });
+    const auto finishedFunc = [this, canvasP, batch]() {
+        if(!canvasP) return;
+        strokeTaskFinished(batch);
+    };
+    const auto task = enve::make_shared<PaintStrokeTask>(batch, finishedFunc);
+    task->queTask();
+}
+
+void PaintTarget::strokeTaskFinished(const stdsptr<PaintStrokeBatch>& batch) {
+    // already applied by finishStroke
+    if(batch != mStrokeBatch) return;
+    mStrokeBatch.reset();
+    applyStrokeBatch(*batch);
+    scheduleStrokeTask();
+    if(!mStrokeBatch) batch->target()->setPendingChanges(nullptr);
+}
+
+void PaintTarget::applyStrokeBatch(PaintStrokeBatch& batch) {
+    batch.process();
+    const auto target = batch.target();
+    const auto& roi = batch.roi();
+    if(!roi.isNull()) {
+        // only the tiles touched by the processed events are refreshed
+        target->pixelRectChanged(roi);
+        mTotalRoi = mTotalRoi.united(roi);
+        emit mCanvas->requestUpdate();
+    }
+    if(batch.released()) {
+        // bound to the painted surface, even if it is no longer current
+        addUndoRedo("Paint", mTotalRoi, target);
+        mTotalRoi = QRect();
+    }
+}
+
+void PaintTarget::finishStroke() {
+    if(mStrokeBatch) {
+        const auto batch = mStrokeBatch;
+        mStrokeBatch.reset();
+        // waits for the task if it is painting the batch,
+        // otherwise the batch is painted here and the task does nothing
+        applyStrokeBatch(*batch);
+        batch->target()->setPendingChanges(nullptr);
+    }
+    if(!mPaintDrawable) {
+        mStrokeEvents.clear();
+        mTotalRoi = QRect();
+        return;
+    }
+    while(!mStrokeEvents.isEmpty()) {
+        const auto batch = takeStrokeBatch();
+        applyStrokeBatch(*batch);
+    }
+    // the stroke continues after this point with a new undo step
+    if(!mTotalRoi.isNull()) {
+        addUndoRedo("Paint", mTotalRoi);
+        mTotalRoi = QRect();
+    }
 }
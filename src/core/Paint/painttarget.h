@@ -24,8 +24,23 @@ class Canvas;
 #include "onionskin.h"
 #include "CacheHandlers/usepointer.h"
 
+class PaintStrokeBatch;
+
 struct CORE_EXPORT PaintTarget {
-    PaintTarget(Canvas* const canvas) : mCanvas(canvas) {}
+    //! @brief Input queued for the background stroke task
+    struct StrokeEvent {
+        enum class Type { press, move, release };
+
+        Type fType;
+        QPointF fPos;
+        double fDTime;
+        qreal fPressure;
+        qreal fXTilt;
+        qreal fYTilt;
+        stdsptr<SimpleBrushWrapper> fBrush;
+    };
+
+    PaintTarget(Canvas* const canvas);
 
     bool needsProcessing() const { return true; }
 
@@ -45,9 +60,13 @@ struct CORE_EXPORT PaintTarget {
                    const qreal xTilt, const qreal yTilt,
                    const SimpleBrushWrapper * const brush);
     void paintRelease();
+    //! @brief Paints all pending stroke events and adds their undo step,
+    //! has to be called before the painted surface is accessed otherwise
+    void finishStroke();
 
     void newEmptyFrame() {
         if(!isValid()) return;
+        finishStroke();
         mPaintAnimSurface->newEmptyFrame();
     }
 
@@ -58,6 +77,8 @@ struct CORE_EXPORT PaintTarget {
         const auto missingLoaded = [canvasP, counter, this]() {
             if(!counter.unique() || !canvasP) return;
             setupOnionSkin();
+            // redraw with the loaded skins
+            if(mPaintOnion.fImageUpdated) mPaintOnion.fImageUpdated();
         };
         mPaintAnimSurface->setupOnionSkinFor(20, mPaintOnion, missingLoaded);
     }
@@ -87,6 +108,14 @@ struct CORE_EXPORT PaintTarget {
 private:
     void startTransform();
     void addUndoRedo(const QString &name, const QRect &roi);
+    void addUndoRedo(const QString &name, const QRect &roi,
+                     DrawableAutoTiledSurface * const target);
+
+    void queStrokeEvent(const StrokeEvent& event);
+    stdsptr<PaintStrokeBatch> takeStrokeBatch();
+    void scheduleStrokeTask();
+    void strokeTaskFinished(const stdsptr<PaintStrokeBatch>& batch);
+    void applyStrokeBatch(PaintStrokeBatch& batch);
 
     QPointF absPosToRelPos(const QPointF& absPos) const;
 
@@ -95,6 +124,10 @@ private:
     SkPoint mRelDrawPos = {0, 0};
 
     QRect mTotalRoi;
+    //! @brief Events waiting for the running stroke task to finish
+    QList<StrokeEvent> mStrokeEvents;
+    //! @brief Batch of the running stroke task, painted on mPaintDrawable
+    stdsptr<PaintStrokeBatch> mStrokeBatch;
     ulong mLastTs;
     int mLastFrame = 0;
     ConnContextQPtr<PaintBox> mPaintDrawableBox;
@@ -23,56 +23,73 @@ Tile::Tile(const Tile &other) : Tile(other.fSize) {
     copyFrom(other);
 }
 
-Tile::~Tile() { if(mData) delete[] mData; }
+Tile::~Tile() {}
 
 void Tile::swap(Tile &other) {
     std::swap(mData, other.mData);
+    mChanged = true;
+    other.mChanged = true;
 }
 
 void Tile::allocateData() {
     removeData();
-    mData = new uint16_t[fSize];
-    if(!mData) RuntimeThrow("Could not allocate memory for a tile.");
+    const auto data = new uint16_t[fSize];
+    if(!data) RuntimeThrow("Could not allocate memory for a tile.");
+    mData = std::shared_ptr<uint16_t>(data, std::default_delete<uint16_t[]>());
+}
+
+void Tile::detachData() {
+    const auto shared = mData;
+    allocateData();
+    memcpy(mData.get(), shared.get(), fSize*sizeof(uint16_t));
 }
 
 void Tile::zeroData() {
+    // shared data is going to be overwritten anyway, no need to copy it
+    if(dataShared()) allocateData();
     memset(requestData(), 0, fSize*sizeof(uint16_t));
 }
 
 void Tile::removeData() {
-    if(mData) {
-        delete[] mData;
-        mData = nullptr;
-    }
+    mData.reset();
+    mChanged = true;
 }
 
-bool Tile::dataTransparent() {
+bool Tile::dataTransparent() const {
     if(!mData) return false;
+    const auto data = mData.get();
     for(size_t a = 3; a < fSize; a += 4) {
-        if(mData[a] != 0) return false;
+        if(data[a] != 0) return false;
     }
     return true;
 }
 
 uint16_t *Tile::requestData() {
+    mChanged = true;
     if(!mData) allocateData();
-    return mData;
+    else if(dataShared()) detachData();
+    return mData.get();
 }
 
 uint16_t *Tile::requestZeroedData() {
+    mChanged = true;
     if(!mData) {
         allocateData();
         zeroData();
-    }
-    return mData;
+    } else if(dataShared()) detachData();
+    return mData.get();
 }
 
-uint16_t *Tile::data() const { return mData; }
+const uint16_t *Tile::data() const { return mData.get(); }
+
+bool Tile::dataShared() const {
+    return mData && mData.use_count() > 1;
+}
 
 void Tile::write(eWriteStream &dst) const {
     dst << static_cast<uint64_t>(fSize);
-    const bool data = mData; dst << data;
-    if(data) dst.writeCompressed(mData, fSize*sizeof(uint16_t));
+    const bool data = static_cast<bool>(mData); dst << data;
+    if(data) dst.writeCompressed(mData.get(), fSize*sizeof(uint16_t));
 }
 
 stdsptr<Tile> Tile::sRead(eReadStream &src, const TileCreator &tileCreator) {
@@ -91,11 +108,7 @@ stdsptr<Tile> Tile::sRead(eReadStream &src, const TileCreator &tileCreator) {
 }
 
 void Tile::copyFrom(const Tile &other) {
-    const auto otherData = other.data();
-    if(otherData) {
-        const auto thisData = requestData();
-        memcpy(thisData, otherData, fSize*sizeof(uint16_t));
-    } else {
-        removeData();
-    }
+    Q_ASSERT(fSize == other.fSize);
+    mData = other.mData;
+    mChanged = true;
 }
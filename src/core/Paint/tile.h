@@ -21,9 +21,13 @@
 #include "ReadWrite/ewritestream.h"
 #include "smartPointers/stdselfref.h"
 
+//! @brief Tile pixel data is reference counted and shared between copies
+//! (animation frames, undo/redo records), it is copied on the first
+//! request for mutable data (copy-on-write).
 class CORE_EXPORT Tile {
 public:
     Tile(const size_t& size);
+    //! @brief Shares the pixel data of other
     Tile(const Tile& other);
 
     ~Tile();
@@ -34,22 +38,33 @@ public:
     void zeroData();
     void removeData();
 
-    bool dataTransparent();
+    bool dataTransparent() const;
 
+    //! @brief Returns mutable data, detaches from other tiles sharing it
     uint16_t* requestData();
     uint16_t* requestZeroedData();
-    uint16_t* data() const;
+    const uint16_t* data() const;
+    bool dataShared() const;
+
+    //! @brief Set whenever the data is modified or replaced,
+    //! cleared once the tile bitmap has been refreshed
+    bool changed() const { return mChanged; }
+    void setChanged(const bool changed) { mChanged = changed; }
 
     void write(eWriteStream& dst) const;
 
     using TileCreator = std::function<stdsptr<Tile>(const size_t&)>;
     static stdsptr<Tile> sRead(eReadStream& src, const TileCreator& tileCreator);
 
+    //! @brief Shares the pixel data of other, no pixels are copied
     void copyFrom(const Tile& other);
 
     const size_t fSize;
 private:
-    uint16_t* mData = nullptr;
+    void detachData();
+
+    std::shared_ptr<uint16_t> mData;
+    bool mChanged = true;
 };
 
 #endif // TILE_H
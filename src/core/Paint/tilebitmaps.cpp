@@ -27,9 +27,9 @@ TileBitmaps::TileBitmaps(const TileBitmaps &src) {
     for(const auto& srcList : src.fBitmaps) {
         fBitmaps << QList<SkBitmap>();
         auto& list = fBitmaps.last();
-        for(const auto& srcBitmap : srcList) {
-            list << SkiaHelpers::makeCopy(srcBitmap);
-        }
+        // pixels are shared, DrawableAutoTiledSurface
+        // replaces shared bitmaps instead of writing to them
+        for(const auto& srcBitmap : srcList) list << srcBitmap;
     }
 }
 
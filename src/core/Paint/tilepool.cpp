@@ -0,0 +1,181 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "tilepool.h"
+
+void CompressedTiles::decompress(const Tile::TileCreator& tileCreator,
+                                 const TileAdder& adder) const {
+    std::unordered_map<const char*, size_t> ids;
+    std::vector<const QByteArray*> compressed;
+    std::vector<size_t> tileIds;
+    tileIds.reserve(fTiles.size());
+    for(const auto& tile : fTiles) {
+        const auto key = tile.fData.constData();
+        const auto it = ids.find(key);
+        if(it == ids.end()) {
+            tileIds.push_back(compressed.size());
+            ids.emplace(key, compressed.size());
+            compressed.push_back(&tile.fData);
+        } else tileIds.push_back(it->second);
+    }
+
+    const int nData = static_cast<int>(compressed.size());
+    std::vector<QByteArray> uncompressed(compressed.size());
+    #pragma omp parallel for if(nData > 1)
+    for(int i = 0; i < nData; i++) {
+        const auto id = static_cast<size_t>(i);
+        uncompressed[id] = qUncompress(*compressed[id]);
+    }
+
+    std::vector<Tile> data;
+    data.reserve(uncompressed.size());
+    for(const auto& iData : uncompressed) {
+        if(iData.isEmpty()) RuntimeThrow("Corrupted tile data");
+        const size_t size = static_cast<size_t>(iData.size())/sizeof(uint16_t);
+        data.emplace_back(size);
+        memcpy(data.back().requestData(), iData.constData(),
+               size*sizeof(uint16_t));
+    }
+
+    for(size_t i = 0; i < fTiles.size(); i++) {
+        const Tile& dataTile = data[tileIds[i]];
+        const auto tile = tileCreator(dataTile.fSize);
+        tile->copyFrom(dataTile);
+        adder(fTiles[i].fX, fTiles[i].fY, tile);
+    }
+}
+
+int TilePoolWriter::findTile(const Tile& tile, const uint hash) const {
+    const auto range = mTiles.equal_range(hash);
+    for(auto it = range.first; it != range.second; it++) {
+        const Tile& iTile = it->second.fTile;
+        if(iTile.fSize != tile.fSize) continue;
+        const bool same = iTile.data() == tile.data() ||
+                memcmp(iTile.data(), tile.data(),
+                       tile.fSize*sizeof(uint16_t)) == 0;
+        if(same) return it->second.fId;
+    }
+    return -1;
+}
+
+void TilePoolWriter::writeTiles(eWriteStream& dst,
+                                const std::vector<TilePos>& tiles) {
+    const int firstNewId = mPoolSize;
+    std::vector<Entry> entries;
+    entries.reserve(tiles.size());
+    std::vector<const Tile*> newTiles;
+    for(const auto& tile : tiles) {
+        const Tile& iTile = *tile.second;
+        if(!iTile.data() || iTile.dataTransparent()) continue;
+        const auto bytes = iTile.fSize*sizeof(uint16_t);
+        const uint hash = qHashBits(iTile.data(), bytes);
+        int id = findTile(iTile, hash);
+        if(id == -1) {
+            id = mPoolSize++;
+            mTiles.emplace(hash, PoolTile{id, iTile});
+            newTiles.push_back(&iTile);
+        }
+        entries.push_back({tile.first, id});
+    }
+
+    const int nNew = static_cast<int>(newTiles.size());
+    std::vector<QByteArray> compressed(newTiles.size());
+    #pragma omp parallel for if(nNew > 1)
+    for(int i = 0; i < nNew; i++) {
+        const Tile& tile = *newTiles[static_cast<size_t>(i)];
+        const auto data = reinterpret_cast<const char*>(tile.data());
+        const int bytes = static_cast<int>(tile.fSize*sizeof(uint16_t));
+        compressed[static_cast<size_t>(i)] =
+                qCompress(QByteArray::fromRawData(data, bytes));
+    }
+
+    writeEntries(dst, entries, firstNewId, compressed);
+}
+
+void TilePoolWriter::writeTiles(eWriteStream& dst,
+                                const CompressedTiles& tiles) {
+    const int firstNewId = mPoolSize;
+    std::vector<Entry> entries;
+    entries.reserve(tiles.fTiles.size());
+    std::vector<QByteArray> newData;
+    for(const auto& tile : tiles.fTiles) {
+        const auto key = tile.fData.constData();
+        const auto it = mCompressed.find(key);
+        int id;
+        if(it == mCompressed.end()) {
+            id = mPoolSize++;
+            mCompressed.emplace(key, PoolData{id, tile.fData});
+            newData.push_back(tile.fData);
+        } else id = it->second.fId;
+        entries.push_back({QPoint(tile.fX, tile.fY), id});
+    }
+
+    writeEntries(dst, entries, firstNewId, newData);
+}
+
+void TilePoolWriter::writeEntries(eWriteStream& dst,
+                                  const std::vector<Entry>& entries,
+                                  const int firstNewId,
+                                  const std::vector<QByteArray>& newData) {
+    // new data is written on first use, later uses store the distance
+    // to it, so that a self-contained set of tiles can be read into any pool
+    dst << static_cast<int>(entries.size());
+    int poolSize = firstNewId;
+    for(const auto& entry : entries) {
+        dst << entry.fPos.x();
+        dst << entry.fPos.y();
+        if(entry.fId == poolSize) {
+            dst << 0;
+            dst << newData[static_cast<size_t>(poolSize - firstNewId)];
+            poolSize++;
+        } else {
+            dst << poolSize - entry.fId;
+        }
+    }
+}
+
+void TilePoolReader::readTiles(eReadStream& src,
+                               const Tile::TileCreator& tileCreator,
+                               const TileAdder& adder) {
+    readCompressedTiles(src).decompress(tileCreator, adder);
+}
+
+CompressedTiles TilePoolReader::readCompressedTiles(eReadStream& src) {
+    int count; src >> count;
+    if(count < 0) RuntimeThrow("Invalid tile count " + std::to_string(count));
+
+    CompressedTiles result;
+    result.fTiles.reserve(static_cast<size_t>(count));
+    for(int i = 0; i < count; i++) {
+        CompressedTiles::Entry entry;
+        src >> entry.fX;
+        src >> entry.fY;
+        int distance; src >> distance;
+        if(distance == 0) {
+            src >> entry.fData;
+            mCompressed.push_back(entry.fData);
+        } else {
+            const int poolSize = static_cast<int>(mCompressed.size());
+            const int id = poolSize - distance;
+            if(distance < 0 || id < 0)
+                RuntimeThrow("Invalid tile reference " + std::to_string(distance));
+            entry.fData = mCompressed[static_cast<size_t>(id)];
+        }
+        result.fTiles.push_back(entry);
+    }
+    return result;
+}
@@ -0,0 +1,98 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef TILEPOOL_H
+#define TILEPOOL_H
+
+#include <QPoint>
+#include <unordered_map>
+#include <vector>
+
+#include "tile.h"
+
+//! @brief Tiles kept in their compressed form, data identical between
+//! tiles and between surfaces read through the same pool is shared.
+struct CORE_EXPORT CompressedTiles {
+    using TileAdder = std::function<void(const int tx, const int ty,
+                                         const stdsptr<Tile>& tile)>;
+    struct Entry {
+        int fX;
+        int fY;
+        QByteArray fData;
+    };
+
+    //! @brief Decompresses in parallel, shared data is decompressed once
+    //! and remains shared between the created tiles
+    void decompress(const Tile::TileCreator& tileCreator,
+                    const TileAdder& adder) const;
+
+    std::vector<Entry> fTiles;
+};
+
+//! @brief Writes paint surface tiles, transparent tiles are skipped.
+//! Tile data identical to data previously written through the same pool
+//! is stored as a reference, new data is compressed in parallel.
+class CORE_EXPORT TilePoolWriter {
+public:
+    using TilePos = std::pair<QPoint, const Tile*>;
+
+    void writeTiles(eWriteStream& dst, const std::vector<TilePos>& tiles);
+    //! @brief Writes already compressed tiles without recompressing them
+    void writeTiles(eWriteStream& dst, const CompressedTiles& tiles);
+private:
+    struct Entry {
+        QPoint fPos;
+        int fId;
+    };
+
+    struct PoolTile {
+        int fId;
+        Tile fTile;
+    };
+
+    struct PoolData {
+        int fId;
+        QByteArray fData;
+    };
+
+    int findTile(const Tile& tile, const uint hash) const;
+    void writeEntries(eWriteStream& dst,
+                      const std::vector<Entry>& entries,
+                      const int firstNewId,
+                      const std::vector<QByteArray>& newData);
+
+    int mPoolSize = 0;
+    std::unordered_multimap<uint, PoolTile> mTiles;
+    std::unordered_map<const char*, PoolData> mCompressed;
+};
+
+//! @brief Reads tiles written with TilePoolWriter,
+//! tiles referencing the same data share it.
+class CORE_EXPORT TilePoolReader {
+public:
+    using TileAdder = CompressedTiles::TileAdder;
+
+    void readTiles(eReadStream& src,
+                   const Tile::TileCreator& tileCreator,
+                   const TileAdder& adder);
+    //! @brief Reads the tiles without decompressing them
+    CompressedTiles readCompressedTiles(eReadStream& src);
+private:
+    std::vector<QByteArray> mCompressed;
+};
+
+#endif // TILEPOOL_H
@@ -16,6 +16,7 @@
 
 #include "taskque.h"
 #include "Private/esettings.h"
+#include "taskscheduler.h"
 
 TaskQue::TaskQue() {}
 
@@ -33,78 +34,85 @@ int TaskQue::countQued() const {
 
 bool TaskQue::allDone() const { return countQued() == 0; }
 
-void TaskQue::addTask(const stdsptr<eTask> &task) {
-    const auto hwSupport = task->hardwareSupport();
+HardwareSupport TaskQue::sQueFor(const HardwareSupport hwSupport) {
     switch(eSettings::sInstance->fAccPreference) {
         case AccPreference::gpuStrongPreference:
             switch(hwSupport) {
                 case HardwareSupport::gpuOnly:
                 case HardwareSupport::gpuPreffered:
                 case HardwareSupport::cpuPreffered:
-                    mGpuOnly << task;
-                    break;
+                    return HardwareSupport::gpuOnly;
                 case HardwareSupport::cpuOnly:
-                    mCpuOnly << task;
-                    break;
+                    return HardwareSupport::cpuOnly;
             }
             break;
         case AccPreference::gpuSoftPreference:
             switch(hwSupport) {
                 case HardwareSupport::gpuOnly:
                 case HardwareSupport::gpuPreffered:
-                    mGpuOnly << task;
-                    break;
+                    return HardwareSupport::gpuOnly;
                 case HardwareSupport::cpuPreffered:
-                    mCpuPreffered << task;
-                    break;
+                    return HardwareSupport::cpuPreffered;
                 case HardwareSupport::cpuOnly:
-                    mCpuOnly << task;
-                    break;
+                    return HardwareSupport::cpuOnly;
             }
             break;
         case AccPreference::defaultPreference:
             switch(hwSupport) {
                 case HardwareSupport::gpuOnly:
-                    mGpuOnly << task;
-                    break;
+                    return HardwareSupport::gpuOnly;
                 case HardwareSupport::gpuPreffered:
-                    mGpuPreffered << task;
-                    break;
+                    return HardwareSupport::gpuPreffered;
                 case HardwareSupport::cpuPreffered:
-                    mCpuPreffered << task;
-                    break;
+                    return HardwareSupport::cpuPreffered;
                 case HardwareSupport::cpuOnly:
-                    mCpuOnly << task;
-                    break;
+                    return HardwareSupport::cpuOnly;
             }
             break;
         case AccPreference::cpuSoftPreference:
             switch(hwSupport) {
                 case HardwareSupport::gpuOnly:
-                    mGpuOnly << task;
-                    break;
+                    return HardwareSupport::gpuOnly;
                 case HardwareSupport::gpuPreffered:
-                    mGpuPreffered << task;
-                    break;
+                    return HardwareSupport::gpuPreffered;
                 case HardwareSupport::cpuPreffered:
                 case HardwareSupport::cpuOnly:
-                    mCpuOnly << task;
-                    break;
+                    return HardwareSupport::cpuOnly;
             }
             break;
         case AccPreference::cpuStrongPreference:
             switch(hwSupport) {
                 case HardwareSupport::gpuOnly:
-                    mGpuOnly << task;
-                    break;
+                    return HardwareSupport::gpuOnly;
                 case HardwareSupport::gpuPreffered:
                 case HardwareSupport::cpuPreffered:
                 case HardwareSupport::cpuOnly:
-                    mCpuOnly << task;
-                    break;
+                    return HardwareSupport::cpuOnly;
             }
             break;
     }
+    return hwSupport;
+}
+
+void TaskQue::addTask(const stdsptr<eTask> &task) {
+    if(!TaskScheduler::sGpuAvailable()) {
+        mCpuOnly << task;
+        return;
+    }
+    switch(sQueFor(task->hardwareSupport())) {
+        case HardwareSupport::gpuOnly:
+            mGpuOnly << task;
+            break;
+        case HardwareSupport::gpuPreffered:
+            mGpuPreffered << task;
+            break;
+        case HardwareSupport::cpuPreffered:
+            mCpuPreffered << task;
+            break;
+        case HardwareSupport::cpuOnly:
+            mCpuOnly << task;
+            break;
+    }
 }
 
 stdsptr<eTask> TaskQue::takeQuedForCpuProcessing() {
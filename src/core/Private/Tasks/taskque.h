@@ -26,6 +26,10 @@ public:
     TaskQue& operator=(const TaskQue&) = delete;
 
     ~TaskQue();
+
+    //! @brief Returns the queue a task with the given hardware support
+    //! goes to, accounting for the user acceleration preference.
+    static HardwareSupport sQueFor(const HardwareSupport hwSupport);
 protected:
     int countQued() const;
     bool allDone() const;
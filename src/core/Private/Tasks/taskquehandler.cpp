@@ -23,6 +23,7 @@ bool TaskQueHandler::isEmpty() const { return mQues.isEmpty(); }
 void TaskQueHandler::clear() {
     mQues.clear();
     mCurrentQue = nullptr;
+    mInterruptedQue = nullptr;
     mTaskCount = 0;
 }
 
@@ -84,6 +85,21 @@ void TaskQueHandler::endQue() {
     mCurrentQue = nullptr;
 }
 
+void TaskQueHandler::beginPriorityQue() {
+    if(mInterruptedQue) RuntimeThrow("Previous priority list not ended");
+    mInterruptedQue = mCurrentQue;
+    mQues.prepend(std::make_shared<TaskQue>());
+    mCurrentQue = mQues.first().get();
+}
+
+void TaskQueHandler::endPriorityQue() {
+    if(!mCurrentQue) return;
+    const int count = mCurrentQue->countQued();
+    if(count == 0) mQues.removeFirst();
+    mCurrentQue = mInterruptedQue;
+    mInterruptedQue = nullptr;
+}
+
 void TaskQueHandler::queDone(const TaskQue * const que, const int queId) {
     if(que == mCurrentQue) return;
     mQues.removeAt(queId);
@@ -34,6 +34,9 @@ public:
 
     void endQue();
 
+    void beginPriorityQue();
+    void endPriorityQue();
+
     int taskCount() const { return mTaskCount; }
 private:
     void queDone(const TaskQue * const que, const int queId);
@@ -41,5 +44,6 @@ private:
     int mTaskCount = 0;
     QList<stdsptr<TaskQue>> mQues;
     TaskQue * mCurrentQue = nullptr;
+    TaskQue * mInterruptedQue = nullptr;
 };
 #endif // TASKQUEHANDLER_H
@@ -81,12 +81,17 @@ void TaskScheduler::sClearTasks() {
     sInstance->clearTasks();
 }
 
+bool TaskScheduler::sGpuAvailable() {
+    return sInstance && sInstance->mGpuAvailable;
+}
+
 void TaskScheduler::initializeGpu() {
     try {
         mGpuExec->initialize();
     } catch(...) {
         RuntimeThrow("Failed to initialize GPU execution controler.");
     }
+    mGpuAvailable = true;
 }
 
 void TaskScheduler::queHddTask(const stdsptr<eTask>& task) {
@@ -104,6 +109,14 @@ void TaskScheduler::queCpuTask(const stdsptr<eTask>& task) {
     }
 }
 
+void TaskScheduler::beginPriorityQue() {
+    mQuedCGTasks.beginPriorityQue();
+}
+
+void TaskScheduler::endPriorityQue() {
+    mQuedCGTasks.endPriorityQue();
+}
+
 void TaskScheduler::clearTasks() {
     mQuedCGTasks.clear();
 
@@ -195,6 +208,7 @@ void TaskScheduler::processNextTasks() {
 }
 
 bool TaskScheduler::processNextQuedGpuTask() {
+    if(!mGpuAvailable) return false;
     bool finished = false;
     QList<stdsptr<eTask>> tasks;
     const int count = 3 - GpuTaskExecutor::sWaitingTasks();
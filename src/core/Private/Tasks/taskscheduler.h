@@ -47,12 +47,21 @@ public:
 
     static void sClearTasks();
 
+    //! @brief False until initializeGpu succeeds,
+    //! without a GPU every task is processed on the CPU.
+    static bool sGpuAvailable();
+
     void initializeGpu();
 
     void queTasks();
     void queHddTask(const stdsptr<eTask>& task);
     void queCpuTask(const stdsptr<eTask> &task);
 
+    //! @brief Tasks qued until endPriorityQue() are processed
+    //! before any previously qued task.
+    void beginPriorityQue();
+    void endPriorityQue();
+
     void clearTasks();
 
     void afterHddTaskFinished(const stdsptr<eTask>& finishedTask);
@@ -106,6 +115,7 @@ private:
     static TaskScheduler* sInstance;
 
     bool mCriticalMemoryState = false;
+    bool mGpuAvailable = false;
 
     bool mAlwaysQue = false;
     bool mCpuQueing = false;
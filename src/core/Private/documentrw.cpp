@@ -23,6 +23,7 @@
 #include "Paint/brushescontext.h"
 #include "simpletask.h"
 #include "canvas.h"
+#include "Expressions/expressiongraph.h"
 
 void Document::writeBookmarked(eWriteStream &dst) const {
     dst << fColors.count();
@@ -98,6 +99,9 @@ void Document::read(eReadStream& src) {
         readGradients(src);
         src.readCheckpoint("Error reading gradients");
     }
+    // expressions are evaluated once all of them are read
+    // and their bindings are resolved
+    const ExpressionGraph::Batch exprBatch;
     readScenes(src);
     SimpleTask::sProcessAll();
 }
@@ -230,6 +234,7 @@ void Document::readDocumentXEV(const QDomDocument& doc,
 void Document::readScenesXEV(ZipFileLoader& fileLoader,
                              const QList<Canvas*>& scenes,
                              const RuntimeIdToWriteId& objListIdConv) {
+    const ExpressionGraph::Batch exprBatch;
     int id = 0;
     for(const auto& scene : scenes) {
         const QString path = "scenes/" + QString::number(id++) + "/";
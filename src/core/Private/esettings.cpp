@@ -164,6 +164,9 @@ eSettings::eSettings(const int cpuThreads, const intKB ramKB,
                      fPathGpuAcc,
                      "pathGpuAcc",
                      fGpuVendor != GpuVendor::nvidia);
+    gSettings << std::make_shared<eIntSetting>(
+                     fPreviewResolutionDiv,
+                     "previewResolutionDiv", 4);
     gSettings << std::make_shared<eBoolSetting>(
                      fHddCache,
                      "hddCache", true);
@@ -75,6 +75,7 @@ public:
     const GpuVendor fGpuVendor;
     AccPreference fAccPreference = AccPreference::defaultPreference;
     bool fPathGpuAcc = true;
+    int fPreviewResolutionDiv = 4; // <= 1 - no progressive preview
 
     bool fHddCache = true;
     QString fHddCacheFolder = ""; // "" - use system default temporary files folder
@@ -4,6 +4,7 @@
 #include "Boxes/containerbox.h"
 #include "svgexporthelpers.h"
 #include "svgexporter.h"
+#include "cpublur.h"
 
 class BlurEffectCaller : public RasterEffectCaller {
 public:
@@ -14,8 +15,17 @@ public:
                     GpuRenderTools& renderTools);
     void processCpu(CpuRenderTools& renderTools,
                     const CpuRenderData &data);
+
+    int cpuPasses() const { return 2; }
+    CpuTileSplit cpuTileSplit(const int pass) const {
+        return pass == 0 ? CpuTileSplit::rows : CpuTileSplit::columns;
+    }
+    void setupCpuPass(const CpuRenderData& data);
 private:
     const float mRadius;
+    const CpuBlur::Boxes mBoxes;
+    //! @brief Result of the horizontal pass
+    std::vector<uchar> mRowsBlurred;
 };
 
 BlurEffect::BlurEffect() :
@@ -77,7 +87,8 @@ QDomElement BlurEffect::saveBlurSVG(
 BlurEffectCaller::BlurEffectCaller(const HardwareSupport hwSupport,
                                    const qreal radius) :
     RasterEffectCaller(hwSupport, true, radiusToMargin(radius)),
-    mRadius(static_cast<float>(radius)) {}
+    mRadius(static_cast<float>(radius)),
+    mBoxes(CpuBlur::sGaussianBoxes(mRadius*0.3333333f)) {}
 
 
 void BlurEffectCaller::processGpu(QGL33 * const gl,
@@ -100,28 +111,29 @@ void BlurEffectCaller::processGpu(QGL33 * const gl,
     renderTools.swapTextures();
 }
 
+void BlurEffectCaller::setupCpuPass(const CpuRenderData& data) {
+    if(data.fPass != 0) return;
+    mRowsBlurred.resize(4*static_cast<size_t>(data.fWidth)*data.fHeight);
+}
+
 void BlurEffectCaller::processCpu(CpuRenderTools &renderTools,
                                   const CpuRenderData &data) {
-    Q_UNUSED(data)
-
-    const float sigma = mRadius*0.3333333f;
-    const auto filter = SkBlurImageFilter::Make(sigma, sigma, nullptr);
-
-    SkPaint paint;
-    paint.setImageFilter(filter);
-
-    SkCanvas canvas(renderTools.fDstBtmp);
-    canvas.clear(SK_ColorTRANSPARENT);
-
-    const int radCeil = static_cast<int>(ceil(mRadius));
     const auto& srcBtmp = renderTools.fSrcBtmp;
     const auto& texTile = data.fTexTile;
-    auto srcRect = texTile.makeOutset(radCeil, radCeil);
-    if(srcRect.intersect(srcRect, srcBtmp.bounds())) {
-        SkBitmap tileSrc;
-        srcBtmp.extractSubset(&tileSrc, srcRect);
-        const int drawX = srcRect.left() - texTile.left();
-        const int drawY = srcRect.top() - texTile.top();
-        canvas.drawBitmap(tileSrc, drawX, drawY, &paint);
+    const size_t rowBytes = 4*static_cast<size_t>(data.fWidth);
+    if(data.fPass == 0) {
+        Q_ASSERT(texTile.width() == srcBtmp.width());
+        const auto src = static_cast<const uchar*>(
+                    srcBtmp.getAddr(0, texTile.top()));
+        const auto dst = mRowsBlurred.data() + texTile.top()*rowBytes;
+        CpuBlur::sBlurRows(src, srcBtmp.rowBytes(), dst, rowBytes,
+                           texTile.width(), texTile.height(), 4, mBoxes);
+    } else {
+        Q_ASSERT(texTile.height() == srcBtmp.height());
+        auto& dstBtmp = renderTools.fDstBtmp;
+        const auto src = mRowsBlurred.data() + 4*texTile.left();
+        const auto dst = static_cast<uchar*>(dstBtmp.getPixels());
+        CpuBlur::sBlurColumns(src, rowBytes, dst, dstBtmp.rowBytes(),
+                              4*texTile.width(), texTile.height(), mBoxes);
     }
 }
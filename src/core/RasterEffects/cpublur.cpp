@@ -0,0 +1,484 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "cpublur.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define CPUBLUR_SSE2
+    #include <emmintrin.h>
+    #if defined(__GNUC__)
+        #define CPUBLUR_AVX2
+        #define CPUBLUR_AVX2_FUNC __attribute__((target("avx2")))
+        #include <immintrin.h>
+    #endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #define CPUBLUR_NEON
+    #include <arm_neon.h>
+#endif
+
+// Columns are processed in strips, so that the intermediate results
+// of the three box passes stay small and cache friendly
+#define CPUBLUR_STRIP_BYTES 64
+
+namespace {
+
+using ColumnsKernel = void(*)(const uchar* src, const size_t srcRowBytes,
+                              uchar* dst, const size_t dstRowBytes,
+                              const int n, const int height, const int r);
+
+// All kernels divide using the same float operations and round
+// to nearest even, so that every instruction set gives identical output
+inline uchar divRound(const uint32_t sum, const float inv) {
+    return static_cast<uchar>(std::lrint(static_cast<float>(sum)*inv));
+}
+
+template <int N>
+void boxRowScalar(const uchar* src, uchar* dst,
+                  const int width, const int r) {
+    const float inv = 1.f/(2*r + 1);
+    uint32_t acc[N] = {};
+    const int primeEnd = qMin(r, width - 1);
+    for(int x = 0; x <= primeEnd; x++) {
+        for(int c = 0; c < N; c++) acc[c] += src[x*N + c];
+    }
+    for(int x = 0; x < width; x++) {
+        for(int c = 0; c < N; c++) dst[x*N + c] = divRound(acc[c], inv);
+        const int xAdd = x + r + 1;
+        if(xAdd < width) {
+            for(int c = 0; c < N; c++) acc[c] += src[xAdd*N + c];
+        }
+        const int xSub = x - r;
+        if(xSub >= 0) {
+            for(int c = 0; c < N; c++) acc[c] -= src[xSub*N + c];
+        }
+    }
+}
+
+#if defined(CPUBLUR_SSE2)
+inline __m128i sse2LoadPixel(const uchar* p, const __m128i zero) {
+    int32_t v;
+    memcpy(&v, p, 4);
+    const __m128i b = _mm_cvtsi32_si128(v);
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(b, zero), zero);
+}
+
+void boxRowRGBA(const uchar* src, uchar* dst,
+                const int width, const int r) {
+    const __m128 inv = _mm_set1_ps(1.f/(2*r + 1));
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    const int primeEnd = qMin(r, width - 1);
+    for(int x = 0; x <= primeEnd; x++) {
+        acc = _mm_add_epi32(acc, sse2LoadPixel(src + 4*x, zero));
+    }
+    for(int x = 0; x < width; x++) {
+        const __m128 accF = _mm_cvtepi32_ps(acc);
+        const __m128i q = _mm_cvtps_epi32(_mm_mul_ps(accF, inv));
+        const __m128i q16 = _mm_packs_epi32(q, q);
+        const int32_t v = _mm_cvtsi128_si32(_mm_packus_epi16(q16, q16));
+        memcpy(dst + 4*x, &v, 4);
+        const int xAdd = x + r + 1;
+        if(xAdd < width) {
+            acc = _mm_add_epi32(acc, sse2LoadPixel(src + 4*xAdd, zero));
+        }
+        const int xSub = x - r;
+        if(xSub >= 0) {
+            acc = _mm_sub_epi32(acc, sse2LoadPixel(src + 4*xSub, zero));
+        }
+    }
+}
+#elif defined(CPUBLUR_NEON)
+inline uint32x4_t neonLoadPixel(const uchar* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    const uint16x8_t w = vmovl_u8(vcreate_u8(v));
+    return vmovl_u16(vget_low_u16(w));
+}
+
+void boxRowRGBA(const uchar* src, uchar* dst,
+                const int width, const int r) {
+    const float inv = 1.f/(2*r + 1);
+    uint32x4_t acc = vdupq_n_u32(0);
+    const int primeEnd = qMin(r, width - 1);
+    for(int x = 0; x <= primeEnd; x++) {
+        acc = vaddq_u32(acc, neonLoadPixel(src + 4*x));
+    }
+    for(int x = 0; x < width; x++) {
+        const float32x4_t accF = vmulq_n_f32(vcvtq_f32_u32(acc), inv);
+        const uint16x4_t q16 = vmovn_u32(vcvtnq_u32_f32(accF));
+        const uint8x8_t q8 = vqmovn_u16(vcombine_u16(q16, q16));
+        const uint32_t v = vget_lane_u32(vreinterpret_u32_u8(q8), 0);
+        memcpy(dst + 4*x, &v, 4);
+        const int xAdd = x + r + 1;
+        if(xAdd < width) acc = vaddq_u32(acc, neonLoadPixel(src + 4*xAdd));
+        const int xSub = x - r;
+        if(xSub >= 0) acc = vsubq_u32(acc, neonLoadPixel(src + 4*xSub));
+    }
+}
+#else
+void boxRowRGBA(const uchar* src, uchar* dst,
+                const int width, const int r) {
+    boxRowScalar<4>(src, dst, width, r);
+}
+#endif
+
+void boxRow(const uchar* src, uchar* dst, const int width,
+            const int nChannels, const int r) {
+    switch(nChannels) {
+    case 1: return boxRowScalar<1>(src, dst, width, r);
+    case 2: return boxRowScalar<2>(src, dst, width, r);
+    case 3: return boxRowScalar<3>(src, dst, width, r);
+    case 4: return boxRowRGBA(src, dst, width, r);
+    default: Q_ASSERT(false);
+    }
+}
+
+void boxColumnsScalar(const uchar* src, const size_t srcRowBytes,
+                      uchar* dst, const size_t dstRowBytes,
+                      const int n, const int height, const int r) {
+    Q_ASSERT(n <= CPUBLUR_STRIP_BYTES);
+    const float inv = 1.f/(2*r + 1);
+    uint32_t acc[CPUBLUR_STRIP_BYTES] = {};
+    const int primeEnd = qMin(r, height - 1);
+    for(int y = 0; y <= primeEnd; y++) {
+        const uchar* const line = src + static_cast<size_t>(y)*srcRowBytes;
+        for(int x = 0; x < n; x++) acc[x] += line[x];
+    }
+    for(int y = 0; y < height; y++) {
+        uchar* const dstLine = dst + static_cast<size_t>(y)*dstRowBytes;
+        for(int x = 0; x < n; x++) dstLine[x] = divRound(acc[x], inv);
+        const int yAdd = y + r + 1;
+        if(yAdd < height) {
+            const auto line = src + static_cast<size_t>(yAdd)*srcRowBytes;
+            for(int x = 0; x < n; x++) acc[x] += line[x];
+        }
+        const int ySub = y - r;
+        if(ySub >= 0) {
+            const auto line = src + static_cast<size_t>(ySub)*srcRowBytes;
+            for(int x = 0; x < n; x++) acc[x] -= line[x];
+        }
+    }
+}
+
+#if defined(CPUBLUR_SSE2)
+inline void sse2Widen(const uchar* p, const __m128i zero, __m128i* w) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i lo = _mm_unpacklo_epi8(v, zero);
+    const __m128i hi = _mm_unpackhi_epi8(v, zero);
+    w[0] = _mm_unpacklo_epi16(lo, zero);
+    w[1] = _mm_unpackhi_epi16(lo, zero);
+    w[2] = _mm_unpacklo_epi16(hi, zero);
+    w[3] = _mm_unpackhi_epi16(hi, zero);
+}
+
+inline void sse2Store(uchar* p, const __m128i* acc, const __m128 inv) {
+    __m128i q[4];
+    for(int i = 0; i < 4; i++) {
+        q[i] = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(acc[i]), inv));
+    }
+    const __m128i q01 = _mm_packs_epi32(q[0], q[1]);
+    const __m128i q23 = _mm_packs_epi32(q[2], q[3]);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p),
+                     _mm_packus_epi16(q01, q23));
+}
+
+void boxColumnsSse2(const uchar* src, const size_t srcRowBytes,
+                    uchar* dst, const size_t dstRowBytes,
+                    const int n, const int height, const int r) {
+    const __m128 inv = _mm_set1_ps(1.f/(2*r + 1));
+    const __m128i zero = _mm_setzero_si128();
+    const int primeEnd = qMin(r, height - 1);
+    int x = 0;
+    for(; x + 16 <= n; x += 16) {
+        __m128i acc[4] = {zero, zero, zero, zero};
+        __m128i w[4];
+        for(int y = 0; y <= primeEnd; y++) {
+            sse2Widen(src + static_cast<size_t>(y)*srcRowBytes + x, zero, w);
+            for(int i = 0; i < 4; i++) acc[i] = _mm_add_epi32(acc[i], w[i]);
+        }
+        for(int y = 0; y < height; y++) {
+            sse2Store(dst + static_cast<size_t>(y)*dstRowBytes + x, acc, inv);
+            const int yAdd = y + r + 1;
+            if(yAdd < height) {
+                const auto line = src + static_cast<size_t>(yAdd)*srcRowBytes;
+                sse2Widen(line + x, zero, w);
+                for(int i = 0; i < 4; i++) acc[i] = _mm_add_epi32(acc[i], w[i]);
+            }
+            const int ySub = y - r;
+            if(ySub >= 0) {
+                const auto line = src + static_cast<size_t>(ySub)*srcRowBytes;
+                sse2Widen(line + x, zero, w);
+                for(int i = 0; i < 4; i++) acc[i] = _mm_sub_epi32(acc[i], w[i]);
+            }
+        }
+    }
+    if(x < n) {
+        boxColumnsScalar(src + x, srcRowBytes, dst + x, dstRowBytes,
+                         n - x, height, r);
+    }
+}
+#endif
+
+#if defined(CPUBLUR_AVX2)
+CPUBLUR_AVX2_FUNC
+inline void avx2Widen(const uchar* p, __m256i* w) {
+    for(int i = 0; i < 4; i++) {
+        const auto half = reinterpret_cast<const __m128i*>(p + 8*i);
+        w[i] = _mm256_cvtepu8_epi32(_mm_loadl_epi64(half));
+    }
+}
+
+CPUBLUR_AVX2_FUNC
+inline void avx2Store(uchar* p, const __m256i* acc, const __m256 inv) {
+    __m256i q[4];
+    for(int i = 0; i < 4; i++) {
+        const __m256 accF = _mm256_cvtepi32_ps(acc[i]);
+        q[i] = _mm256_cvtps_epi32(_mm256_mul_ps(accF, inv));
+    }
+    // pack instructions interleave 128-bit lanes, restore linear order
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    const __m256i q01 = _mm256_packs_epi32(q[0], q[1]);
+    const __m256i q23 = _mm256_packs_epi32(q[2], q[3]);
+    const __m256i q8 = _mm256_packus_epi16(q01, q23);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p),
+                        _mm256_permutevar8x32_epi32(q8, order));
+}
+
+CPUBLUR_AVX2_FUNC
+void boxColumnsAvx2(const uchar* src, const size_t srcRowBytes,
+                    uchar* dst, const size_t dstRowBytes,
+                    const int n, const int height, const int r) {
+    const __m256 inv = _mm256_set1_ps(1.f/(2*r + 1));
+    const int primeEnd = qMin(r, height - 1);
+    int x = 0;
+    for(; x + 32 <= n; x += 32) {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i acc[4] = {zero, zero, zero, zero};
+        __m256i w[4];
+        for(int y = 0; y <= primeEnd; y++) {
+            avx2Widen(src + static_cast<size_t>(y)*srcRowBytes + x, w);
+            for(int i = 0; i < 4; i++) acc[i] = _mm256_add_epi32(acc[i], w[i]);
+        }
+        for(int y = 0; y < height; y++) {
+            avx2Store(dst + static_cast<size_t>(y)*dstRowBytes + x, acc, inv);
+            const int yAdd = y + r + 1;
+            if(yAdd < height) {
+                const auto line = src + static_cast<size_t>(yAdd)*srcRowBytes;
+                avx2Widen(line + x, w);
+                for(int i = 0; i < 4; i++) acc[i] = _mm256_add_epi32(acc[i], w[i]);
+            }
+            const int ySub = y - r;
+            if(ySub >= 0) {
+                const auto line = src + static_cast<size_t>(ySub)*srcRowBytes;
+                avx2Widen(line + x, w);
+                for(int i = 0; i < 4; i++) acc[i] = _mm256_sub_epi32(acc[i], w[i]);
+            }
+        }
+    }
+    if(x < n) {
+        boxColumnsSse2(src + x, srcRowBytes, dst + x, dstRowBytes,
+                       n - x, height, r);
+    }
+}
+#endif
+
+#if defined(CPUBLUR_NEON)
+inline void neonWiden(const uchar* p, uint32x4_t* w) {
+    const uint8x16_t v = vld1q_u8(p);
+    const uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+    const uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+    w[0] = vmovl_u16(vget_low_u16(lo));
+    w[1] = vmovl_u16(vget_high_u16(lo));
+    w[2] = vmovl_u16(vget_low_u16(hi));
+    w[3] = vmovl_u16(vget_high_u16(hi));
+}
+
+inline void neonStore(uchar* p, const uint32x4_t* acc, const float inv) {
+    uint16x4_t q[4];
+    for(int i = 0; i < 4; i++) {
+        const float32x4_t accF = vmulq_n_f32(vcvtq_f32_u32(acc[i]), inv);
+        q[i] = vmovn_u32(vcvtnq_u32_f32(accF));
+    }
+    const uint8x8_t q01 = vqmovn_u16(vcombine_u16(q[0], q[1]));
+    const uint8x8_t q23 = vqmovn_u16(vcombine_u16(q[2], q[3]));
+    vst1q_u8(p, vcombine_u8(q01, q23));
+}
+
+void boxColumnsNeon(const uchar* src, const size_t srcRowBytes,
+                    uchar* dst, const size_t dstRowBytes,
+                    const int n, const int height, const int r) {
+    const float inv = 1.f/(2*r + 1);
+    const int primeEnd = qMin(r, height - 1);
+    int x = 0;
+    for(; x + 16 <= n; x += 16) {
+        const uint32x4_t zero = vdupq_n_u32(0);
+        uint32x4_t acc[4] = {zero, zero, zero, zero};
+        uint32x4_t w[4];
+        for(int y = 0; y <= primeEnd; y++) {
+            neonWiden(src + static_cast<size_t>(y)*srcRowBytes + x, w);
+            for(int i = 0; i < 4; i++) acc[i] = vaddq_u32(acc[i], w[i]);
+        }
+        for(int y = 0; y < height; y++) {
+            neonStore(dst + static_cast<size_t>(y)*dstRowBytes + x, acc, inv);
+            const int yAdd = y + r + 1;
+            if(yAdd < height) {
+                const auto line = src + static_cast<size_t>(yAdd)*srcRowBytes;
+                neonWiden(line + x, w);
+                for(int i = 0; i < 4; i++) acc[i] = vaddq_u32(acc[i], w[i]);
+            }
+            const int ySub = y - r;
+            if(ySub >= 0) {
+                const auto line = src + static_cast<size_t>(ySub)*srcRowBytes;
+                neonWiden(line + x, w);
+                for(int i = 0; i < 4; i++) acc[i] = vsubq_u32(acc[i], w[i]);
+            }
+        }
+    }
+    if(x < n) {
+        boxColumnsScalar(src + x, srcRowBytes, dst + x, dstRowBytes,
+                         n - x, height, r);
+    }
+}
+#endif
+
+ColumnsKernel selectColumnsKernel() {
+#if defined(CPUBLUR_AVX2)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) return boxColumnsAvx2;
+#endif
+#if defined(CPUBLUR_SSE2)
+    return boxColumnsSse2;
+#elif defined(CPUBLUR_NEON)
+    return boxColumnsNeon;
+#else
+    return boxColumnsScalar;
+#endif
+}
+
+ColumnsKernel columnsKernel() {
+    static const ColumnsKernel kernel = selectColumnsKernel();
+    return kernel;
+}
+
+int nonZeroBoxes(const CpuBlur::Boxes& boxes) {
+    int result = 0;
+    for(const int r : boxes.fRadius) {
+        if(r > 0) result++;
+    }
+    return result;
+}
+
+void copyLines(const uchar* src, const size_t srcRowBytes,
+               uchar* dst, const size_t dstRowBytes,
+               const int n, const int height) {
+    if(src == dst) return;
+    for(int y = 0; y < height; y++) {
+        memcpy(dst + static_cast<size_t>(y)*dstRowBytes,
+               src + static_cast<size_t>(y)*srcRowBytes,
+               static_cast<size_t>(n));
+    }
+}
+
+}
+
+CpuBlur::Boxes CpuBlur::sGaussianBoxes(const float sigma) {
+    Boxes boxes{{0, 0, 0}};
+    if(sigma <= 0) return boxes;
+    // Kovesi, "Fast Almost-Gaussian Filtering"
+    const int n = 3;
+    const float sigma2 = sigma*sigma;
+    const float wIdeal = std::sqrt(12*sigma2/n + 1);
+    int wl = static_cast<int>(std::floor(wIdeal));
+    if(wl % 2 == 0) wl--;
+    const int wu = wl + 2;
+    const float mIdeal = (12*sigma2 - n*wl*wl - 4*n*wl - 3*n)/(-4*wl - 4);
+    const int m = qRound(mIdeal);
+    for(int i = 0; i < n; i++) {
+        const int w = i < m ? wl : wu;
+        boxes.fRadius[i] = (w - 1)/2;
+    }
+    return boxes;
+}
+
+void CpuBlur::sBlurRows(const uchar* src, const size_t srcRowBytes,
+                        uchar* dst, const size_t dstRowBytes,
+                        const int width, const int height,
+                        const int nChannels, const Boxes& boxes) {
+    if(width <= 0 || height <= 0) return;
+    const int lineBytes = width*nChannels;
+    const int nBoxes = nonZeroBoxes(boxes);
+    if(nBoxes == 0) {
+        return copyLines(src, srcRowBytes, dst, dstRowBytes,
+                         lineBytes, height);
+    }
+    std::vector<uchar> tmp(2*static_cast<size_t>(lineBytes));
+    uchar* const tmps[2] = {tmp.data(), tmp.data() + lineBytes};
+    for(int y = 0; y < height; y++) {
+        const uchar* in = src + static_cast<size_t>(y)*srcRowBytes;
+        uchar* const dstLine = dst + static_cast<size_t>(y)*dstRowBytes;
+        int applied = 0;
+        for(const int r : boxes.fRadius) {
+            if(r == 0) continue;
+            const bool last = ++applied == nBoxes;
+            const bool toDst = last && (applied > 1 || in != dstLine);
+            uchar* const out = toDst ? dstLine : tmps[applied % 2];
+            boxRow(in, out, width, nChannels, r);
+            in = out;
+        }
+        if(in != dstLine) memcpy(dstLine, in, static_cast<size_t>(lineBytes));
+    }
+}
+
+void CpuBlur::sBlurColumns(const uchar* src, const size_t srcRowBytes,
+                           uchar* dst, const size_t dstRowBytes,
+                           const int widthBytes, const int height,
+                           const Boxes& boxes) {
+    if(widthBytes <= 0 || height <= 0) return;
+    const int nBoxes = nonZeroBoxes(boxes);
+    if(nBoxes == 0) {
+        return copyLines(src, srcRowBytes, dst, dstRowBytes,
+                         widthBytes, height);
+    }
+    const auto kernel = columnsKernel();
+    const size_t tmpRowBytes = CPUBLUR_STRIP_BYTES;
+    const size_t tmpBytes = tmpRowBytes*static_cast<size_t>(height);
+    std::vector<uchar> tmp(2*tmpBytes);
+    uchar* const tmps[2] = {tmp.data(), tmp.data() + tmpBytes};
+    for(int x0 = 0; x0 < widthBytes; x0 += CPUBLUR_STRIP_BYTES) {
+        const int n = qMin(CPUBLUR_STRIP_BYTES, widthBytes - x0);
+        const uchar* in = src + x0;
+        size_t inRowBytes = srcRowBytes;
+        uchar* const dstStrip = dst + x0;
+        int applied = 0;
+        for(const int r : boxes.fRadius) {
+            if(r == 0) continue;
+            const bool last = ++applied == nBoxes;
+            const bool toDst = last && (applied > 1 || in != dstStrip);
+            uchar* const out = toDst ? dstStrip : tmps[applied % 2];
+            const size_t outRowBytes = toDst ? dstRowBytes : tmpRowBytes;
+            kernel(in, inRowBytes, out, outRowBytes, n, height, r);
+            in = out;
+            inRowBytes = outRowBytes;
+        }
+        copyLines(in, inRowBytes, dstStrip, dstRowBytes, n, height);
+    }
+}
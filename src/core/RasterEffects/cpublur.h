@@ -0,0 +1,61 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef CPUBLUR_H
+#define CPUBLUR_H
+
+#include "../core_global.h"
+
+#include <QtCore>
+
+//! @brief Separable gaussian blur approximation for raster effects
+//! rendered on the CPU. Every pass uses sliding accumulators,
+//! so the cost per pixel does not depend on the blur radius.
+namespace CpuBlur {
+    //! @brief Radii of three consecutive box blurs
+    struct CORE_EXPORT Boxes {
+        int fRadius[3];
+
+        bool isIdentity() const {
+            return fRadius[0] == 0 && fRadius[1] == 0 && fRadius[2] == 0;
+        }
+    };
+
+    //! @brief Box radii approximating a gaussian blur with the given sigma
+    CORE_EXPORT
+    Boxes sGaussianBoxes(const float sigma);
+
+    //! @brief Blurs each row horizontally, pixels outside are transparent.
+    //! Each pixel has nChannels interleaved 8-bit channels.
+    //! src and dst may point to the same memory.
+    CORE_EXPORT
+    void sBlurRows(const uchar* src, const size_t srcRowBytes,
+                   uchar* dst, const size_t dstRowBytes,
+                   const int width, const int height,
+                   const int nChannels, const Boxes& boxes);
+
+    //! @brief Blurs each column of bytes vertically,
+    //! pixels outside are transparent.
+    //! src and dst may point to the same memory.
+    CORE_EXPORT
+    void sBlurColumns(const uchar* src, const size_t srcRowBytes,
+                      uchar* dst, const size_t dstRowBytes,
+                      const int widthBytes, const int height,
+                      const Boxes& boxes);
+};
+
+#endif // CPUBLUR_H
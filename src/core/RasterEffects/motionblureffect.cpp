@@ -106,12 +106,12 @@ stdsptr<RasterEffectCaller> MotionBlurEffect::getEffectCaller(
     QList<stdsptr<BoxRenderData>> samples;
     for(int i = 0; i < nSamples; i++) {
         if(!idRange.inRange(sampleRelFrame)) {
-            const auto sample = mParentBox->queExternalRender(sampleRelFrame, true);
+            const auto sample = mParentBox->queMotionBlurSample(sampleRelFrame);
             if(sample) {
                 if(sample->finished()) {
                     data->fOtherGlobalRects << sample->fGlobalRect;
                 } else {
-                    sample->fMotionBlurTarget = data;
+                    sample->fMotionBlurTargets << data;
                     sample->addDependent(data);
                 }
                 samples << sample;
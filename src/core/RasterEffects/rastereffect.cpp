@@ -58,6 +58,15 @@ QMimeData *RasterEffect::SWT_createMimeData() {
     return new eMimeData(QList<RasterEffect*>() << this);
 }
 
+#include "Private/Tasks/taskscheduler.h"
+HardwareSupport RasterEffect::instanceHwSupport() const {
+    if(mTypeHwSupport != HardwareSupport::gpuOnly &&
+       !TaskScheduler::sGpuAvailable()) {
+        return HardwareSupport::cpuOnly;
+    }
+    return mInstHwSupport;
+}
+
 void RasterEffect::switchInstanceHwSupport() {
     if(mTypeHwSupport == HardwareSupport::cpuOnly) return;
     if(mTypeHwSupport == HardwareSupport::gpuOnly) return;
@@ -56,9 +56,9 @@ public:
     void writeIdentifier(eWriteStream& dst) const;
     void writeIdentifierXEV(QDomElement& ele) const;
 
-    HardwareSupport instanceHwSupport() const {
-        return mInstHwSupport;
-    }
+    //! @brief Falls back to cpuOnly when no GPU is available,
+    //! unless the effect has no CPU implementation.
+    HardwareSupport instanceHwSupport() const;
 
     void switchInstanceHwSupport();
 signals:
@@ -24,6 +24,16 @@
 
 enum class HardwareSupport : short;
 
+//! @brief Direction in which the tiles of a cpu pass may be split
+enum class CpuTileSplit : short {
+    //! @brief Split along the longer side
+    any,
+    //! @brief Every tile covers whole rows
+    rows,
+    //! @brief Every tile covers whole columns
+    columns
+};
+
 class CORE_EXPORT RasterEffectCaller : public StdSelfRef {
     e_OBJECT
 public:
@@ -45,6 +55,20 @@ public:
 
     virtual int cpuThreads(const int available, const int area) const;
 
+    //! @brief Number of consecutive cpu passes,
+    //! all tiles of a pass are processed before the next pass starts.
+    virtual int cpuPasses() const { return 1; }
+
+    virtual CpuTileSplit cpuTileSplit(const int pass) const {
+        Q_UNUSED(pass)
+        return CpuTileSplit::any;
+    }
+
+    //! @brief Called before spawning the tiles of each cpu pass
+    virtual void setupCpuPass(const CpuRenderData& data) {
+        Q_UNUSED(data)
+    }
+
     virtual bool srcDstSeparation() const { return true; }
 
     HardwareSupport hardwareSupport() const {
@@ -3,6 +3,7 @@
 #include "Boxes/containerbox.h"
 #include "svgexporter.h"
 #include "svgexporthelpers.h"
+#include "cpublur.h"
 
 class ShadowEffectCaller : public RasterEffectCaller {
 public:
@@ -16,19 +17,32 @@ public:
         mRadius(static_cast<float>(radius)),
         mColor(toSkColor(color)),
         mTranslation(toSkPoint(translation)),
-        mOpacity(static_cast<float>(opacity)) {}
+        mOpacity(static_cast<float>(opacity)),
+        mBoxes(CpuBlur::sGaussianBoxes(mRadius*0.3333333f)) {}
 
     void processGpu(QGL33 * const gl,
                     GpuRenderTools& renderTools);
     void processCpu(CpuRenderTools& renderTools,
                     const CpuRenderData &data);
+
+    int cpuPasses() const { return 2; }
+    CpuTileSplit cpuTileSplit(const int pass) const {
+        return pass == 0 ? CpuTileSplit::rows : CpuTileSplit::columns;
+    }
+    void setupCpuPass(const CpuRenderData& data);
 private:
     void setupPaint(SkPaint& paint, const int sign) const;
+    void composite(const CpuRenderTools& renderTools,
+                   const CpuRenderData &data,
+                   const uchar* const shadow) const;
 
     const float mRadius;
     const SkColor mColor;
     const SkPoint mTranslation;
     const SkScalar mOpacity;
+    const CpuBlur::Boxes mBoxes;
+    //! @brief Source alpha after the horizontal pass
+    std::vector<uchar> mAlpha;
 };
 
 ShadowEffect::ShadowEffect() :
@@ -147,30 +161,98 @@ void ShadowEffectCaller::processGpu(QGL33 * const gl,
     renderTools.swapTextures();
 }
 
+void ShadowEffectCaller::setupCpuPass(const CpuRenderData& data) {
+    if(data.fPass != 0) return;
+    mAlpha.resize(static_cast<size_t>(data.fWidth)*data.fHeight);
+}
+
 void ShadowEffectCaller::processCpu(CpuRenderTools &renderTools,
                                     const CpuRenderData &data) {
-    Q_UNUSED(data)
-    SkCanvas canvas(renderTools.fDstBtmp);
-    canvas.clear(SK_ColorTRANSPARENT);
+    const auto& srcBtmp = renderTools.fSrcBtmp;
+    const auto& texTile = data.fTexTile;
+    const int width = static_cast<int>(data.fWidth);
+    const int height = static_cast<int>(data.fHeight);
+    if(data.fPass == 0) {
+        Q_ASSERT(texTile.width() == width);
+        const auto alpha = mAlpha.data() + texTile.top()*width;
+        for(int y = 0; y < texTile.height(); y++) {
+            const auto src = static_cast<const uchar*>(
+                        srcBtmp.getAddr(0, texTile.top() + y));
+            const auto dst = alpha + y*width;
+            for(int x = 0; x < width; x++) dst[x] = src[4*x + 3];
+        }
+        CpuBlur::sBlurRows(alpha, width, alpha, width,
+                           width, texTile.height(), 1, mBoxes);
+        return;
+    }
+    Q_ASSERT(texTile.height() == height);
+    // the shadow of a tile comes from columns shifted by the translation,
+    // with one more column for the sub-pixel part of the translation
+    const int tileWidth = texTile.width();
+    const int shadowWidth = tileWidth + 1;
+    const int dx = qFloor(mTranslation.x());
+    const int shadowLeft = texTile.left() - dx - 1;
+    const int c0 = qMax(0, shadowLeft);
+    const int c1 = qMin(width, shadowLeft + shadowWidth);
+    std::vector<uchar> shadow(static_cast<size_t>(shadowWidth)*height, 0);
+    if(c1 > c0) {
+        CpuBlur::sBlurColumns(mAlpha.data() + c0, width,
+                              shadow.data() + c0 - shadowLeft, shadowWidth,
+                              c1 - c0, height, mBoxes);
+    }
+    composite(renderTools, data, shadow.data());
+}
 
-    const int radCeil = static_cast<int>(ceil(mRadius));
+void ShadowEffectCaller::composite(const CpuRenderTools &renderTools,
+                                   const CpuRenderData &data,
+                                   const uchar * const shadow) const {
     const auto& srcBtmp = renderTools.fSrcBtmp;
+    const auto& dstBtmp = renderTools.fDstBtmp;
     const auto& texTile = data.fTexTile;
-    auto srcRect = texTile.makeOutset(radCeil, radCeil);
-    const SkScalar dx = mTranslation.x();
-    const SkScalar dy = mTranslation.y();
-    const int ceilDX = isZero4Dec(dx) ? 0 : (dx > 0 ? qCeil(dx) : qFloor(dx));
-    const int ceilDY = isZero4Dec(dy) ? 0 : (dy > 0 ? qCeil(dy) : qFloor(dy));
-    srcRect.adjust(-ceilDX, -ceilDY, 0, 0);
-    if(srcRect.intersect(srcRect, srcBtmp.bounds())) {
-        SkBitmap tileSrc;
-        srcBtmp.extractSubset(&tileSrc, srcRect);
-        const int drawX = srcRect.left() - texTile.left();
-        const int drawY = srcRect.top() - texTile.top();
-        canvas.drawBitmap(tileSrc, drawX, drawY);
-
-        SkPaint paint;
-        setupPaint(paint, 1);
-        canvas.drawBitmap(tileSrc, drawX, drawY, &paint);
+    const int tileWidth = texTile.width();
+    const int height = static_cast<int>(data.fHeight);
+    const int shadowWidth = tileWidth + 1;
+    const int dy = qFloor(mTranslation.y());
+    // sub-pixel translation, the shadow is interpolated linearly
+    const float fx = mTranslation.x() - qFloor(mTranslation.x());
+    const float fy = mTranslation.y() - dy;
+    const auto shadowAt = [&](const int sy, const int x) {
+        if(sy < 0 || sy >= height) return 0.f;
+        const uchar* const line = shadow + sy*shadowWidth;
+        return line[x + 1]*(1 - fx) + line[x]*fx;
+    };
+
+    const float inv255 = 1.f/255;
+    const float colorA = SkColorGetA(mColor)*inv255;
+    const float colorR = SkColorGetR(mColor)*inv255;
+    const float colorG = SkColorGetG(mColor)*inv255;
+    const float colorB = SkColorGetB(mColor)*inv255;
+    for(int y = 0; y < texTile.height(); y++) {
+        const auto src = static_cast<const uchar*>(
+                    srcBtmp.getAddr(texTile.left(), texTile.top() + y));
+        const auto dst = static_cast<uchar*>(dstBtmp.getAddr(0, y));
+        const int sy = texTile.top() + y - dy;
+        for(int x = 0; x < tileWidth; x++) {
+            const uchar* const s = src + 4*x;
+            uchar* const d = dst + 4*x;
+            const float sA = s[3]*inv255;
+            const float shA = (shadowAt(sy, x)*(1 - fy) +
+                               shadowAt(sy - 1, x)*fy)*inv255*colorA;
+            // source over shadow
+            const float shM = shA*(1 - sA);
+            const float q[4] = {s[0]*inv255 + colorR*shM,
+                                 s[1]*inv255 + colorG*shM,
+                                 s[2]*inv255 + colorB*shM,
+                                 sA + shM};
+            // opacity applied to unpremultiplied alpha
+            const float pA = qMin(1.f, q[3]*mOpacity);
+            const float pM = q[3] > 0 ? pA/q[3] : 0.f;
+            // result over source
+            for(int i = 0; i < 4; i++) {
+                const float p = q[i]*pM;
+                const float r = p + s[i]*inv255*(1 - pA);
+                d[i] = static_cast<uchar>(qRound(qBound(0.f, r, 1.f)*255));
+            }
+        }
     }
 }
@@ -22,8 +22,9 @@ ShaderEffect::ShaderEffect(const QString& name,
                            const ShaderEffectCreator * const creator,
                            const ShaderEffectProgram * const program,
                            const QList<stdsptr<ShaderPropertyCreator>> &props) :
-    RasterEffect(name, HardwareSupport::gpuOnly, false,
-                 RasterEffectType::CUSTOM_SHADER),
+    RasterEffect(name, program->fInterpreter ? HardwareSupport::gpuPreffered :
+                                               HardwareSupport::gpuOnly,
+                 false, RasterEffectType::CUSTOM_SHADER),
     mProgram(program), mCreator(creator) {
     for(const auto& propC : props)
         ca_addChild(propC->create());
@@ -39,42 +40,81 @@ void ShaderEffect::writeIdentifierXEV(QDomElement& ele) const {
     mCreator->writeIdentifierXEV(ele);
 }
 
+#include "Private/Tasks/taskscheduler.h"
+#include <QTimer>
+
 stdsptr<RasterEffectCaller> ShaderEffect::getEffectCaller(
         const qreal relFrame, const qreal resolution,
         const qreal influence, BoxRenderData * const data) const {
     Q_UNUSED(influence)
     Q_UNUSED(data)
+    if(!mProgram->fInterpreter) {
+        if(!TaskScheduler::sGpuAvailable()) {
+            reportCpuUnsupported();
+            return nullptr;
+        }
+        return createCaller(relFrame, resolution, HardwareSupport::gpuOnly);
+    }
+    return createCaller(relFrame, resolution, instanceHwSupport());
+}
+
+stdsptr<ShaderEffectCaller> ShaderEffect::createCaller(
+        const qreal relFrame, const qreal resolution,
+        const HardwareSupport hwSupport) const {
     std::unique_ptr<ShaderEffectJS> engineUPtr;
     takeJSEngine(engineUPtr);
     ShaderEffectJS& engine = *engineUPtr;
+    const bool gpu = hwSupport != HardwareSupport::cpuOnly;
+    const bool cpu = hwSupport != HardwareSupport::gpuOnly;
     const auto effect = enve::make_shared<ShaderEffectCaller>(
-                            std::move(engineUPtr), *mProgram);
+                            hwSupport, std::move(engineUPtr), *mProgram);
 
     QJSValueList setterArgs;
     UniformSpecifiers& uniSpecs = effect->mUniformSpecifiers;
+    CpuUniformSpecifiers& cpuUniSpecs = effect->mCpuUniformSpecifiers;
     const int argsCount = mProgram->fPropUniLocs.count();
     for(int i = 0; i < argsCount; i++) {
-        const GLint loc = mProgram->fPropUniLocs.at(i);
+        const GLint loc = gpu ? mProgram->fPropUniLocs.at(i) : -1;
+        const int cpuSlot = cpu ? mProgram->fPropUniSlots.at(i) : -1;
         const auto prop = ca_getChildAt(i);
         const auto& uniformC = mProgram->fPropUniCreators.at(i);
-        uniformC->create(engine, loc, prop, relFrame,
-                         resolution, setterArgs, uniSpecs);
+        uniformC->create(engine, loc, cpuSlot, prop, relFrame,
+                         resolution, setterArgs, uniSpecs, cpuUniSpecs);
     }
     engine.setValues(setterArgs);
     const int valsCount = mProgram->fValueHandlers.count();
     for(int i = 0; i < valsCount; i++) {
-        const GLint loc = mProgram->fValueLocs.at(i);
         const auto& value = mProgram->fValueHandlers.at(i);
-        uniSpecs << value->create(loc, &engine.getGlValueGetter(i));
+        auto& getter = engine.getGlValueGetter(i);
+        if(cpu) {
+            const int slot = mProgram->fValueSlots.at(i);
+            cpuUniSpecs << value->createCpu(slot, &getter);
+        }
+        if(gpu) {
+            const GLint loc = mProgram->fValueLocs.at(i);
+            uniSpecs << value->create(loc, &getter);
+        }
     }
     return effect;
 }
 
+void ShaderEffect::reportCpuUnsupported() const {
+    if(mProgram->fCpuUnsupportedReported) return;
+    mProgram->fCpuUnsupportedReported = true;
+    const QString text = "'" + prp_getName() + "' can not be rendered "
+                         "without a GPU, it is left out of the render.\n" +
+                         mProgram->fCpuError;
+    // not to show a dialog in the middle of the render setup
+    QTimer::singleShot(0, [text]() { gPrintException(false, text); });
+}
+
 void ShaderEffect::giveBackJSEngine(stduptr<ShaderEffectJS>&& engineUPtr) {
+    std::lock_guard<std::mutex> lock(mProgram->fEnginesMutex);
     mProgram->fEngines.push_back(std::move(engineUPtr));
 }
 
 void ShaderEffect::takeJSEngine(stduptr<ShaderEffectJS>& engineUPtr) const {
+    std::lock_guard<std::mutex> lock(mProgram->fEnginesMutex);
     if(mProgram->fEngines.empty()) {
         engineUPtr = std::make_unique<ShaderEffectJS>(*mProgram->fJSBlueprint);
     } else {
@@ -20,6 +20,8 @@
 #include "shadereffectcreator.h"
 #include "Tasks/updatable.h"
 
+class ShaderEffectCaller;
+
 template <typename T> using stduptr = std::unique_ptr<T>;
 
 class CORE_EXPORT ShaderEffect : public RasterEffect {
@@ -36,6 +38,12 @@ public:
             const qreal relFrame, const qreal resolution,
             const qreal influence, BoxRenderData* const data) const;
 
+    //! @brief Caller with the given hardware support,
+    //! the CPU is only supported if the program has an interpreter
+    stdsptr<ShaderEffectCaller> createCaller(
+            const qreal relFrame, const qreal resolution,
+            const HardwareSupport hwSupport) const;
+
     void updateIfUsesProgram(const ShaderEffectProgram * const program) {
         if(program == mProgram)
             prp_afterWholeInfluenceRangeChanged();
@@ -43,6 +51,8 @@ public:
 
     void giveBackJSEngine(stduptr<ShaderEffectJS>&& engineUPtr);
 private:
+    //! @brief Shows the user why the effect is missing, once per program
+    void reportCpuUnsupported() const;
     void takeJSEngine(stduptr<ShaderEffectJS>& engineUPtr) const;
 
     const ShaderEffectProgram * const mProgram;
@@ -18,14 +18,18 @@
 
 #include "shadereffectprogram.h"
 
-ShaderEffectCaller::ShaderEffectCaller(std::unique_ptr<ShaderEffectJS>&& engine,
+ShaderEffectCaller::ShaderEffectCaller(const HardwareSupport hwSupport,
+                                       std::unique_ptr<ShaderEffectJS>&& engine,
                                        const ShaderEffectProgram &program) :
-    RasterEffectCaller(HardwareSupport::gpuOnly, false, QMargins()),
-    mEngine(std::move(engine)), mProgramId(program.fId), mProgram(program) {
+    RasterEffectCaller(hwSupport, false, QMargins()),
+    mEngine(std::move(engine)), mProgramId(program.fId), mProgram(program),
+    mInterpreter(program.fInterpreter) {
     Q_ASSERT(mEngine.get());
+    Q_ASSERT(hwSupport == HardwareSupport::gpuOnly || mInterpreter);
 }
 
 ShaderEffectCaller::~ShaderEffectCaller() {
+    std::lock_guard<std::mutex> lock(mProgram.fEnginesMutex);
     mProgram.fEngines.push_back(std::move(mEngine));
 }
 
@@ -48,6 +52,24 @@ void ShaderEffectCaller::processGpu(QGL33 * const gl,
     renderTools.swapTextures();
 }
 
+void ShaderEffectCaller::setupCpuPass(const CpuRenderData& data) {
+    Q_UNUSED(data)
+    mCpuUniforms = mInterpreter->defaultUniforms();
+    for(const auto& uni : mCpuUniformSpecifiers) uni(mCpuUniforms);
+}
+
+void ShaderEffectCaller::processCpu(CpuRenderTools& renderTools,
+                                    const CpuRenderData& data) {
+    const auto& src = renderTools.fSrcBtmp;
+    const auto& dst = renderTools.fDstBtmp;
+    const auto& tile = data.fTexTile;
+    mInterpreter->render(mCpuUniforms,
+                         static_cast<const uchar*>(src.getPixels()),
+                         src.rowBytes(), src.width(), src.height(),
+                         static_cast<uchar*>(dst.getPixels()), dst.rowBytes(),
+                         tile.x(), tile.y(), tile.width(), tile.height());
+}
+
 QMargins ShaderEffectCaller::getMargin(const SkIRect &srcRect) {
     mEngine->setSceneRect(srcRect);
     mEngine->evaluate();
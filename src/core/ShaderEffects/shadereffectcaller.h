@@ -24,17 +24,23 @@
 class CORE_EXPORT ShaderEffectCaller : public RasterEffectCaller {
     e_OBJECT
 public:
-    ShaderEffectCaller(std::unique_ptr<ShaderEffectJS>&& engine,
+    ShaderEffectCaller(const HardwareSupport hwSupport,
+                       std::unique_ptr<ShaderEffectJS>&& engine,
                        const ShaderEffectProgram& program);
     ~ShaderEffectCaller();
 
     void processGpu(QGL33 * const gl,
                     GpuRenderTools& renderTools);
+    void processCpu(CpuRenderTools& renderTools,
+                    const CpuRenderData& data);
+
+    void setupCpuPass(const CpuRenderData& data);
 
     ShaderEffectJS& getJSEngine()
     { return *mEngine; }
 
     UniformSpecifiers mUniformSpecifiers;
+    CpuUniformSpecifiers mCpuUniformSpecifiers;
 protected:
     QMargins getMargin(const SkIRect &srcRect);
 private:
@@ -43,6 +49,8 @@ private:
     std::unique_ptr<ShaderEffectJS> mEngine;
     const GLuint mProgramId;
     const ShaderEffectProgram &mProgram;
+    const std::shared_ptr<const ShaderInterpreter> mInterpreter;
+    ShaderInterpreter::Uniforms mCpuUniforms;
 };
 
 
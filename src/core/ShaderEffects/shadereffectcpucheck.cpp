@@ -0,0 +1,113 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "shadereffectcpucheck.h"
+
+#include "shadereffect.h"
+#include "shadereffectcaller.h"
+#include "Private/Tasks/taskscheduler.h"
+#include "Tasks/updatable.h"
+
+//! @brief Largest channel difference still considered rounding
+static const int sTolerance = 2;
+
+SkBitmap checkSourceBitmap(const int width, const int height) {
+    SkBitmap bitmap;
+    bitmap.allocPixels(SkiaHelpers::getPremulRGBAInfo(width, height));
+    for(int y = 0; y < height; y++) {
+        auto dst = static_cast<uchar*>(bitmap.getAddr(0, y));
+        for(int x = 0; x < width; x++) {
+            const int a = x < width/2 ? 255 : 64 + (3*x + 5*y) % 192;
+            const int r = 255*x/(width - 1);
+            const int g = 255*y/(height - 1);
+            const int b = (x*y) % 256;
+            *dst++ = static_cast<uchar>(r*a/255);
+            *dst++ = static_cast<uchar>(g*a/255);
+            *dst++ = static_cast<uchar>(b*a/255);
+            *dst++ = static_cast<uchar>(a);
+        }
+    }
+    return bitmap;
+}
+
+ShaderEffectCpuCheck::ShaderEffectCpuCheck(const ShaderEffectCreator& creator) :
+    mName(creator.fName), mEffect(creator.create()) {
+    mSrc = checkSourceBitmap(64, 64);
+    const auto rect = SkIRect::MakeWH(mSrc.width(), mSrc.height());
+    mGpuCaller = mEffect->createCaller(0, 1, HardwareSupport::gpuOnly);
+    mGpuCaller->setSrcRect(rect, rect);
+    mCpuCaller = mEffect->createCaller(0, 1, HardwareSupport::cpuOnly);
+    mCpuCaller->setSrcRect(rect, rect);
+}
+
+void ShaderEffectCpuCheck::sCheck(const ShaderEffectCreator& creator) {
+    if(!creator.fProgram->fInterpreter) return;
+    if(!TaskScheduler::sGpuAvailable()) return;
+    enve::make_shared<ShaderEffectCpuCheck>(creator)->queTask();
+}
+
+void ShaderEffectCpuCheck::queTaskNow() {
+    TaskScheduler::instance()->queCpuTask(ref<eTask>());
+}
+
+void ShaderEffectCpuCheck::processGpu(QGL33 * const gl,
+                                      SwitchableContext &context) {
+    gl->glViewport(0, 0, mSrc.width(), mSrc.height());
+    const auto srcImage = SkImage::MakeRasterCopy(mSrc.pixmap());
+    const QRect globalRect(0, 0, mSrc.width(), mSrc.height());
+    GpuRenderTools renderTools(gl, context, srcImage, globalRect);
+    mGpuCaller->processGpu(gl, renderTools);
+    mGpuDst = renderTools.getSrcTexture().bitmapSnapshot(gl);
+}
+
+void ShaderEffectCpuCheck::afterProcessing() {
+    const auto thisRef = ref<ShaderEffectCpuCheck>();
+    const auto cpuTask = enve::make_shared<eCustomCpuTask>(
+                nullptr, [thisRef]() { thisRef->compareWithCpu(); },
+                nullptr, nullptr);
+    cpuTask->queTask();
+}
+
+void ShaderEffectCpuCheck::compareWithCpu() {
+    SkBitmap cpuDst;
+    cpuDst.allocPixels(mSrc.info());
+    CpuRenderData data;
+    data.fTexTile = SkIRect::MakeWH(mSrc.width(), mSrc.height());
+    data.fPos = QPoint(0, 0);
+    data.fWidth = static_cast<uint>(mSrc.width());
+    data.fHeight = static_cast<uint>(mSrc.height());
+    data.fPass = 0;
+    mCpuCaller->setupCpuPass(data);
+    CpuRenderTools renderTools{mSrc, cpuDst};
+    mCpuCaller->processCpu(renderTools, data);
+
+    int maxDiff = 0;
+    QPoint maxDiffPos;
+    for(int y = 0; y < mSrc.height(); y++) {
+        const auto gpu = static_cast<const uchar*>(mGpuDst.getAddr(0, y));
+        const auto cpu = static_cast<const uchar*>(cpuDst.getAddr(0, y));
+        for(int i = 0; i < 4*mSrc.width(); i++) {
+            const int diff = qAbs(gpu[i] - cpu[i]);
+            if(diff <= maxDiff) continue;
+            maxDiff = diff;
+            maxDiffPos = QPoint(i/4, y);
+        }
+    }
+    if(maxDiff > sTolerance) {
+        qWarning() << "CPU and GPU output of" << mName
+                   << "differ by" << maxDiff << "at" << maxDiffPos;
+    }
+}
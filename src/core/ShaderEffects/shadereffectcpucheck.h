@@ -0,0 +1,59 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SHADEREFFECTCPUCHECK_H
+#define SHADEREFFECTCPUCHECK_H
+#include "Tasks/etask.h"
+#include "skia/skiaincludes.h"
+
+class ShaderEffect;
+class ShaderEffectCaller;
+struct ShaderEffectCreator;
+
+//! @brief Renders a test image with the default property values of a shader
+//! effect on the GPU and with its ShaderInterpreter on the CPU, and reports
+//! pixels that differ by more than rounding. The CPU render and the
+//! comparison run in a separate CPU task, not in the main thread.
+class CORE_EXPORT ShaderEffectCpuCheck : public eTask {
+    e_OBJECT
+protected:
+    ShaderEffectCpuCheck(const ShaderEffectCreator& creator);
+public:
+    //! @brief Ques the check if the shader has a CPU implementation
+    //! and a GPU is available, does nothing otherwise
+    static void sCheck(const ShaderEffectCreator& creator);
+
+    HardwareSupport hardwareSupport() const
+    { return HardwareSupport::gpuOnly; }
+
+    void processGpu(QGL33 * const gl, SwitchableContext &context);
+    void process() {}
+protected:
+    void queTaskNow();
+    void afterProcessing();
+private:
+    //! @brief Renders on the CPU and compares with the GPU output
+    void compareWithCpu();
+
+    const QString mName;
+    const qsptr<ShaderEffect> mEffect;
+    stdsptr<ShaderEffectCaller> mGpuCaller;
+    stdsptr<ShaderEffectCaller> mCpuCaller;
+    SkBitmap mSrc;
+    SkBitmap mGpuDst;
+};
+
+#endif // SHADEREFFECTCPUCHECK_H
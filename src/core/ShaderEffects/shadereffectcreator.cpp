@@ -61,7 +61,7 @@ void ShaderEffectCreator::reloadProgram(QGL33 * const gl, const QString &fragPat
     } catch(...) {
         RuntimeThrow("Failed to load a new version of '" + fragPath + "'");
     }
-    gl->glDeleteProgram(oldProgram);
+    if(gl) gl->glDeleteProgram(oldProgram);
 }
 
 qsptr<ShaderEffect> ShaderEffectCreator::create() const {
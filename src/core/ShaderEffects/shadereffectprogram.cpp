@@ -16,6 +16,36 @@
 
 #include "shadereffectprogram.h"
 
+int interpreterSlot(const ShaderInterpreter& interpreter,
+                    const QString& name) {
+    const int slot = interpreter.uniformSlot(name);
+    if(slot < 0) RuntimeThrow("'" + name + "' is not a uniform variable.");
+    return slot;
+}
+
+void iniInterpreter(ShaderEffectProgram& program,
+                    const QString &fragPath,
+                    const QList<stdsptr<ShaderPropertyCreator>>& propCs,
+                    const QList<stdsptr<ShaderValueHandler>>& values) {
+    const auto interpreter = ShaderInterpreter::sCompileFile(fragPath);
+    if(interpreter->samplerName() != "texture")
+        RuntimeThrow("Expected the sampler uniform to be named 'texture'.");
+    QList<int> propSlots;
+    for(const auto& propC : propCs) {
+        if(propC->fGLValue) {
+            propSlots.append(interpreterSlot(*interpreter, propC->fName));
+        } else propSlots.append(-1);
+    }
+    QList<int> valueSlots;
+    for(const auto& value : values) {
+        valueSlots.append(interpreterSlot(*interpreter, value->fName));
+    }
+    program.fPropUniSlots = propSlots;
+    program.fValueSlots = valueSlots;
+    program.fInterpreter = std::shared_ptr<const ShaderInterpreter>(
+                               interpreter.release());
+}
+
 std::unique_ptr<ShaderEffectProgram>
 ShaderEffectProgram::sCreateProgram(
         QGL33 * const gl, const QString &fragPath,
@@ -25,14 +55,30 @@ ShaderEffectProgram::sCreateProgram(
         const QList<stdsptr<ShaderValueHandler>>& values) {
     std::unique_ptr<ShaderEffectProgram> program =
             std::make_unique<ShaderEffectProgram>();
+    program->fJSBlueprint = jsBlueprint;
+    program->fPropUniCreators = uniCs;
+    program->fValueHandlers = values;
+
+    try {
+        iniInterpreter(*program, fragPath, propCs, values);
+    } catch(const std::exception& e) {
+        if(!gl) RuntimeThrow("Could not interpret ShaderEffectProgram");
+        program->fCpuError = gAllTextFromException(e);
+    }
+    if(!gl) {
+        for(int i = 0; i < propCs.count(); i++)
+            program->fPropUniLocs.append(-1);
+        for(int i = 0; i < values.count(); i++)
+            program->fValueLocs.append(-1);
+        return program;
+    }
+
     try {
         iniProgram(gl, program->fId, GL_TEXTURED_VERT, fragPath);
     } catch(...) {
         RuntimeThrow("Could not initialize a program for ShaderEffectProgram");
     }
 
-    program->fJSBlueprint = jsBlueprint;
-
     for(const auto& propC : propCs) {
         if(propC->fGLValue) {
             const GLint loc = gl->glGetUniformLocation(program->fId,
@@ -45,7 +91,6 @@ ShaderEffectProgram::sCreateProgram(
             program->fPropUniLocs.append(loc);
         } else program->fPropUniLocs.append(-1);
     }
-    program->fPropUniCreators = uniCs;
     for(const auto& value : values) {
         const GLint loc = gl->glGetUniformLocation(program->fId,
                                                    value->fName.toLatin1());
@@ -56,7 +101,6 @@ ShaderEffectProgram::sCreateProgram(
         }
         program->fValueLocs.append(loc);
     }
-    program->fValueHandlers = values;
 
     program->fTexLocation = gl->glGetUniformLocation(program->fId, "texture");
     if(program->fTexLocation < 0) {
@@ -19,6 +19,9 @@
 #include "uniformspecifiercreator.h"
 #include "shadervaluehandler.h"
 #include "shadereffectjs.h"
+#include "shaderinterpreter.h"
+
+#include <mutex>
 
 typedef QList<stdsptr<UniformSpecifierCreator>> UniformSpecifierCreators;
 struct CORE_EXPORT ShaderEffectProgram {
@@ -34,8 +37,22 @@ struct CORE_EXPORT ShaderEffectProgram {
     QList<stdsptr<ShaderValueHandler>> fValueHandlers;
     QList<GLint> fValueLocs;
     std::shared_ptr<ShaderEffectJS::Blueprint> fJSBlueprint;
+    //! @brief Unused script instances, guarded by fEnginesMutex.
+    //! Instances are set up on the main thread and evaluated in render
+    //! threads, so each owns a private engine instead of using JSEnginePool
     mutable std::vector<std::unique_ptr<ShaderEffectJS>> fEngines;
+    mutable std::mutex fEnginesMutex;
+
+    //! @brief CPU implementation, null if the shader is not supported
+    std::shared_ptr<const ShaderInterpreter> fInterpreter;
+    //! @brief Why the shader could not be interpreted
+    QString fCpuError;
+    mutable bool fCpuUnsupportedReported = false;
+    QList<int> fPropUniSlots;
+    QList<int> fValueSlots;
 
+    //! @brief gl can be null when no GPU is available,
+    //! the program is then only executed on the CPU.
     static std::unique_ptr<ShaderEffectProgram> sCreateProgram(
             QGL33 * const gl, const QString &fragPath,
             const QList<stdsptr<ShaderPropertyCreator>>& propCs,
@@ -0,0 +1,1870 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "shaderinterpreter.h"
+
+#include <QFile>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <string>
+
+#include "exceptions.h"
+
+namespace {
+
+enum class Kind : uchar {
+    tVoid, tBool, tInt, tFloat, tSampler
+};
+
+struct Type {
+    Kind fKind;
+    int fSize;
+
+    bool operator==(const Type& other) const
+    { return fKind == other.fKind && fSize == other.fSize; }
+    bool operator!=(const Type& other) const
+    { return !(*this == other); }
+
+    bool numeric() const
+    { return fKind == Kind::tInt || fKind == Kind::tFloat; }
+    bool boolScalar() const
+    { return fKind == Kind::tBool && fSize == 1; }
+};
+
+const Type gVoid{Kind::tVoid, 0};
+const Type gBool{Kind::tBool, 1};
+const Type gInt{Kind::tInt, 1};
+const Type gFloat{Kind::tFloat, 1};
+const Type gVec2{Kind::tFloat, 2};
+const Type gVec4{Kind::tFloat, 4};
+const Type gSampler{Kind::tSampler, 0};
+
+Type withSize(const Type& type, const int size) {
+    return Type{type.fKind, size};
+}
+
+//! @brief Integer and boolean values are kept in floats,
+//! which represent them exactly within the shader range.
+struct Value {
+    float f[4];
+};
+
+enum class Flow {
+    next, breakLoop, continueLoop, returnFunc, discard
+};
+
+struct Exec {
+    Value* fMem;
+    const ShaderInterpreter::Uniforms* fUniforms;
+    const uchar* fSrc;
+    size_t fSrcRowBytes;
+    int fWidth;
+    int fHeight;
+    bool fDiscarded;
+};
+
+inline float comp(const Value& v, const int size, const int i) {
+    return v.f[size == 1 ? 0 : i];
+}
+
+inline int clampInt(const int val, const int min, const int max) {
+    return val < min ? min : (val > max ? max : val);
+}
+
+inline void fetch(const Exec& e, const int x, const int y, float* const rgba) {
+    const uchar* const pix = e.fSrc + size_t(y)*e.fSrcRowBytes + 4*x;
+    for(int i = 0; i < 4; i++) rgba[i] = pix[i];
+}
+
+void sample(const Exec& e, const float s, const float t, Value& out) {
+    if(!std::isfinite(s) || !std::isfinite(t) ||
+       e.fWidth <= 0 || e.fHeight <= 0) {
+        out = Value{{0, 0, 0, 0}};
+        return;
+    }
+    const float fx = qBound(-1.f, s*e.fWidth - 0.5f, float(e.fWidth));
+    const float fy = qBound(-1.f, t*e.fHeight - 0.5f, float(e.fHeight));
+    const float x0f = std::floor(fx);
+    const float y0f = std::floor(fy);
+    const float ax = fx - x0f;
+    const float ay = fy - y0f;
+    const int x0 = clampInt(int(x0f), 0, e.fWidth - 1);
+    const int x1 = clampInt(int(x0f) + 1, 0, e.fWidth - 1);
+    const int y0 = clampInt(int(y0f), 0, e.fHeight - 1);
+    const int y1 = clampInt(int(y0f) + 1, 0, e.fHeight - 1);
+    float p00[4], p10[4], p01[4], p11[4];
+    fetch(e, x0, y0, p00);
+    fetch(e, x1, y0, p10);
+    fetch(e, x0, y1, p01);
+    fetch(e, x1, y1, p11);
+    for(int i = 0; i < 4; i++) {
+        const float top = p00[i] + (p10[i] - p00[i])*ax;
+        const float bottom = p01[i] + (p11[i] - p01[i])*ax;
+        out.f[i] = (top + (bottom - top)*ay)*(1.f/255);
+    }
+}
+
+// Expressions
+
+struct Expr {
+    Expr(const Type& type) : fType(type) {}
+    virtual ~Expr() = default;
+
+    virtual void eval(Exec& e, Value& out) const = 0;
+
+    virtual bool assignable() const { return false; }
+    virtual void store(Exec& e, const Value& val) const {
+        Q_UNUSED(e)
+        Q_UNUSED(val)
+    }
+
+    const Type fType;
+};
+
+using ExprPtr = std::unique_ptr<Expr>;
+
+struct ConstExpr : public Expr {
+    ConstExpr(const Type& type, const Value& val) :
+        Expr(type), mVal(val) {}
+
+    void eval(Exec& e, Value& out) const {
+        Q_UNUSED(e)
+        out = mVal;
+    }
+private:
+    const Value mVal;
+};
+
+struct VarExpr : public Expr {
+    VarExpr(const Type& type, const int slot, const bool readOnly) :
+        Expr(type), mSlot(slot), mReadOnly(readOnly) {}
+
+    void eval(Exec& e, Value& out) const
+    { out = e.fMem[mSlot]; }
+
+    bool assignable() const { return !mReadOnly; }
+    void store(Exec& e, const Value& val) const
+    { e.fMem[mSlot] = val; }
+private:
+    const int mSlot;
+    const bool mReadOnly;
+};
+
+struct UniformExpr : public Expr {
+    UniformExpr(const Type& type, const int slot) :
+        Expr(type), mSlot(static_cast<size_t>(slot)) {}
+
+    void eval(Exec& e, Value& out) const {
+        const auto& uni = (*e.fUniforms)[mSlot];
+        for(int i = 0; i < 4; i++) out.f[i] = uni[static_cast<size_t>(i)];
+    }
+private:
+    const size_t mSlot;
+};
+
+struct SwizzleExpr : public Expr {
+    SwizzleExpr(ExprPtr&& base, const std::vector<int>& comps) :
+        Expr(withSize(base->fType, static_cast<int>(comps.size()))),
+        mBase(std::move(base)) {
+        mUnique = true;
+        for(int i = 0; i < fType.fSize; i++) {
+            mComps[i] = comps[static_cast<size_t>(i)];
+            for(int j = 0; j < i; j++) {
+                if(mComps[j] == mComps[i]) mUnique = false;
+            }
+        }
+    }
+
+    void eval(Exec& e, Value& out) const {
+        Value base;
+        mBase->eval(e, base);
+        for(int i = 0; i < fType.fSize; i++) out.f[i] = base.f[mComps[i]];
+    }
+
+    bool assignable() const
+    { return mUnique && mBase->assignable(); }
+
+    void store(Exec& e, const Value& val) const {
+        Value base;
+        mBase->eval(e, base);
+        for(int i = 0; i < fType.fSize; i++) base.f[mComps[i]] = val.f[i];
+        mBase->store(e, base);
+    }
+private:
+    const ExprPtr mBase;
+    int mComps[4];
+    bool mUnique;
+};
+
+struct IndexExpr : public Expr {
+    IndexExpr(ExprPtr&& base, ExprPtr&& index) :
+        Expr(withSize(base->fType, 1)),
+        mBase(std::move(base)), mIndex(std::move(index)) {}
+
+    void eval(Exec& e, Value& out) const {
+        Value base;
+        mBase->eval(e, base);
+        out.f[0] = base.f[index(e)];
+    }
+
+    bool assignable() const { return mBase->assignable(); }
+
+    void store(Exec& e, const Value& val) const {
+        Value base;
+        mBase->eval(e, base);
+        base.f[index(e)] = val.f[0];
+        mBase->store(e, base);
+    }
+private:
+    int index(Exec& e) const {
+        Value id;
+        mIndex->eval(e, id);
+        return clampInt(int(id.f[0]), 0, mBase->fType.fSize - 1);
+    }
+
+    const ExprPtr mBase;
+    const ExprPtr mIndex;
+};
+
+//! @brief Explicit and implicit conversions, broadcasts scalars
+struct ConvertExpr : public Expr {
+    ConvertExpr(const Type& type, ExprPtr&& src) :
+        Expr(type), mSrc(std::move(src)) {}
+
+    void eval(Exec& e, Value& out) const {
+        Value src;
+        mSrc->eval(e, src);
+        const int srcSize = mSrc->fType.fSize;
+        for(int i = 0; i < fType.fSize; i++) {
+            const float val = comp(src, srcSize, i);
+            switch(fType.fKind) {
+            case Kind::tInt: out.f[i] = std::trunc(val); break;
+            case Kind::tBool: out.f[i] = val != 0.f ? 1.f : 0.f; break;
+            default: out.f[i] = val;
+            }
+        }
+    }
+private:
+    const ExprPtr mSrc;
+};
+
+struct ConstructExpr : public Expr {
+    ConstructExpr(const Type& type, std::vector<ExprPtr>&& args) :
+        Expr(type), mArgs(std::move(args)) {}
+
+    void eval(Exec& e, Value& out) const {
+        int id = 0;
+        for(const auto& arg : mArgs) {
+            Value val;
+            arg->eval(e, val);
+            for(int i = 0; i < arg->fType.fSize && id < fType.fSize; i++)
+                out.f[id++] = convert(val.f[i]);
+        }
+    }
+private:
+    float convert(const float val) const {
+        switch(fType.fKind) {
+        case Kind::tInt: return std::trunc(val);
+        case Kind::tBool: return val != 0.f ? 1.f : 0.f;
+        default: return val;
+        }
+    }
+
+    const std::vector<ExprPtr> mArgs;
+};
+
+enum class BinOp {
+    add, sub, mul, div, mod,
+    less, greater, lessEq, greaterEq,
+    equal, notEqual
+};
+
+template <BinOp OP>
+inline float binOp(const float a, const float b, const bool integer) {
+    switch(OP) {
+    case BinOp::add: return a + b;
+    case BinOp::sub: return a - b;
+    case BinOp::mul: return a*b;
+    case BinOp::div:
+        if(integer) return b == 0.f ? 0.f : std::trunc(a/b);
+        return a/b;
+    case BinOp::mod:
+        return b == 0.f ? 0.f : std::fmod(a, b);
+    case BinOp::less: return a < b;
+    case BinOp::greater: return a > b;
+    case BinOp::lessEq: return a <= b;
+    case BinOp::greaterEq: return a >= b;
+    default: return 0;
+    }
+}
+
+//! @brief Component-wise arithmetic and scalar comparisons
+template <BinOp OP>
+struct BinaryExpr : public Expr {
+    BinaryExpr(const Type& type, ExprPtr&& a, ExprPtr&& b) :
+        Expr(type), mA(std::move(a)), mB(std::move(b)),
+        mInteger(mA->fType.fKind == Kind::tInt &&
+                 mB->fType.fKind == Kind::tInt) {}
+
+    void eval(Exec& e, Value& out) const {
+        Value a, b;
+        mA->eval(e, a);
+        mB->eval(e, b);
+        const int aSize = mA->fType.fSize;
+        const int bSize = mB->fType.fSize;
+        for(int i = 0; i < fType.fSize; i++) {
+            out.f[i] = binOp<OP>(comp(a, aSize, i), comp(b, bSize, i),
+                                 mInteger);
+        }
+    }
+private:
+    const ExprPtr mA;
+    const ExprPtr mB;
+    const bool mInteger;
+};
+
+struct EqualityExpr : public Expr {
+    EqualityExpr(ExprPtr&& a, ExprPtr&& b, const bool equal) :
+        Expr(gBool), mA(std::move(a)), mB(std::move(b)), mEqual(equal) {}
+
+    void eval(Exec& e, Value& out) const {
+        Value a, b;
+        mA->eval(e, a);
+        mB->eval(e, b);
+        bool equal = true;
+        for(int i = 0; i < mA->fType.fSize; i++)
+            equal = equal && a.f[i] == b.f[i];
+        out.f[0] = equal == mEqual ? 1.f : 0.f;
+    }
+private:
+    const ExprPtr mA;
+    const ExprPtr mB;
+    const bool mEqual;
+};
+
+enum class LogicOp { andOp, orOp, xorOp };
+
+struct LogicalExpr : public Expr {
+    LogicalExpr(const LogicOp op, ExprPtr&& a, ExprPtr&& b) :
+        Expr(gBool), mOp(op), mA(std::move(a)), mB(std::move(b)) {}
+
+    void eval(Exec& e, Value& out) const {
+        Value val;
+        mA->eval(e, val);
+        const bool a = val.f[0] != 0.f;
+        if(mOp == LogicOp::andOp && !a) {
+            out.f[0] = 0.f;
+            return;
+        }
+        if(mOp == LogicOp::orOp && a) {
+            out.f[0] = 1.f;
+            return;
+        }
+        mB->eval(e, val);
+        const bool b = val.f[0] != 0.f;
+        if(mOp == LogicOp::xorOp) out.f[0] = a != b ? 1.f : 0.f;
+        else out.f[0] = b ? 1.f : 0.f;
+    }
+private:
+    const LogicOp mOp;
+    const ExprPtr mA;
+    const ExprPtr mB;
+};
+
+struct NegateExpr : public Expr {
+    NegateExpr(ExprPtr&& src) :
+        Expr(src->fType), mSrc(std::move(src)) {}
+
+    void eval(Exec& e, Value& out) const {
+        mSrc->eval(e, out);
+        for(int i = 0; i < fType.fSize; i++) out.f[i] = -out.f[i];
+    }
+private:
+    const ExprPtr mSrc;
+};
+
+struct NotExpr : public Expr {
+    NotExpr(ExprPtr&& src) :
+        Expr(gBool), mSrc(std::move(src)) {}
+
+    void eval(Exec& e, Value& out) const {
+        mSrc->eval(e, out);
+        out.f[0] = out.f[0] != 0.f ? 0.f : 1.f;
+    }
+private:
+    const ExprPtr mSrc;
+};
+
+struct TernaryExpr : public Expr {
+    TernaryExpr(const Type& type, ExprPtr&& cond, ExprPtr&& a, ExprPtr&& b) :
+        Expr(type), mCond(std::move(cond)),
+        mA(std::move(a)), mB(std::move(b)) {}
+
+    void eval(Exec& e, Value& out) const {
+        mCond->eval(e, out);
+        if(out.f[0] != 0.f) mA->eval(e, out);
+        else mB->eval(e, out);
+    }
+private:
+    const ExprPtr mCond;
+    const ExprPtr mA;
+    const ExprPtr mB;
+};
+
+//! @brief Assignment, the value is already converted to the target type
+struct AssignExpr : public Expr {
+    AssignExpr(ExprPtr&& target, ExprPtr&& value) :
+        Expr(target->fType), mTarget(std::move(target)),
+        mValue(std::move(value)) {}
+
+    void eval(Exec& e, Value& out) const {
+        mValue->eval(e, out);
+        mTarget->store(e, out);
+    }
+private:
+    const ExprPtr mTarget;
+    const ExprPtr mValue;
+};
+
+//! @brief Reads the target of a compound assignment,
+//! the target is evaluated again when storing the result
+struct TargetReadExpr : public Expr {
+    TargetReadExpr(const Expr* const target) :
+        Expr(target->fType), mTarget(target) {}
+
+    void eval(Exec& e, Value& out) const
+    { mTarget->eval(e, out); }
+private:
+    const Expr* const mTarget;
+};
+
+struct IncDecExpr : public Expr {
+    IncDecExpr(ExprPtr&& target, const float delta, const bool prefix) :
+        Expr(target->fType), mTarget(std::move(target)),
+        mDelta(delta), mPrefix(prefix) {}
+
+    void eval(Exec& e, Value& out) const {
+        Value val;
+        mTarget->eval(e, val);
+        if(!mPrefix) out = val;
+        for(int i = 0; i < fType.fSize; i++) val.f[i] += mDelta;
+        mTarget->store(e, val);
+        if(mPrefix) out = val;
+    }
+private:
+    const ExprPtr mTarget;
+    const float mDelta;
+    const bool mPrefix;
+};
+
+struct TextureExpr : public Expr {
+    TextureExpr(ExprPtr&& coord) :
+        Expr(gVec4), mCoord(std::move(coord)) {}
+
+    void eval(Exec& e, Value& out) const {
+        Value coord;
+        mCoord->eval(e, coord);
+        sample(e, coord.f[0], coord.f[1], out);
+    }
+private:
+    const ExprPtr mCoord;
+};
+
+struct TexelFetchExpr : public Expr {
+    TexelFetchExpr(ExprPtr&& coord) :
+        Expr(gVec4), mCoord(std::move(coord)) {}
+
+    void eval(Exec& e, Value& out) const {
+        Value coord;
+        mCoord->eval(e, coord);
+        const int x = int(coord.f[0]);
+        const int y = int(coord.f[1]);
+        if(x < 0 || y < 0 || x >= e.fWidth || y >= e.fHeight) {
+            out = Value{{0, 0, 0, 0}};
+            return;
+        }
+        fetch(e, x, y, out.f);
+        for(int i = 0; i < 4; i++) out.f[i] *= 1.f/255;
+    }
+private:
+    const ExprPtr mCoord;
+};
+
+struct TextureSizeExpr : public Expr {
+    TextureSizeExpr() : Expr(Type{Kind::tInt, 2}) {}
+
+    void eval(Exec& e, Value& out) const {
+        out.f[0] = e.fWidth;
+        out.f[1] = e.fHeight;
+    }
+};
+
+enum class Builtin {
+    radians, degrees, sin, cos, tan, asin, acos, atan, atan2,
+    pow, exp, log, exp2, log2, sqrt, inversesqrt,
+    abs, sign, floor, ceil, trunc, round, fract,
+    mod, min, max, clamp, mix, step, smoothstep,
+    length, distance, dot, cross, normalize, reflect,
+    lessThan, lessThanEqual, greaterThan, greaterThanEqual,
+    equal, notEqual, any, all, logicalNot
+};
+
+const float gPi = 3.14159265358979f;
+
+inline float sign(const float x) {
+    return x > 0.f ? 1.f : (x < 0.f ? -1.f : 0.f);
+}
+
+struct BuiltinExpr : public Expr {
+    BuiltinExpr(const Type& type, const Builtin func,
+                std::vector<ExprPtr>&& args) :
+        Expr(type), mFunc(func), mArgs(std::move(args)) {}
+
+    void eval(Exec& e, Value& out) const {
+        Value a[3];
+        int s[3] = {1, 1, 1};
+        for(size_t i = 0; i < mArgs.size(); i++) {
+            mArgs[i]->eval(e, a[i]);
+            s[i] = mArgs[i]->fType.fSize;
+        }
+        const int n = fType.fSize;
+        const int n0 = s[0];
+        const auto x = [&a, &s](const int arg, const int i) {
+            return comp(a[arg], s[arg], i);
+        };
+        switch(mFunc) {
+        case Builtin::length:
+            out.f[0] = std::sqrt(dot(a[0], a[0], n0));
+            return;
+        case Builtin::distance: {
+            Value d;
+            for(int i = 0; i < n0; i++) d.f[i] = a[0].f[i] - a[1].f[i];
+            out.f[0] = std::sqrt(dot(d, d, n0));
+        } return;
+        case Builtin::dot:
+            out.f[0] = dot(a[0], a[1], n0);
+            return;
+        case Builtin::cross:
+            out.f[0] = a[0].f[1]*a[1].f[2] - a[1].f[1]*a[0].f[2];
+            out.f[1] = a[0].f[2]*a[1].f[0] - a[1].f[2]*a[0].f[0];
+            out.f[2] = a[0].f[0]*a[1].f[1] - a[1].f[0]*a[0].f[1];
+            return;
+        case Builtin::normalize: {
+            const float len = std::sqrt(dot(a[0], a[0], n0));
+            for(int i = 0; i < n; i++) out.f[i] = a[0].f[i]/len;
+        } return;
+        case Builtin::reflect: {
+            const float d = 2*dot(a[1], a[0], n0);
+            for(int i = 0; i < n; i++) out.f[i] = a[0].f[i] - d*a[1].f[i];
+        } return;
+        case Builtin::any: {
+            bool result = false;
+            for(int i = 0; i < n0; i++) result = result || a[0].f[i] != 0.f;
+            out.f[0] = result;
+        } return;
+        case Builtin::all: {
+            bool result = true;
+            for(int i = 0; i < n0; i++) result = result && a[0].f[i] != 0.f;
+            out.f[0] = result;
+        } return;
+        default: break;
+        }
+        for(int i = 0; i < n; i++) {
+            const float v = x(0, i);
+            float& r = out.f[i];
+            switch(mFunc) {
+            case Builtin::radians: r = v*(gPi/180); break;
+            case Builtin::degrees: r = v*(180/gPi); break;
+            case Builtin::sin: r = std::sin(v); break;
+            case Builtin::cos: r = std::cos(v); break;
+            case Builtin::tan: r = std::tan(v); break;
+            case Builtin::asin: r = std::asin(v); break;
+            case Builtin::acos: r = std::acos(v); break;
+            case Builtin::atan: r = std::atan(v); break;
+            case Builtin::atan2: r = std::atan2(v, x(1, i)); break;
+            case Builtin::pow: r = std::pow(v, x(1, i)); break;
+            case Builtin::exp: r = std::exp(v); break;
+            case Builtin::log: r = std::log(v); break;
+            case Builtin::exp2: r = std::exp2(v); break;
+            case Builtin::log2: r = std::log2(v); break;
+            case Builtin::sqrt: r = std::sqrt(v); break;
+            case Builtin::inversesqrt: r = 1.f/std::sqrt(v); break;
+            case Builtin::abs: r = std::abs(v); break;
+            case Builtin::sign: r = sign(v); break;
+            case Builtin::floor: r = std::floor(v); break;
+            case Builtin::ceil: r = std::ceil(v); break;
+            case Builtin::trunc: r = std::trunc(v); break;
+            case Builtin::round: r = std::round(v); break;
+            case Builtin::fract: r = v - std::floor(v); break;
+            case Builtin::mod: {
+                const float y = x(1, i);
+                r = v - y*std::floor(v/y);
+            } break;
+            case Builtin::min: r = std::min(v, x(1, i)); break;
+            case Builtin::max: r = std::max(v, x(1, i)); break;
+            case Builtin::clamp:
+                r = std::min(std::max(v, x(1, i)), x(2, i));
+                break;
+            case Builtin::mix: {
+                const float t = x(2, i);
+                r = v*(1 - t) + x(1, i)*t;
+            } break;
+            case Builtin::step: r = x(1, i) < v ? 0.f : 1.f; break;
+            case Builtin::smoothstep: {
+                const float e0 = v;
+                const float e1 = x(1, i);
+                const float t = qBound(0.f, (x(2, i) - e0)/(e1 - e0), 1.f);
+                r = t*t*(3 - 2*t);
+            } break;
+            case Builtin::lessThan: r = v < x(1, i); break;
+            case Builtin::lessThanEqual: r = v <= x(1, i); break;
+            case Builtin::greaterThan: r = v > x(1, i); break;
+            case Builtin::greaterThanEqual: r = v >= x(1, i); break;
+            case Builtin::equal: r = v == x(1, i); break;
+            case Builtin::notEqual: r = v != x(1, i); break;
+            case Builtin::logicalNot: r = v == 0.f; break;
+            default: r = 0;
+            }
+        }
+    }
+private:
+    static float dot(const Value& a, const Value& b, const int n) {
+        float result = 0;
+        for(int i = 0; i < n; i++) result += a.f[i]*b.f[i];
+        return result;
+    }
+
+    const Builtin mFunc;
+    const std::vector<ExprPtr> mArgs;
+};
+
+// Statements
+
+struct Stmt {
+    virtual ~Stmt() = default;
+    virtual Flow exec(Exec& e) const = 0;
+};
+
+using StmtPtr = std::unique_ptr<Stmt>;
+
+struct ExprStmt : public Stmt {
+    ExprStmt(ExprPtr&& expr) : mExpr(std::move(expr)) {}
+
+    Flow exec(Exec& e) const {
+        Value val;
+        mExpr->eval(e, val);
+        return Flow::next;
+    }
+private:
+    const ExprPtr mExpr;
+};
+
+struct DeclStmt : public Stmt {
+    DeclStmt(const int slot, ExprPtr&& init) :
+        mSlot(slot), mInit(std::move(init)) {}
+
+    Flow exec(Exec& e) const {
+        if(mInit) mInit->eval(e, e.fMem[mSlot]);
+        else e.fMem[mSlot] = Value{{0, 0, 0, 0}};
+        return Flow::next;
+    }
+private:
+    const int mSlot;
+    const ExprPtr mInit;
+};
+
+struct BlockStmt : public Stmt {
+    Flow exec(Exec& e) const {
+        for(const auto& stmt : fStmts) {
+            const Flow flow = stmt->exec(e);
+            if(flow != Flow::next) return flow;
+        }
+        return Flow::next;
+    }
+
+    std::vector<StmtPtr> fStmts;
+};
+
+inline bool condition(Exec& e, const ExprPtr& cond) {
+    if(!cond) return true;
+    Value val;
+    cond->eval(e, val);
+    return val.f[0] != 0.f;
+}
+
+struct IfStmt : public Stmt {
+    IfStmt(ExprPtr&& cond, StmtPtr&& then, StmtPtr&& otherwise) :
+        mCond(std::move(cond)), mThen(std::move(then)),
+        mElse(std::move(otherwise)) {}
+
+    Flow exec(Exec& e) const {
+        if(condition(e, mCond)) return mThen->exec(e);
+        if(mElse) return mElse->exec(e);
+        return Flow::next;
+    }
+private:
+    const ExprPtr mCond;
+    const StmtPtr mThen;
+    const StmtPtr mElse;
+};
+
+//! @brief for, while and do-while loops
+struct LoopStmt : public Stmt {
+    LoopStmt(StmtPtr&& init, ExprPtr&& cond, ExprPtr&& step,
+             StmtPtr&& body, const bool checkFirst) :
+        mInit(std::move(init)), mCond(std::move(cond)),
+        mStep(std::move(step)), mBody(std::move(body)),
+        mCheckFirst(checkFirst) {}
+
+    Flow exec(Exec& e) const {
+        if(mInit) mInit->exec(e);
+        if(mCheckFirst && !condition(e, mCond)) return Flow::next;
+        while(true) {
+            const Flow flow = mBody->exec(e);
+            if(flow == Flow::breakLoop) break;
+            if(flow == Flow::returnFunc || flow == Flow::discard) return flow;
+            if(mStep) {
+                Value val;
+                mStep->eval(e, val);
+            }
+            if(!condition(e, mCond)) break;
+        }
+        return Flow::next;
+    }
+private:
+    const StmtPtr mInit;
+    const ExprPtr mCond;
+    const ExprPtr mStep;
+    const StmtPtr mBody;
+    const bool mCheckFirst;
+};
+
+struct FlowStmt : public Stmt {
+    FlowStmt(const Flow flow) : mFlow(flow) {}
+
+    Flow exec(Exec& e) const {
+        if(mFlow == Flow::discard) e.fDiscarded = true;
+        return mFlow;
+    }
+private:
+    const Flow mFlow;
+};
+
+struct ReturnStmt : public Stmt {
+    ReturnStmt(const int slot, ExprPtr&& value) :
+        mSlot(slot), mValue(std::move(value)) {}
+
+    Flow exec(Exec& e) const {
+        if(mValue) mValue->eval(e, e.fMem[mSlot]);
+        return Flow::returnFunc;
+    }
+private:
+    const int mSlot;
+    const ExprPtr mValue;
+};
+
+struct Function {
+    std::string fName;
+    Type fReturn;
+    std::vector<Type> fParams;
+    std::vector<int> fParamSlots;
+    int fReturnSlot;
+    std::unique_ptr<BlockStmt> fBody;
+};
+
+#define MAX_FUNCTION_PARAMS 16
+
+//! @brief Calls a user function. GLSL forbids recursion,
+//! so every function owns a fixed memory region.
+struct CallExpr : public Expr {
+    CallExpr(const Function& func, std::vector<ExprPtr>&& args) :
+        Expr(func.fReturn), mFunc(func), mArgs(std::move(args)) {}
+
+    void eval(Exec& e, Value& out) const {
+        Value args[MAX_FUNCTION_PARAMS];
+        const size_t nArgs = mArgs.size();
+        for(size_t i = 0; i < nArgs; i++) mArgs[i]->eval(e, args[i]);
+        for(size_t i = 0; i < nArgs; i++)
+            e.fMem[mFunc.fParamSlots[i]] = args[i];
+        mFunc.fBody->exec(e);
+        out = e.fMem[mFunc.fReturnSlot];
+    }
+private:
+    const Function& mFunc;
+    const std::vector<ExprPtr> mArgs;
+};
+
+} // namespace
+
+struct ShaderInterpreterProgram {
+    std::vector<std::unique_ptr<Function>> fFunctions;
+    const Function* fMain = nullptr;
+    //! @brief Global constants, evaluated once per tile
+    BlockStmt fConstInits;
+    //! @brief Other global variables, initialized for every fragment
+    BlockStmt fGlobalInits;
+    int fMemorySize = 0;
+    int fFragCoordSlot = -1;
+    int fTexCoordSlot = -1;
+    int fOutputSlot = -1;
+    bool fPixelCenterInteger = false;
+    std::string fSamplerName;
+    std::vector<std::string> fUniformNames;
+};
+
+namespace {
+
+enum class TokenType {
+    identifier, intLiteral, floatLiteral, symbol, end
+};
+
+struct Token {
+    TokenType fType;
+    std::string fText;
+    double fValue;
+    int fLine;
+};
+
+#define ShaderThrow(line, msg) \
+    RuntimeThrow("Line " + std::to_string(line) + ": " + msg)
+
+std::vector<Token> tokenize(const std::string& src) {
+    static const char* const sSymbols[] = {
+        "<<=", ">>=", "++", "--", "+=", "-=", "*=", "/=", "%=",
+        "==", "!=", "<=", ">=", "&&", "||", "^^", "<<", ">>",
+        "&=", "|=", "^="
+    };
+    std::vector<Token> tokens;
+    int line = 1;
+    size_t i = 0;
+    const size_t len = src.size();
+    while(i < len) {
+        const char c = src[i];
+        if(c == '\n') {
+            line++;
+            i++;
+        } else if(isspace(static_cast<uchar>(c))) {
+            i++;
+        } else if(c == '/' && i + 1 < len && src[i + 1] == '/') {
+            while(i < len && src[i] != '\n') i++;
+        } else if(c == '/' && i + 1 < len && src[i + 1] == '*') {
+            i += 2;
+            while(i < len && !(src[i] == '*' && i + 1 < len && src[i + 1] == '/')) {
+                if(src[i] == '\n') line++;
+                i++;
+            }
+            i += 2;
+        } else if(c == '#') {
+            const size_t start = i;
+            while(i < len && src[i] != '\n') i++;
+            const std::string directive = src.substr(start, i - start);
+            if(directive.find("version") == std::string::npos &&
+               directive.find("extension") == std::string::npos) {
+                ShaderThrow(line, "Unsupported preprocessor directive '" +
+                            directive + "'");
+            }
+        } else if(isalpha(static_cast<uchar>(c)) || c == '_') {
+            const size_t start = i;
+            while(i < len && (isalnum(static_cast<uchar>(src[i])) ||
+                              src[i] == '_')) i++;
+            tokens.push_back({TokenType::identifier,
+                              src.substr(start, i - start), 0, line});
+        } else if(isdigit(static_cast<uchar>(c)) ||
+                  (c == '.' && i + 1 < len &&
+                   isdigit(static_cast<uchar>(src[i + 1])))) {
+            const char* const begin = src.c_str() + i;
+            char* end = nullptr;
+            bool isFloat = false;
+            double value;
+            if(c == '0' && i + 1 < len && (src[i + 1] == 'x' || src[i + 1] == 'X')) {
+                value = static_cast<double>(strtoll(begin, &end, 16));
+            } else {
+                value = strtod(begin, &end);
+                for(const char* it = begin; it < end; it++) {
+                    if(*it == '.' || *it == 'e' || *it == 'E') isFloat = true;
+                }
+            }
+            i += static_cast<size_t>(end - begin);
+            if(i < len && (src[i] == 'f' || src[i] == 'F')) {
+                isFloat = true;
+                i++;
+            } else if(i + 1 < len && (src[i] == 'l' || src[i] == 'L') &&
+                      (src[i + 1] == 'f' || src[i + 1] == 'F')) {
+                isFloat = true;
+                i += 2;
+            } else if(i < len && (src[i] == 'u' || src[i] == 'U')) i++;
+            tokens.push_back({isFloat ? TokenType::floatLiteral :
+                                        TokenType::intLiteral,
+                              "", value, line});
+        } else {
+            std::string symbol(1, c);
+            for(const auto sym : sSymbols) {
+                if(src.compare(i, strlen(sym), sym) == 0) {
+                    symbol = sym;
+                    break;
+                }
+            }
+            i += symbol.size();
+            tokens.push_back({TokenType::symbol, symbol, 0, line});
+        }
+    }
+    tokens.push_back({TokenType::end, "", 0, line});
+    return tokens;
+}
+
+bool typeFromName(const std::string& name, Type& type) {
+    static const std::map<std::string, Type> sTypes = {
+        {"void", gVoid}, {"bool", gBool}, {"int", gInt}, {"uint", gInt},
+        {"float", gFloat}, {"double", gFloat},
+        {"vec2", gVec2}, {"vec3", {Kind::tFloat, 3}}, {"vec4", gVec4},
+        {"dvec2", gVec2}, {"dvec3", {Kind::tFloat, 3}}, {"dvec4", gVec4},
+        {"ivec2", {Kind::tInt, 2}}, {"ivec3", {Kind::tInt, 3}},
+        {"ivec4", {Kind::tInt, 4}},
+        {"uvec2", {Kind::tInt, 2}}, {"uvec3", {Kind::tInt, 3}},
+        {"uvec4", {Kind::tInt, 4}},
+        {"bvec2", {Kind::tBool, 2}}, {"bvec3", {Kind::tBool, 3}},
+        {"bvec4", {Kind::tBool, 4}},
+        {"sampler2D", gSampler}
+    };
+    const auto it = sTypes.find(name);
+    if(it == sTypes.end()) return false;
+    type = it->second;
+    return true;
+}
+
+bool precisionQualifier(const std::string& name) {
+    return name == "highp" || name == "mediump" || name == "lowp";
+}
+
+enum class SymbolKind { variable, constant, uniform, sampler };
+
+struct Symbol {
+    SymbolKind fKind;
+    Type fType;
+    int fSlot;
+};
+
+struct BuiltinInfo {
+    Builtin fFunc;
+    int fArgs;
+};
+
+class Parser {
+public:
+    Parser(const std::string& source, ShaderInterpreterProgram& program) :
+        mTokens(tokenize(source)), mProgram(program) {
+        mScopes.emplace_back();
+        mProgram.fFragCoordSlot = newSlot();
+        mScopes.back()["gl_FragCoord"] = {SymbolKind::constant, gVec4,
+                                          mProgram.fFragCoordSlot};
+    }
+
+    void parse() {
+        while(peek().fType != TokenType::end) parseGlobal();
+        if(!mProgram.fMain) RuntimeThrow("Missing main function");
+        if(mProgram.fOutputSlot < 0) RuntimeThrow("Missing output variable");
+        if(mProgram.fSamplerName.empty()) RuntimeThrow("Missing sampler2D uniform");
+    }
+private:
+    const Token& peek(const size_t offset = 0) const {
+        return mTokens[std::min(mPos + offset, mTokens.size() - 1)];
+    }
+
+    const Token& next() {
+        const Token& token = peek();
+        if(mPos < mTokens.size() - 1) mPos++;
+        return token;
+    }
+
+    bool isSymbol(const char* const symbol, const size_t offset = 0) const {
+        const Token& token = peek(offset);
+        return token.fType == TokenType::symbol && token.fText == symbol;
+    }
+
+    bool isIdentifier(const char* const name, const size_t offset = 0) const {
+        const Token& token = peek(offset);
+        return token.fType == TokenType::identifier && token.fText == name;
+    }
+
+    bool accept(const char* const symbol) {
+        if(!isSymbol(symbol) && !isIdentifier(symbol)) return false;
+        next();
+        return true;
+    }
+
+    void expect(const char* const symbol) {
+        if(!accept(symbol)) {
+            ShaderThrow(peek().fLine, "Expected '" + std::string(symbol) +
+                        "' before '" + tokenText(peek()) + "'");
+        }
+    }
+
+    static std::string tokenText(const Token& token) {
+        switch(token.fType) {
+        case TokenType::end: return "end of file";
+        case TokenType::intLiteral:
+        case TokenType::floatLiteral: return std::to_string(token.fValue);
+        default: return token.fText;
+        }
+    }
+
+    std::string expectIdentifier() {
+        const Token& token = next();
+        if(token.fType != TokenType::identifier)
+            ShaderThrow(token.fLine, "Expected identifier");
+        return token.fText;
+    }
+
+    [[noreturn]] void unexpected() const {
+        ShaderThrow(peek().fLine, "Unexpected '" + tokenText(peek()) + "'");
+    }
+
+    int line() const { return peek().fLine; }
+
+    int newSlot() { return mProgram.fMemorySize++; }
+
+    bool isTypeName(const size_t offset = 0) const {
+        const Token& token = peek(offset);
+        if(token.fType != TokenType::identifier) return false;
+        Type type;
+        return typeFromName(token.fText, type);
+    }
+
+    Type parseType() {
+        while(precisionQualifier(peek().fText)) next();
+        const Token& token = next();
+        Type type;
+        if(token.fType != TokenType::identifier ||
+           !typeFromName(token.fText, type)) {
+            ShaderThrow(token.fLine, "Unsupported type '" +
+                        tokenText(token) + "'");
+        }
+        if(isSymbol("[")) ShaderThrow(line(), "Arrays are not supported");
+        return type;
+    }
+
+    const Symbol* findSymbol(const std::string& name) const {
+        for(auto it = mScopes.rbegin(); it != mScopes.rend(); it++) {
+            const auto sym = it->find(name);
+            if(sym != it->end()) return &sym->second;
+        }
+        return nullptr;
+    }
+
+    void declare(const std::string& name, const Symbol& symbol) {
+        auto& scope = mScopes.back();
+        if(scope.find(name) != scope.end())
+            ShaderThrow(line(), "Redefinition of '" + name + "'");
+        scope[name] = symbol;
+    }
+
+    // Type conversions
+
+    ExprPtr convert(ExprPtr&& expr, const Type& type) {
+        if(expr->fType == type) return std::move(expr);
+        const bool sizeOk = expr->fType.fSize == type.fSize ||
+                            expr->fType.fSize == 1;
+        if(!sizeOk || type.fKind == Kind::tVoid ||
+           type.fKind == Kind::tSampler ||
+           expr->fType.fKind == Kind::tVoid ||
+           expr->fType.fKind == Kind::tSampler) {
+            ShaderThrow(line(), "Incompatible types");
+        }
+        return std::make_unique<ConvertExpr>(type, std::move(expr));
+    }
+
+    static Kind arithmeticKind(const Type& a, const Type& b) {
+        if(a.fKind == Kind::tFloat || b.fKind == Kind::tFloat)
+            return Kind::tFloat;
+        return Kind::tInt;
+    }
+
+    int broadcastSize(const Type& a, const Type& b) const {
+        if(a.fSize == 1) return b.fSize;
+        if(b.fSize == 1 || a.fSize == b.fSize) return a.fSize;
+        ShaderThrow(line(), "Mismatched vector sizes");
+    }
+
+    ExprPtr makeBinary(const std::string& op, ExprPtr&& a, ExprPtr&& b) {
+        const Type& ta = a->fType;
+        const Type& tb = b->fType;
+        if(op == "&&" || op == "||" || op == "^^") {
+            if(!ta.boolScalar() || !tb.boolScalar())
+                ShaderThrow(line(), "Logical operands have to be bool");
+            const LogicOp lop = op == "&&" ? LogicOp::andOp :
+                                (op == "||" ? LogicOp::orOp : LogicOp::xorOp);
+            return std::make_unique<LogicalExpr>(lop, std::move(a), std::move(b));
+        }
+        if(op == "==" || op == "!=") {
+            if(ta.fSize != tb.fSize)
+                ShaderThrow(line(), "Mismatched comparison operands");
+            if(ta.fKind != tb.fKind) {
+                const Type common{arithmeticKind(ta, tb), ta.fSize};
+                a = convert(std::move(a), common);
+                b = convert(std::move(b), common);
+            }
+            return std::make_unique<EqualityExpr>(std::move(a), std::move(b),
+                                                  op == "==");
+        }
+        if(!ta.numeric() || !tb.numeric())
+            ShaderThrow(line(), "Operator '" + op + "' expects numbers");
+        if(op == "<" || op == ">" || op == "<=" || op == ">=") {
+            if(ta.fSize != 1 || tb.fSize != 1)
+                ShaderThrow(line(), "Relational operators expect scalars");
+            if(op == "<") return makeBinaryT<BinOp::less>(gBool, a, b);
+            if(op == ">") return makeBinaryT<BinOp::greater>(gBool, a, b);
+            if(op == "<=") return makeBinaryT<BinOp::lessEq>(gBool, a, b);
+            return makeBinaryT<BinOp::greaterEq>(gBool, a, b);
+        }
+        const Type type{arithmeticKind(ta, tb), broadcastSize(ta, tb)};
+        if(op == "+") return makeBinaryT<BinOp::add>(type, a, b);
+        if(op == "-") return makeBinaryT<BinOp::sub>(type, a, b);
+        if(op == "*") return makeBinaryT<BinOp::mul>(type, a, b);
+        if(op == "/") return makeBinaryT<BinOp::div>(type, a, b);
+        if(op == "%") {
+            if(type.fKind != Kind::tInt)
+                ShaderThrow(line(), "Operator '%' expects integers");
+            return makeBinaryT<BinOp::mod>(type, a, b);
+        }
+        ShaderThrow(line(), "Unsupported operator '" + op + "'");
+    }
+
+    template <BinOp OP>
+    static ExprPtr makeBinaryT(const Type& type, ExprPtr& a, ExprPtr& b) {
+        return std::make_unique<BinaryExpr<OP>>(type, std::move(a),
+                                                std::move(b));
+    }
+
+    // Global declarations
+
+    void parseGlobal() {
+        if(accept(";")) return;
+        if(accept("precision")) {
+            while(!accept(";")) {
+                if(peek().fType == TokenType::end) unexpected();
+                next();
+            }
+            return;
+        }
+        bool pixelCenterInteger = false;
+        if(accept("layout")) {
+            expect("(");
+            while(!accept(")")) {
+                if(peek().fType == TokenType::end) unexpected();
+                if(isIdentifier("pixel_center_integer"))
+                    pixelCenterInteger = true;
+                next();
+            }
+        }
+        bool isConst = false;
+        bool isUniform = false;
+        bool isIn = false;
+        bool isOut = false;
+        while(true) {
+            if(accept("const")) isConst = true;
+            else if(accept("uniform")) isUniform = true;
+            else if(accept("in")) isIn = true;
+            else if(accept("out")) isOut = true;
+            else if(accept("smooth") || accept("flat") ||
+                    accept("noperspective") || accept("invariant")) {}
+            else break;
+        }
+        const Type type = parseType();
+        const std::string name = expectIdentifier();
+        if(isSymbol("(")) {
+            if(isConst || isUniform || isIn || isOut)
+                ShaderThrow(line(), "Invalid function qualifier");
+            return parseFunction(type, name);
+        }
+        if(isIn) {
+            if(name == "gl_FragCoord") {
+                mProgram.fPixelCenterInteger = pixelCenterInteger;
+            } else if(type == gVec2 && mProgram.fTexCoordSlot < 0) {
+                mProgram.fTexCoordSlot = newSlot();
+                declare(name, {SymbolKind::constant, type,
+                               mProgram.fTexCoordSlot});
+            } else ShaderThrow(line(), "Unsupported input '" + name + "'");
+            return expect(";");
+        }
+        if(isUniform) {
+            if(type.fKind == Kind::tSampler) {
+                if(!mProgram.fSamplerName.empty())
+                    ShaderThrow(line(), "Only one sampler is supported");
+                mProgram.fSamplerName = name;
+                declare(name, {SymbolKind::sampler, type, -1});
+            } else {
+                const int slot = static_cast<int>(mProgram.fUniformNames.size());
+                mProgram.fUniformNames.push_back(name);
+                declare(name, {SymbolKind::uniform, type, slot});
+            }
+            return expect(";");
+        }
+        if(isOut) {
+            if(type != gVec4 || mProgram.fOutputSlot >= 0)
+                ShaderThrow(line(), "Expected a single vec4 output");
+            mProgram.fOutputSlot = newSlot();
+            declare(name, {SymbolKind::variable, type,
+                           mProgram.fOutputSlot});
+            mProgram.fGlobalInits.fStmts.push_back(
+                        std::make_unique<DeclStmt>(mProgram.fOutputSlot,
+                                                   nullptr));
+            return expect(";");
+        }
+        auto& inits = isConst ? mProgram.fConstInits : mProgram.fGlobalInits;
+        parseDeclarators(type, name, isConst, inits.fStmts);
+    }
+
+    void parseDeclarators(const Type& type, std::string name,
+                          const bool isConst, std::vector<StmtPtr>& stmts) {
+        if(type.fKind == Kind::tVoid || type.fKind == Kind::tSampler)
+            ShaderThrow(line(), "Invalid variable type");
+        while(true) {
+            if(isSymbol("[")) ShaderThrow(line(), "Arrays are not supported");
+            ExprPtr init;
+            if(accept("=")) init = convert(parseAssignment(), type);
+            else if(isConst) ShaderThrow(line(), "Uninitialized constant");
+            const int slot = newSlot();
+            stmts.push_back(std::make_unique<DeclStmt>(slot, std::move(init)));
+            declare(name, {isConst ? SymbolKind::constant :
+                                     SymbolKind::variable, type, slot});
+            if(!accept(",")) break;
+            name = expectIdentifier();
+        }
+        expect(";");
+    }
+
+    void parseFunction(const Type& returnType, const std::string& name) {
+        if(mFunctions.find(name) != mFunctions.end() || builtin(name))
+            ShaderThrow(line(), "Function overloading is not supported");
+        auto func = std::make_unique<Function>();
+        func->fName = name;
+        func->fReturn = returnType;
+        func->fReturnSlot = newSlot();
+        mScopes.emplace_back();
+        expect("(");
+        if(isIdentifier("void") && isSymbol(")", 1)) next();
+        while(!accept(")")) {
+            if(!func->fParams.empty()) expect(",");
+            accept("const");
+            if(accept("out") || accept("inout"))
+                ShaderThrow(line(), "Output parameters are not supported");
+            accept("in");
+            const Type type = parseType();
+            const int slot = newSlot();
+            func->fParams.push_back(type);
+            func->fParamSlots.push_back(slot);
+            if(peek().fType == TokenType::identifier) {
+                declare(expectIdentifier(), {SymbolKind::variable, type, slot});
+            }
+        }
+        if(func->fParams.size() > MAX_FUNCTION_PARAMS)
+            ShaderThrow(line(), "Too many function parameters");
+        if(isSymbol(";"))
+            ShaderThrow(line(), "Function prototypes are not supported");
+        mCurrentFunction = func.get();
+        func->fBody = parseBlock();
+        mCurrentFunction = nullptr;
+        mScopes.pop_back();
+        if(name == "main") {
+            if(returnType != gVoid || !func->fParams.empty())
+                ShaderThrow(line(), "Invalid main function");
+            mProgram.fMain = func.get();
+        }
+        mFunctions[name] = func.get();
+        mProgram.fFunctions.push_back(std::move(func));
+    }
+
+    // Statements
+
+    std::unique_ptr<BlockStmt> parseBlock() {
+        expect("{");
+        mScopes.emplace_back();
+        auto block = std::make_unique<BlockStmt>();
+        while(!accept("}")) {
+            if(peek().fType == TokenType::end) unexpected();
+            block->fStmts.push_back(parseStatement());
+        }
+        mScopes.pop_back();
+        return block;
+    }
+
+    bool declarationAhead() const {
+        if(isIdentifier("const")) return true;
+        if(precisionQualifier(peek().fText)) return true;
+        return isTypeName() && peek(1).fType == TokenType::identifier;
+    }
+
+    StmtPtr parseStatement() {
+        if(isSymbol("{")) return parseBlock();
+        if(accept(";")) return std::make_unique<BlockStmt>();
+        if(accept("if")) {
+            expect("(");
+            auto cond = parseCondition();
+            expect(")");
+            auto then = parseScopedStatement();
+            StmtPtr otherwise;
+            if(accept("else")) otherwise = parseScopedStatement();
+            return std::make_unique<IfStmt>(std::move(cond), std::move(then),
+                                            std::move(otherwise));
+        }
+        if(accept("for")) {
+            mScopes.emplace_back();
+            expect("(");
+            StmtPtr init;
+            if(!accept(";")) init = parseSimpleStatement();
+            ExprPtr cond;
+            if(!isSymbol(";")) cond = parseCondition();
+            expect(";");
+            ExprPtr step;
+            if(!isSymbol(")")) step = parseExpression();
+            expect(")");
+            auto body = parseLoopBody();
+            mScopes.pop_back();
+            return std::make_unique<LoopStmt>(std::move(init), std::move(cond),
+                                              std::move(step), std::move(body),
+                                              true);
+        }
+        if(accept("while")) {
+            expect("(");
+            auto cond = parseCondition();
+            expect(")");
+            auto body = parseLoopBody();
+            return std::make_unique<LoopStmt>(nullptr, std::move(cond),
+                                              nullptr, std::move(body), true);
+        }
+        if(accept("do")) {
+            auto body = parseLoopBody();
+            expect("while");
+            expect("(");
+            auto cond = parseCondition();
+            expect(")");
+            expect(";");
+            return std::make_unique<LoopStmt>(nullptr, std::move(cond),
+                                              nullptr, std::move(body), false);
+        }
+        if(accept("break")) {
+            if(mLoopDepth == 0) ShaderThrow(line(), "'break' outside a loop");
+            expect(";");
+            return std::make_unique<FlowStmt>(Flow::breakLoop);
+        }
+        if(accept("continue")) {
+            if(mLoopDepth == 0) ShaderThrow(line(), "'continue' outside a loop");
+            expect(";");
+            return std::make_unique<FlowStmt>(Flow::continueLoop);
+        }
+        if(accept("discard")) {
+            expect(";");
+            return std::make_unique<FlowStmt>(Flow::discard);
+        }
+        if(accept("return")) {
+            const auto func = mCurrentFunction;
+            ExprPtr value;
+            if(!isSymbol(";")) value = convert(parseExpression(), func->fReturn);
+            else if(func->fReturn != gVoid)
+                ShaderThrow(line(), "Missing return value");
+            expect(";");
+            return std::make_unique<ReturnStmt>(func->fReturnSlot,
+                                                std::move(value));
+        }
+        if(isIdentifier("switch")) ShaderThrow(line(), "'switch' is not supported");
+        return parseSimpleStatement();
+    }
+
+    StmtPtr parseScopedStatement() {
+        mScopes.emplace_back();
+        auto stmt = parseStatement();
+        mScopes.pop_back();
+        return stmt;
+    }
+
+    StmtPtr parseLoopBody() {
+        mLoopDepth++;
+        auto body = parseScopedStatement();
+        mLoopDepth--;
+        return body;
+    }
+
+    //! @brief Declaration or expression statement
+    StmtPtr parseSimpleStatement() {
+        if(declarationAhead()) {
+            const bool isConst = accept("const");
+            const Type type = parseType();
+            const std::string name = expectIdentifier();
+            auto block = std::make_unique<BlockStmt>();
+            parseDeclarators(type, name, isConst, block->fStmts);
+            if(block->fStmts.size() == 1) return std::move(block->fStmts.front());
+            return block;
+        }
+        auto expr = parseExpression();
+        expect(";");
+        return std::make_unique<ExprStmt>(std::move(expr));
+    }
+
+    ExprPtr parseCondition() {
+        auto cond = parseExpression();
+        if(!cond->fType.boolScalar())
+            ShaderThrow(line(), "Condition has to be a bool");
+        return cond;
+    }
+
+    // Expressions
+
+    ExprPtr parseExpression() {
+        auto expr = parseAssignment();
+        if(isSymbol(",")) ShaderThrow(line(), "Comma operator is not supported");
+        return expr;
+    }
+
+    ExprPtr parseAssignment() {
+        auto target = parseTernary();
+        static const char* const sOps[] = {
+            "=", "+=", "-=", "*=", "/=", "%="
+        };
+        for(const auto op : sOps) {
+            if(!isSymbol(op)) continue;
+            next();
+            if(!target->assignable())
+                ShaderThrow(line(), "Assignment to a read-only value");
+            auto value = parseAssignment();
+            if(op[0] != '=') {
+                auto read = std::make_unique<TargetReadExpr>(target.get());
+                value = makeBinary(std::string(1, op[0]),
+                                   std::move(read), std::move(value));
+            }
+            value = convert(std::move(value), target->fType);
+            return std::make_unique<AssignExpr>(std::move(target),
+                                                std::move(value));
+        }
+        return target;
+    }
+
+    ExprPtr parseTernary() {
+        auto cond = parseBinary(0);
+        if(!accept("?")) return cond;
+        if(!cond->fType.boolScalar())
+            ShaderThrow(line(), "Condition has to be a bool");
+        auto a = parseAssignment();
+        expect(":");
+        auto b = parseAssignment();
+        Type type = a->fType;
+        if(a->fType != b->fType) {
+            if(!a->fType.numeric() || !b->fType.numeric() ||
+               a->fType.fSize != b->fType.fSize)
+                ShaderThrow(line(), "Mismatched ternary operands");
+            type = {Kind::tFloat, a->fType.fSize};
+            a = convert(std::move(a), type);
+            b = convert(std::move(b), type);
+        }
+        return std::make_unique<TernaryExpr>(type, std::move(cond),
+                                             std::move(a), std::move(b));
+    }
+
+    ExprPtr parseBinary(const int level) {
+        static const std::vector<std::vector<std::string>> sLevels = {
+            {"||"}, {"^^"}, {"&&"}, {"==", "!="},
+            {"<", ">", "<=", ">="}, {"+", "-"}, {"*", "/", "%"}
+        };
+        if(level == static_cast<int>(sLevels.size())) return parseUnary();
+        auto lhs = parseBinary(level + 1);
+        while(true) {
+            const auto& ops = sLevels[static_cast<size_t>(level)];
+            const Token& token = peek();
+            if(token.fType != TokenType::symbol) return lhs;
+            const auto op = std::find(ops.begin(), ops.end(), token.fText);
+            if(op == ops.end()) return lhs;
+            next();
+            auto rhs = parseBinary(level + 1);
+            lhs = makeBinary(*op, std::move(lhs), std::move(rhs));
+        }
+    }
+
+    ExprPtr parseUnary() {
+        if(accept("+")) return parseUnary();
+        if(accept("-")) {
+            auto src = parseUnary();
+            if(!src->fType.numeric()) ShaderThrow(line(), "Invalid negation");
+            return std::make_unique<NegateExpr>(std::move(src));
+        }
+        if(accept("!")) {
+            auto src = parseUnary();
+            if(!src->fType.boolScalar()) ShaderThrow(line(), "Invalid negation");
+            return std::make_unique<NotExpr>(std::move(src));
+        }
+        if(isSymbol("++") || isSymbol("--")) {
+            const float delta = next().fText == "++" ? 1 : -1;
+            auto target = parseUnary();
+            return makeIncDec(std::move(target), delta, true);
+        }
+        return parsePostfix();
+    }
+
+    ExprPtr makeIncDec(ExprPtr&& target, const float delta, const bool prefix) {
+        if(!target->assignable() || !target->fType.numeric())
+            ShaderThrow(line(), "Invalid increment target");
+        return std::make_unique<IncDecExpr>(std::move(target), delta, prefix);
+    }
+
+    ExprPtr parsePostfix() {
+        auto expr = parsePrimary();
+        while(true) {
+            if(accept(".")) {
+                expr = parseSwizzle(std::move(expr), expectIdentifier());
+            } else if(accept("[")) {
+                auto index = parseExpression();
+                expect("]");
+                if(expr->fType.fSize < 2 || !expr->fType.numeric() ||
+                   index->fType != gInt) {
+                    ShaderThrow(line(), "Invalid indexing");
+                }
+                expr = std::make_unique<IndexExpr>(std::move(expr),
+                                                   std::move(index));
+            } else if(isSymbol("++") || isSymbol("--")) {
+                const float delta = next().fText == "++" ? 1 : -1;
+                expr = makeIncDec(std::move(expr), delta, false);
+            } else return expr;
+        }
+    }
+
+    ExprPtr parseSwizzle(ExprPtr&& base, const std::string& swizzle) {
+        static const char* const sSets[] = {"xyzw", "rgba", "stpq"};
+        if(base->fType.fKind == Kind::tVoid ||
+           base->fType.fKind == Kind::tSampler ||
+           swizzle.empty() || swizzle.size() > 4) {
+            ShaderThrow(line(), "Invalid swizzle '" + swizzle + "'");
+        }
+        std::vector<int> comps;
+        for(const auto set : sSets) {
+            comps.clear();
+            for(const char c : swizzle) {
+                const char* const pos = strchr(set, c);
+                if(!pos) break;
+                comps.push_back(static_cast<int>(pos - set));
+            }
+            if(comps.size() == swizzle.size()) break;
+        }
+        if(comps.size() != swizzle.size())
+            ShaderThrow(line(), "Invalid swizzle '" + swizzle + "'");
+        for(const int comp : comps) {
+            if(comp >= base->fType.fSize)
+                ShaderThrow(line(), "Swizzle '" + swizzle + "' out of range");
+        }
+        return std::make_unique<SwizzleExpr>(std::move(base), comps);
+    }
+
+    std::vector<ExprPtr> parseArguments() {
+        std::vector<ExprPtr> args;
+        expect("(");
+        if(isIdentifier("void") && isSymbol(")", 1)) next();
+        while(!accept(")")) {
+            if(!args.empty()) expect(",");
+            if(isSymbol(")")) unexpected();
+            args.push_back(parseAssignment());
+        }
+        return args;
+    }
+
+    ExprPtr parsePrimary() {
+        const Token& token = peek();
+        if(token.fType == TokenType::intLiteral) {
+            next();
+            const float val = static_cast<float>(token.fValue);
+            return std::make_unique<ConstExpr>(gInt, Value{{val, 0, 0, 0}});
+        }
+        if(token.fType == TokenType::floatLiteral) {
+            next();
+            const float val = static_cast<float>(token.fValue);
+            return std::make_unique<ConstExpr>(gFloat, Value{{val, 0, 0, 0}});
+        }
+        if(accept("(")) {
+            auto expr = parseExpression();
+            expect(")");
+            return expr;
+        }
+        if(token.fType != TokenType::identifier) unexpected();
+        if(accept("true"))
+            return std::make_unique<ConstExpr>(gBool, Value{{1, 0, 0, 0}});
+        if(accept("false"))
+            return std::make_unique<ConstExpr>(gBool, Value{{0, 0, 0, 0}});
+        if(isTypeName()) {
+            const Type type = parseType();
+            return makeConstructor(type, parseArguments());
+        }
+        const std::string name = expectIdentifier();
+        if(isSymbol("(")) return makeCall(name, parseArguments());
+        const auto symbol = findSymbol(name);
+        if(!symbol) ShaderThrow(line(), "Undeclared identifier '" + name + "'");
+        switch(symbol->fKind) {
+        case SymbolKind::uniform:
+            return std::make_unique<UniformExpr>(symbol->fType, symbol->fSlot);
+        case SymbolKind::sampler:
+            return std::make_unique<ConstExpr>(gSampler, Value{{0, 0, 0, 0}});
+        default:
+            return std::make_unique<VarExpr>(
+                        symbol->fType, symbol->fSlot,
+                        symbol->fKind == SymbolKind::constant);
+        }
+    }
+
+    ExprPtr makeConstructor(const Type& type, std::vector<ExprPtr>&& args) {
+        if(type.fKind == Kind::tVoid || type.fKind == Kind::tSampler ||
+           args.empty()) {
+            ShaderThrow(line(), "Invalid constructor");
+        }
+        int nComps = 0;
+        for(const auto& arg : args) {
+            if(arg->fType.fKind == Kind::tVoid ||
+               arg->fType.fKind == Kind::tSampler) {
+                ShaderThrow(line(), "Invalid constructor argument");
+            }
+            nComps += arg->fType.fSize;
+        }
+        if(args.size() == 1 && args.front()->fType.fSize == 1)
+            return std::make_unique<ConvertExpr>(type, std::move(args.front()));
+        if(nComps < type.fSize)
+            ShaderThrow(line(), "Not enough constructor arguments");
+        return std::make_unique<ConstructExpr>(type, std::move(args));
+    }
+
+    static const BuiltinInfo* builtin(const std::string& name) {
+        static const std::map<std::string, BuiltinInfo> sBuiltins = {
+            {"radians", {Builtin::radians, 1}},
+            {"degrees", {Builtin::degrees, 1}},
+            {"sin", {Builtin::sin, 1}}, {"cos", {Builtin::cos, 1}},
+            {"tan", {Builtin::tan, 1}}, {"asin", {Builtin::asin, 1}},
+            {"acos", {Builtin::acos, 1}}, {"atan", {Builtin::atan, 1}},
+            {"pow", {Builtin::pow, 2}}, {"exp", {Builtin::exp, 1}},
+            {"log", {Builtin::log, 1}}, {"exp2", {Builtin::exp2, 1}},
+            {"log2", {Builtin::log2, 1}}, {"sqrt", {Builtin::sqrt, 1}},
+            {"inversesqrt", {Builtin::inversesqrt, 1}},
+            {"abs", {Builtin::abs, 1}}, {"sign", {Builtin::sign, 1}},
+            {"floor", {Builtin::floor, 1}}, {"ceil", {Builtin::ceil, 1}},
+            {"trunc", {Builtin::trunc, 1}}, {"round", {Builtin::round, 1}},
+            {"roundEven", {Builtin::round, 1}},
+            {"fract", {Builtin::fract, 1}}, {"mod", {Builtin::mod, 2}},
+            {"min", {Builtin::min, 2}}, {"max", {Builtin::max, 2}},
+            {"clamp", {Builtin::clamp, 3}}, {"mix", {Builtin::mix, 3}},
+            {"step", {Builtin::step, 2}},
+            {"smoothstep", {Builtin::smoothstep, 3}},
+            {"length", {Builtin::length, 1}},
+            {"distance", {Builtin::distance, 2}},
+            {"dot", {Builtin::dot, 2}}, {"cross", {Builtin::cross, 2}},
+            {"normalize", {Builtin::normalize, 1}},
+            {"reflect", {Builtin::reflect, 2}},
+            {"lessThan", {Builtin::lessThan, 2}},
+            {"lessThanEqual", {Builtin::lessThanEqual, 2}},
+            {"greaterThan", {Builtin::greaterThan, 2}},
+            {"greaterThanEqual", {Builtin::greaterThanEqual, 2}},
+            {"equal", {Builtin::equal, 2}},
+            {"notEqual", {Builtin::notEqual, 2}},
+            {"any", {Builtin::any, 1}}, {"all", {Builtin::all, 1}},
+            {"not", {Builtin::logicalNot, 1}}
+        };
+        const auto it = sBuiltins.find(name);
+        if(it == sBuiltins.end()) return nullptr;
+        return &it->second;
+    }
+
+    ExprPtr makeCall(const std::string& name, std::vector<ExprPtr>&& args) {
+        if(name == "texture2D" || name == "texture" || name == "texelFetch") {
+            if(args.size() < 2 || args.size() > 3 ||
+               args[0]->fType != gSampler || args[1]->fType.fSize != 2) {
+                ShaderThrow(line(), "Invalid '" + name + "' arguments");
+            }
+            if(name == "texelFetch") {
+                return std::make_unique<TexelFetchExpr>(std::move(args[1]));
+            }
+            auto coord = convert(std::move(args[1]), gVec2);
+            return std::make_unique<TextureExpr>(std::move(coord));
+        }
+        if(name == "textureSize") {
+            if(args.empty() || args[0]->fType != gSampler)
+                ShaderThrow(line(), "Invalid 'textureSize' arguments");
+            return std::make_unique<TextureSizeExpr>();
+        }
+        const auto funcIt = mFunctions.find(name);
+        if(funcIt != mFunctions.end()) {
+            const auto func = funcIt->second;
+            if(args.size() != func->fParams.size())
+                ShaderThrow(line(), "Invalid number of arguments for '" +
+                            name + "'");
+            for(size_t i = 0; i < args.size(); i++)
+                args[i] = convert(std::move(args[i]), func->fParams[i]);
+            return std::make_unique<CallExpr>(*func, std::move(args));
+        }
+        const auto info = builtin(name);
+        if(!info) ShaderThrow(line(), "Unknown function '" + name + "'");
+        Builtin func = info->fFunc;
+        int nArgs = info->fArgs;
+        if(func == Builtin::atan && args.size() == 2) {
+            func = Builtin::atan2;
+            nArgs = 2;
+        }
+        if(static_cast<int>(args.size()) != nArgs)
+            ShaderThrow(line(), "Invalid number of arguments for '" +
+                        name + "'");
+        return makeBuiltin(name, func, std::move(args));
+    }
+
+    ExprPtr makeBuiltin(const std::string& name, const Builtin func,
+                        std::vector<ExprPtr>&& args) {
+        int size = 1;
+        bool allInt = true;
+        for(const auto& arg : args) {
+            const Type& type = arg->fType;
+            const bool boolArg = func == Builtin::any ||
+                                 func == Builtin::all ||
+                                 func == Builtin::logicalNot ||
+                                 func == Builtin::equal ||
+                                 func == Builtin::notEqual;
+            if(!type.numeric() && !(boolArg && type.fKind == Kind::tBool))
+                ShaderThrow(line(), "Invalid '" + name + "' arguments");
+            if(type.fKind != Kind::tInt) allInt = false;
+            if(type.fSize != 1) {
+                if(size != 1 && size != type.fSize)
+                    ShaderThrow(line(), "Mismatched '" + name + "' arguments");
+                size = type.fSize;
+            }
+        }
+        Type type{Kind::tFloat, size};
+        switch(func) {
+        case Builtin::abs: case Builtin::sign:
+        case Builtin::min: case Builtin::max: case Builtin::clamp:
+            if(allInt) type.fKind = Kind::tInt;
+            break;
+        case Builtin::length: case Builtin::distance: case Builtin::dot:
+            type = gFloat;
+            break;
+        case Builtin::cross:
+            if(size != 3) ShaderThrow(line(), "'cross' expects vec3");
+            break;
+        case Builtin::lessThan: case Builtin::lessThanEqual:
+        case Builtin::greaterThan: case Builtin::greaterThanEqual:
+        case Builtin::equal: case Builtin::notEqual:
+        case Builtin::logicalNot:
+            type.fKind = Kind::tBool;
+            break;
+        case Builtin::any: case Builtin::all:
+            type = gBool;
+            break;
+        default: break;
+        }
+        return std::make_unique<BuiltinExpr>(type, func, std::move(args));
+    }
+
+    const std::vector<Token> mTokens;
+    size_t mPos = 0;
+    ShaderInterpreterProgram& mProgram;
+    std::vector<std::map<std::string, Symbol>> mScopes;
+    std::map<std::string, const Function*> mFunctions;
+    Function* mCurrentFunction = nullptr;
+    int mLoopDepth = 0;
+};
+
+} // namespace
+
+ShaderInterpreter::ShaderInterpreter(
+        std::unique_ptr<ShaderInterpreterProgram>&& program) :
+    mProgram(std::move(program)) {}
+
+ShaderInterpreter::~ShaderInterpreter() {}
+
+std::unique_ptr<ShaderInterpreter> ShaderInterpreter::sCompile(
+        const QString& source) {
+    auto program = std::make_unique<ShaderInterpreterProgram>();
+    Parser parser(source.toStdString(), *program);
+    parser.parse();
+    return std::unique_ptr<ShaderInterpreter>(
+                new ShaderInterpreter(std::move(program)));
+}
+
+std::unique_ptr<ShaderInterpreter> ShaderInterpreter::sCompileFile(
+        const QString& path) {
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        RuntimeThrow("Could not open '" + path + "'");
+    const QString source = QString::fromUtf8(file.readAll());
+    file.close();
+    try {
+        return sCompile(source);
+    } catch(...) {
+        RuntimeThrow("Could not interpret '" + path + "'");
+    }
+}
+
+int ShaderInterpreter::uniformSlot(const QString& name) const {
+    const auto& names = mProgram->fUniformNames;
+    const auto it = std::find(names.begin(), names.end(), name.toStdString());
+    if(it == names.end()) return -1;
+    return static_cast<int>(it - names.begin());
+}
+
+int ShaderInterpreter::uniformCount() const {
+    return static_cast<int>(mProgram->fUniformNames.size());
+}
+
+QString ShaderInterpreter::samplerName() const {
+    return QString::fromStdString(mProgram->fSamplerName);
+}
+
+void ShaderInterpreter::render(const Uniforms& uniforms,
+                               const uchar* src, const size_t srcRowBytes,
+                               const int width, const int height,
+                               uchar* dst, const size_t dstRowBytes,
+                               const int x, const int y,
+                               const int tileWidth, const int tileHeight) const {
+    const auto& program = *mProgram;
+    std::vector<Value> memory(static_cast<size_t>(program.fMemorySize),
+                              Value{{0, 0, 0, 0}});
+    Exec e{memory.data(), &uniforms, src, srcRowBytes,
+           width, height, false};
+    program.fConstInits.exec(e);
+
+    const float center = program.fPixelCenterInteger ? 0.f : 0.5f;
+    Value& fragCoord = memory[static_cast<size_t>(program.fFragCoordSlot)];
+    fragCoord.f[2] = 0.5f;
+    fragCoord.f[3] = 1.f;
+    Value* const texCoord = program.fTexCoordSlot < 0 ? nullptr :
+            &memory[static_cast<size_t>(program.fTexCoordSlot)];
+    const Value& output = memory[static_cast<size_t>(program.fOutputSlot)];
+    for(int yi = 0; yi < tileHeight; yi++) {
+        const int py = y + yi;
+        uchar* dstPix = dst + size_t(yi)*dstRowBytes;
+        for(int xi = 0; xi < tileWidth; xi++, dstPix += 4) {
+            const int px = x + xi;
+            fragCoord.f[0] = px + center;
+            fragCoord.f[1] = py + center;
+            if(texCoord) {
+                texCoord->f[0] = (px + 0.5f)/width;
+                texCoord->f[1] = (py + 0.5f)/height;
+            }
+            e.fDiscarded = false;
+            program.fGlobalInits.exec(e);
+            program.fMain->fBody->exec(e);
+            if(e.fDiscarded) {
+                for(int i = 0; i < 4; i++) dstPix[i] = 0;
+                continue;
+            }
+            for(int i = 0; i < 4; i++) {
+                const float val = qBound(0.f, output.f[i], 1.f);
+                dstPix[i] = static_cast<uchar>(val*255 + 0.5f);
+            }
+        }
+    }
+}
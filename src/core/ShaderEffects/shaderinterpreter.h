@@ -0,0 +1,75 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SHADERINTERPRETER_H
+#define SHADERINTERPRETER_H
+
+#include "../core_global.h"
+
+#include <QString>
+#include <QList>
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <functional>
+
+struct ShaderInterpreterProgram;
+
+//! @brief Executes the fragment shader of a ShaderEffect on the CPU.
+//! Supports the GLSL subset used by enve shader effects:
+//! scalar and vector types, uniforms, constants, user functions,
+//! control flow and common built-in functions.
+//! Sampling is bilinear with clamp to edge, like the GPU textures.
+class CORE_EXPORT ShaderInterpreter {
+public:
+    //! @brief Uniform values indexed by slot,
+    //! integer and boolean uniforms are stored as floats
+    using Uniforms = std::vector<std::array<float, 4>>;
+
+    ~ShaderInterpreter();
+
+    //! @brief Parses the shader, throws if it uses unsupported features
+    static std::unique_ptr<ShaderInterpreter> sCompile(const QString& source);
+    static std::unique_ptr<ShaderInterpreter> sCompileFile(const QString& path);
+
+    //! @brief Slot of the named uniform, -1 if it is not declared
+    int uniformSlot(const QString& name) const;
+    int uniformCount() const;
+    //! @brief Name of the sampler uniform bound to the source texture
+    QString samplerName() const;
+
+    Uniforms defaultUniforms() const
+    { return Uniforms(static_cast<size_t>(uniformCount()), {0, 0, 0, 0}); }
+
+    //! @brief Renders the tile into dst, both images are premultiplied
+    //! 8-bit RGBA of size width x height, dst points to pixel {x, y}.
+    void render(const Uniforms& uniforms,
+                const uchar* src, const size_t srcRowBytes,
+                const int width, const int height,
+                uchar* dst, const size_t dstRowBytes,
+                const int x, const int y,
+                const int tileWidth, const int tileHeight) const;
+private:
+    ShaderInterpreter(std::unique_ptr<ShaderInterpreterProgram>&& program);
+
+    const std::unique_ptr<ShaderInterpreterProgram> mProgram;
+};
+
+typedef std::function<void(ShaderInterpreter::Uniforms&)> CpuUniformSpecifier;
+typedef QList<CpuUniformSpecifier> CpuUniformSpecifiers;
+
+#endif // SHADERINTERPRETER_H
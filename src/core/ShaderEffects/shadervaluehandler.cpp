@@ -161,3 +161,43 @@ UniformSpecifier ShaderValueHandler::create(const GLint loc, QJSValue* getter) c
         };
     } else RuntimeThrow("Unsupported type for " + fName);
 }
+
+CpuUniformSpecifier ShaderValueHandler::createCpu(const int slot,
+                                                  QJSValue* getter) const {
+    Q_ASSERT(slot >= 0);
+    int size;
+    bool integer;
+    QString typeName;
+    switch(mType) {
+    case GLValueType::Float: size = 1; integer = false; typeName = "float"; break;
+    case GLValueType::Vec2: size = 2; integer = false; typeName = "vec2"; break;
+    case GLValueType::Vec3: size = 3; integer = false; typeName = "vec3"; break;
+    case GLValueType::Vec4: size = 4; integer = false; typeName = "vec4"; break;
+    case GLValueType::Int: size = 1; integer = true; typeName = "int"; break;
+    case GLValueType::iVec2: size = 2; integer = true; typeName = "ivec2"; break;
+    case GLValueType::iVec3: size = 3; integer = true; typeName = "ivec3"; break;
+    case GLValueType::iVec4: size = 4; integer = true; typeName = "ivec4"; break;
+    default: RuntimeThrow("Unsupported type for " + fName);
+    }
+    return [slot, getter, size, integer, typeName](
+            ShaderInterpreter::Uniforms& uniforms) {
+        const QJSValue jsVal = getter->call();
+        const auto toFloat = [integer](const QJSValue& val) {
+            const qreal num = val.toNumber();
+            return static_cast<float>(integer ? qRound(num) : num);
+        };
+        auto& uniform = uniforms[slot];
+        if(size == 1) {
+            if(!jsVal.isNumber())
+                RuntimeThrow("Invalid value. Expected " + typeName + ".");
+            uniform = {toFloat(jsVal), 0, 0, 0};
+        } else {
+            if(!jsVal.isArray() ||
+               jsVal.property("length").toInt() != size)
+                RuntimeThrow("Invalid value. Expected " + typeName + ".");
+            for(int i = 0; i < 4; i++) {
+                uniform[i] = i < size ? toFloat(jsVal.property(i)) : 0;
+            }
+        }
+    };
+}
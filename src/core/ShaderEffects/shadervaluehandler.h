@@ -20,6 +20,7 @@
 
 #include "glhelpers.h"
 #include "smartPointers/ememory.h"
+#include "shaderinterpreter.h"
 
 typedef std::function<void(QGL33 * const)> UniformSpecifier;
 
@@ -35,6 +36,7 @@ public:
                        const QString& script);
 
     UniformSpecifier create(const GLint loc, QJSValue* getter) const;
+    CpuUniformSpecifier createCpu(const int slot, QJSValue* getter) const;
 
     const QString fName;
     const QString fScript;
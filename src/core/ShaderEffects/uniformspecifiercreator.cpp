@@ -21,11 +21,13 @@
 void qrealAnimatorCreate(
         const bool glValue,
         const GLint loc,
+        const int cpuSlot,
         Property * const property,
         const qreal relFrame,
         const qreal resolution,
         QJSValueList& setterArgs,
-        UniformSpecifiers& uniSpec) {
+        UniformSpecifiers& uniSpec,
+        CpuUniformSpecifiers& cpuUniSpec) {
     const auto anim = static_cast<QrealAnimator*>(property);
     const qreal val = anim->getEffectiveValue(relFrame)*resolution;
     const QString propName = anim->prp_getName();
@@ -33,30 +35,44 @@ void qrealAnimatorCreate(
     setterArgs << val;
 
     if(!glValue) return;
-    Q_ASSERT(loc >= 0);
-    uniSpec << [loc, val, valScript](QGL33 * const gl) {
-        gl->glUniform1f(loc, static_cast<GLfloat>(val));
-    };
+    if(loc >= 0) {
+        uniSpec << [loc, val, valScript](QGL33 * const gl) {
+            gl->glUniform1f(loc, static_cast<GLfloat>(val));
+        };
+    }
+    if(cpuSlot >= 0) {
+        cpuUniSpec << [cpuSlot, val](ShaderInterpreter::Uniforms& uniforms) {
+            uniforms[cpuSlot] = {static_cast<float>(val), 0, 0, 0};
+        };
+    }
 }
 
 void intAnimatorCreate(
         const bool glValue,
         const GLint loc,
+        const int cpuSlot,
         Property * const property,
         const qreal relFrame,
         const qreal resolution,
         QJSValueList& setterArgs,
-        UniformSpecifiers& uniSpec) {
+        UniformSpecifiers& uniSpec,
+        CpuUniformSpecifiers& cpuUniSpec) {
     const auto anim = static_cast<IntAnimator*>(property);
     const int val = qRound(anim->getEffectiveIntValue(relFrame)*resolution);
     const QString valScript = anim->prp_getName() + " = " + QString::number(val);
     setterArgs << val;
 
     if(!glValue) return;
-    Q_ASSERT(loc >= 0);
-    uniSpec << [loc, val, valScript](QGL33 * const gl) {
-        gl->glUniform1i(loc, val);
-    };
+    if(loc >= 0) {
+        uniSpec << [loc, val, valScript](QGL33 * const gl) {
+            gl->glUniform1i(loc, val);
+        };
+    }
+    if(cpuSlot >= 0) {
+        cpuUniSpec << [cpuSlot, val](ShaderInterpreter::Uniforms& uniforms) {
+            uniforms[cpuSlot] = {static_cast<float>(val), 0, 0, 0};
+        };
+    }
 }
 
 QString vec2ValScript(const QString& name, const QPointF& value) {
@@ -68,43 +84,54 @@ void qPointFAnimatorCreate(
         ShaderEffectJS &engine,
         const bool glValue,
         const GLint loc,
+        const int cpuSlot,
         Property * const property,
         const qreal relFrame,
         const qreal resolution,
         QJSValueList& setterArgs,
-        UniformSpecifiers& uniSpec) {
+        UniformSpecifiers& uniSpec,
+        CpuUniformSpecifiers& cpuUniSpec) {
     const auto anim = static_cast<QPointFAnimator*>(property);
     const QPointF val = anim->getEffectiveValue(relFrame)*resolution;
     const QString valScript = vec2ValScript(anim->prp_getName(), val);
     setterArgs << engine.toValue(val);
 
     if(!glValue) return;
-    Q_ASSERT(loc >= 0);
-    uniSpec << [loc, val, valScript](QGL33 * const gl) {
-        gl->glUniform2f(loc, val.x(), val.y());
-    };
+    if(loc >= 0) {
+        uniSpec << [loc, val, valScript](QGL33 * const gl) {
+            gl->glUniform2f(loc, val.x(), val.y());
+        };
+    }
+    if(cpuSlot >= 0) {
+        cpuUniSpec << [cpuSlot, val](ShaderInterpreter::Uniforms& uniforms) {
+            uniforms[cpuSlot] = {static_cast<float>(val.x()),
+                                 static_cast<float>(val.y()), 0, 0};
+        };
+    }
 }
 
 void UniformSpecifierCreator::create(ShaderEffectJS &engine,
                                      const GLint loc,
+                                     const int cpuSlot,
                                      Property * const property,
                                      const qreal relFrame,
                                      const qreal resolution,
                                      QJSValueList& setterArgs,
-                                     UniformSpecifiers& uniSpec) const {
+                                     UniformSpecifiers& uniSpec,
+                                     CpuUniformSpecifiers& cpuUniSpec) const {
     switch(mType) {
     case ShaderPropertyType::floatProperty:
-        return qrealAnimatorCreate(fGLValue, loc, property, relFrame,
+        return qrealAnimatorCreate(fGLValue, loc, cpuSlot, property, relFrame,
                                    mResolutionScaled ? resolution : 1,
-                                   setterArgs, uniSpec);
+                                   setterArgs, uniSpec, cpuUniSpec);
     case ShaderPropertyType::intProperty:
-        return intAnimatorCreate(fGLValue, loc, property, relFrame,
+        return intAnimatorCreate(fGLValue, loc, cpuSlot, property, relFrame,
                                  mResolutionScaled ? resolution : 1,
-                                 setterArgs, uniSpec);
+                                 setterArgs, uniSpec, cpuUniSpec);
     case ShaderPropertyType::vec2Property:
-        return qPointFAnimatorCreate(engine, fGLValue, loc, property, relFrame,
-                                     mResolutionScaled ? resolution : 1,
-                                     setterArgs, uniSpec);
+        return qPointFAnimatorCreate(engine, fGLValue, loc, cpuSlot, property,
+                                     relFrame, mResolutionScaled ? resolution : 1,
+                                     setterArgs, uniSpec, cpuUniSpec);
     default: RuntimeThrow("Unsupported type");
     }
 }
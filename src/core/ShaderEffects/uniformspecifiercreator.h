@@ -23,6 +23,7 @@
 #include "PropertyCreators/intanimatorcreator.h"
 #include "PropertyCreators/qpointfanimatorcreator.h"
 #include "glhelpers.h"
+#include "shaderinterpreter.h"
 
 class ShaderEffectJS;
 
@@ -42,13 +43,17 @@ struct CORE_EXPORT UniformSpecifierCreator : public StdSelfRef {
                             const bool resolutionScaled) :
         mType(type), fGLValue(glValue), mResolutionScaled(resolutionScaled) {}
 
+    //! @brief loc is -1 when there is no GL program,
+    //! cpuSlot is -1 when there is no CPU implementation.
     void create(ShaderEffectJS &engine,
                 const GLint loc,
+                const int cpuSlot,
                 Property * const property,
                 const qreal relFrame,
                 const qreal resolution,
                 QJSValueList& setterArgs,
-                UniformSpecifiers& uniSpec) const;
+                UniformSpecifiers& uniSpec,
+                CpuUniformSpecifiers& cpuUniSpec) const;
 
     const ShaderPropertyType mType;
     const bool fGLValue;
@@ -37,6 +37,9 @@
 #include "Private/document.h"
 #include "Boxes/sculptpathbox.h"
 #include "svgexporter.h"
+#include "Private/esettings.h"
+#include "Private/Tasks/taskscheduler.h"
+#include "Expressions/expressiongraph.h"
 
 Canvas::Canvas(Document &document,
                const int canvasWidth, const int canvasHeight,
@@ -87,6 +90,11 @@ qreal Canvas::getResolution() const {
     return mResolution;
 }
 
+qreal Canvas::getRenderResolution() const {
+    if(mPreviewResolution > 0) return mPreviewResolution;
+    return mResolution;
+}
+
 void Canvas::setResolution(const qreal percent) {
     mResolution = percent;
     prp_afterWholeInfluenceRangeChanged();
@@ -108,10 +116,35 @@ void Canvas::queTasks() {
     if(Actions::sInstance->smoothChange() && mCurrentContainer) {
         if(!mDrawnSinceQue) return;
         mCurrentContainer->queChildrenTasks();
-    } else ContainerBox::queTasks();
+    } else {
+        queProgressivePreview();
+        ContainerBox::queTasks();
+    }
     mDrawnSinceQue = false;
 }
 
+void Canvas::queProgressivePreview() {
+    const int div = eSettings::instance().fPreviewResolutionDiv;
+    if(div <= 1 || isPreviewingOrRendering()) return;
+    if(!getUpdatePlanned() || !shouldScheduleUpdate()) return;
+    const int relFrame = anim_getCurrentRelFrame();
+    if(mRenderDataHandler.getItemAtRelFrame(relFrame)) return;
+    if(mPreviewRenderData && mPreviewRenderData->fBoxStateId == mStateId &&
+       isZero4Dec(mPreviewRenderData->fRelFrame - relFrame)) return;
+
+    const auto renderData = createRenderData(relFrame);
+    if(!renderData) return;
+    renderData->fPreview = true;
+    const auto scheduler = TaskScheduler::instance();
+    scheduler->beginPriorityQue();
+    mPreviewResolution = mResolution/div;
+    setupRenderData(relFrame, renderData.get(), this);
+    mPreviewResolution = 0;
+    mPreviewRenderData = renderData.get();
+    renderData->queTask();
+    scheduler->endPriorityQue();
+}
+
 void Canvas::addSelectedForGraph(const int widgetId, GraphAnimator * const anim) {
     const auto it = mSelectedForGraph.find(widgetId);
     if(it == mSelectedForGraph.end()) {
@@ -430,6 +463,7 @@ void Canvas::setSceneFrame(const int relFrame) {
 
 void Canvas::setSceneFrame(const stdsptr<SceneFrameContainer>& cont) {
     setLoadingSceneFrame(nullptr);
+    mSceneFrameIsPreview = false;
     mSceneFrame = cont;
     emit requestUpdate();
 }
@@ -449,7 +483,26 @@ FrameRange Canvas::prp_getIdenticalRelRange(const int relFrame) const {
     return groupRange;//*canvasRange;
 }
 
+void Canvas::previewFinished(BoxRenderData * const renderData) {
+    // superseded previews are discarded
+    if(renderData != mPreviewRenderData) return;
+    mPreviewRenderData.clear();
+    if(isPreviewingOrRendering()) return;
+    if(renderData->fBoxStateId != mStateId) return;
+    const int relFrame = qRound(renderData->fRelFrame);
+    if(relFrame != anim_getCurrentRelFrame()) return;
+    const bool fullFrameShown = mSceneFrame && !mSceneFrameIsPreview &&
+                                mSceneFrame->fBoxState == mStateId &&
+                                mSceneFrame->getRange().inRange(relFrame);
+    if(fullFrameShown) return;
+    const auto cont = enve::make_shared<SceneFrameContainer>(
+                this, renderData, FrameRange{relFrame, relFrame}, nullptr);
+    setSceneFrame(cont);
+    mSceneFrameIsPreview = true;
+}
+
 void Canvas::renderDataFinished(BoxRenderData *renderData) {
+    if(renderData->fPreview) return previewFinished(renderData);
     const bool currentState = renderData->fBoxStateId == mStateId;
     if(currentState) mRenderDataHandler.removeItemAtRelFrame(renderData->fRelFrame);
     else if(renderData->fBoxStateId < mLastStateId) return;
@@ -475,7 +528,9 @@ void Canvas::renderDataFinished(BoxRenderData *renderData) {
                                           qAbs(cRelFrame - cRange.fMax));
             closerFrame = finishedFrameDist < oldFrameDist;
         }
-        if(newerSate || closerFrame) {
+        const bool replacesPreview = mSceneFrameIsPreview && currentState &&
+                                     range.inRange(anim_getCurrentRelFrame());
+        if(newerSate || closerFrame || replacesPreview) {
             mSceneFrameOutdated = !currentState;
             setSceneFrame(cont);
         }
@@ -697,7 +752,11 @@ void Canvas::invertSelectionAction() {
 
 void Canvas::anim_setAbsFrame(const int frame) {
     if(frame == anim_getCurrentAbsFrame()) return;
-    ContainerBox::anim_setAbsFrame(frame);
+    {
+        // evaluate expressions once all properties reached the frame
+        const ExpressionGraph::Batch exprBatch;
+        ContainerBox::anim_setAbsFrame(frame);
+    }
     const int newRelFrame = anim_getCurrentRelFrame();
 
     const auto cont = mSceneFramesHandler.atFrame<SceneFrameContainer>(newRelFrame);
@@ -932,10 +991,12 @@ bool Canvas::newUndoRedoSet() {
 }
 
 void Canvas::undo() {
+    mPaintTarget.finishStroke();
     mUndoRedoStack->undo();
 }
 
 void Canvas::redo() {
+    mPaintTarget.finishStroke();
     mUndoRedoStack->redo();
 }
 
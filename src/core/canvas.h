@@ -252,6 +252,11 @@ public:
     qreal getResolution() const;
     void setResolution(const qreal percent);
 
+    //! @brief Resolution used for setting up render data,
+    //! lower than getResolution() while queing a progressive preview.
+    qreal getRenderResolution() const;
+    bool isSettingUpPreview() const { return mPreviewResolution > 0; }
+
     void applyCurrentTransformToSelected();
     QPointF getSelectedPointsAbsPivotPos();
     bool isPointSelectionEmpty() const;
@@ -667,6 +672,9 @@ private:
     void drawPathClear();
     void drawPathFinish(const qreal invScale);
 
+    void queProgressivePreview();
+    void previewFinished(BoxRenderData * const renderData);
+
     qreal mLastDRot = 0;
     int mRotHalfCycles = 0;
     TransformMode mTransMode = TransformMode::none;
@@ -731,6 +739,9 @@ protected:
     bool mRenderingOutput = false;
 
     bool mSceneFrameOutdated = false;
+    bool mSceneFrameIsPreview = false;
+    qreal mPreviewResolution = 0;
+    stdptr<BoxRenderData> mPreviewRenderData;
     UseSharedPointer<SceneFrameContainer> mSceneFrame;
     UseSharedPointer<SceneFrameContainer> mLoadingSceneFrame;
 
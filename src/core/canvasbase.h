@@ -79,6 +79,16 @@ public:
         }
     }
 
+    template <class T = Property>
+    void execOpOnSelectedProperties(const std::function<void(const QList<T*>&)> &op) {
+        QList<T*> all;
+        for(const auto prop : mSelectedProps) {
+            const auto t = enve_cast<T*>(prop);
+            if(t) all << t;
+        }
+        op(all);
+    }
+
     template <class T = Property>
     void execOpOnSelectedProperties(const std::function<void(T*)> &op) {
         for(const auto prop : mSelectedProps) {
@@ -21,6 +21,7 @@
 #include "PathEffects/patheffectcollection.h"
 #include "Animators/SmartPath/smartpathcollection.h"
 #include "Properties/boxtargetproperty.h"
+#include "Expressions/expressiongraph.h"
 
 Clipboard::Clipboard(const ClipboardType type) : mType(type) {}
 
@@ -42,7 +43,11 @@ void Clipboard::read(const Clipboard::Reader &reader) {
     buffer.seek(buffer.size() - qint64(sizeof(int)));
     readStream.readFutureTable();
     buffer.seek(0);
-    reader(readStream);
+    {
+        // pasted expressions are evaluated once all of them are read
+        const ExpressionGraph::Batch exprBatch;
+        reader(readStream);
+    }
     buffer.close();
 }
 
@@ -46,6 +46,8 @@ include(core.pri)
 
 SOURCES += \
     Expressions/expression.cpp \
+    Expressions/expressiongraph.cpp \
+    Expressions/nativeexpression.cpp \
     Expressions/framebinding.cpp \
     Expressions/propertybinding.cpp \
     Animators/SculptPath/sculptbrush.cpp \
@@ -56,6 +58,7 @@ SOURCES += \
     Animators/SculptPath/sculptpathcollection.cpp \
     Animators/SmartPath/listofnodes.cpp \
     Animators/SmartPath/smartpath.cpp \
+    Animators/SmartPath/smartpathinterpolator.cpp \
     Animators/SmartPath/smartpathanimatoractions.cpp \
     Animators/brushsettingsanimator.cpp \
     Animators/clampedpoint.cpp \
@@ -73,6 +76,8 @@ SOURCES += \
     Animators/paintsettingsanimator.cpp \
     Animators/qcubicsegment1danimator.cpp \
     Animators/qrealsnapshot.cpp \
+    Animators/qrealcurve.cpp \
+    Animators/keyscompactor.cpp \
     Animators/qstringanimator.cpp \
     Animators/sceneboundgradient.cpp \
     Animators/staticcomplexanimator.cpp \
@@ -108,6 +113,7 @@ SOURCES += \
     Boxes/patheffectsmenu.cpp \
     Boxes/rectangle.cpp \
     Boxes/renderdatahandler.cpp \
+    Boxes/motionblursamplecache.cpp \
     Boxes/sculptpathbox.cpp \
     Boxes/sculptpathboxrenderdata.cpp \
     Boxes/smartvectorpath.cpp \
@@ -173,6 +179,7 @@ SOURCES += \
     Paint/painttarget.cpp \
     Paint/simplebrushwrapper.cpp \
     Paint/tile.cpp \
+    Paint/tilepool.cpp \
     Paint/tilebitmaps.cpp \
     Paint/undoabletile.cpp \
     PathEffects/custompatheffect.cpp \
@@ -205,6 +212,7 @@ SOURCES += \
     Properties/boxtargetproperty.cpp \
     Properties/emimedata.cpp \
     RasterEffects/blureffect.cpp \
+    RasterEffects/cpublur.cpp \
     RasterEffects/customrastereffect.cpp \
     RasterEffects/motionblureffect.cpp \
     RasterEffects/rastereffect.cpp \
@@ -220,9 +228,11 @@ SOURCES += \
     Segments/smoothcurves.cpp \
     ShaderEffects/shadereffect.cpp \
     ShaderEffects/shadereffectcaller.cpp \
+    ShaderEffects/shadereffectcpucheck.cpp \
     ShaderEffects/shadereffectcreator.cpp \
     ShaderEffects/shadereffectjs.cpp \
     ShaderEffects/shadereffectprogram.cpp \
+    ShaderEffects/shaderinterpreter.cpp \
     ShaderEffects/shadervaluehandler.cpp \
     ShaderEffects/uniformspecifiercreator.cpp \
     Sound/eindependentsound.cpp \
@@ -266,6 +276,7 @@ SOURCES += \
     filesourcescache.cpp \
     gpurendertools.cpp \
     importhandler.cpp \
+    jsenginepool.cpp \
     kraimporter.cpp \
     matrixdecomposition.cpp \
     memorydatahandler.cpp \
@@ -353,6 +364,8 @@ SOURCES += \
 
 HEADERS += \
     Expressions/expression.h \
+    Expressions/expressiongraph.h \
+    Expressions/nativeexpression.h \
     Expressions/framebinding.h \
     Expressions/propertybinding.h \
     Animators/SculptPath/sculptbrush.h \
@@ -363,6 +376,7 @@ HEADERS += \
     Animators/SculptPath/sculptpathcollection.h \
     Animators/SmartPath/listofnodes.h \
     Animators/SmartPath/smartpath.h \
+    Animators/SmartPath/smartpathinterpolator.h \
     Animators/brushsettingsanimator.h \
     Animators/clampedpoint.h \
     Animators/clampedvalue.h \
@@ -381,6 +395,8 @@ HEADERS += \
     Animators/paintsettingsanimator.h \
     Animators/qcubicsegment1danimator.h \
     Animators/qrealsnapshot.h \
+    Animators/qrealcurve.h \
+    Animators/keyscompactor.h \
     Animators/qstringanimator.h \
     Animators/sceneboundgradient.h \
     Animators/staticcomplexanimator.h \
@@ -419,6 +435,7 @@ HEADERS += \
     Boxes/patheffectsmenu.h \
     Boxes/rectangle.h \
     Boxes/renderdatahandler.h \
+    Boxes/motionblursamplecache.h \
     Boxes/sculptpathbox.h \
     Boxes/sculptpathboxrenderdata.h \
     Boxes/smartvectorpath.h \
@@ -486,6 +503,7 @@ HEADERS += \
     Paint/painttarget.h \
     Paint/simplebrushwrapper.h \
     Paint/tile.h \
+    Paint/tilepool.h \
     Paint/tilebitmaps.h \
     Paint/undoabletile.h \
     PathEffects/custompatheffect.h \
@@ -521,6 +539,7 @@ HEADERS += \
     Properties/emimedata.h \
     Properties/namedproperty.h \
     RasterEffects/blureffect.h \
+    RasterEffects/cpublur.h \
     RasterEffects/customrastereffect.h \
     RasterEffects/motionblureffect.h \
     RasterEffects/rastereffect.h \
@@ -546,9 +565,11 @@ HEADERS += \
     ShaderEffects/PropertyCreators/shaderpropertycreator.h \
     ShaderEffects/shadereffect.h \
     ShaderEffects/shadereffectcaller.h \
+    ShaderEffects/shadereffectcpucheck.h \
     ShaderEffects/shadereffectcreator.h \
     ShaderEffects/shadereffectjs.h \
     ShaderEffects/shadereffectprogram.h \
+    ShaderEffects/shaderinterpreter.h \
     ShaderEffects/shadervaluehandler.h \
     ShaderEffects/uniformspecifiercreator.h \
     Sound/eindependentsound.h \
@@ -593,6 +614,7 @@ HEADERS += \
     gpurendertools.h \
     hardwareenums.h \
     importhandler.h \
+    jsenginepool.h \
     kraimporter.h \
     libmypaintincludes.h \
     matrixdecomposition.h \
@@ -65,6 +65,9 @@ struct CORE_EXPORT CpuRenderData {
     //! @brief Texture size
     uint fWidth;
     uint fHeight;
+
+    //! @brief Index of the current cpu pass
+    int fPass;
 };
 
 #endif // GLHELPERS_H
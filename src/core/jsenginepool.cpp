@@ -0,0 +1,88 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "jsenginepool.h"
+
+#include <QThreadStorage>
+
+#include <algorithm>
+
+std::mutex JSEnginePool::sThreadsMutex;
+std::vector<JSEnginePool::ThreadEngine*> JSEnginePool::sThreadEngines;
+
+JSEnginePool::ThreadEngine::ThreadEngine() {
+    std::lock_guard<std::mutex> lock(sThreadsMutex);
+    sThreadEngines.push_back(this);
+}
+
+JSEnginePool::ThreadEngine::~ThreadEngine() {
+    std::lock_guard<std::mutex> lock(sThreadsMutex);
+    const auto it = std::find(sThreadEngines.begin(),
+                              sThreadEngines.end(), this);
+    if(it != sThreadEngines.end()) sThreadEngines.erase(it);
+}
+
+void JSEnginePool::ThreadEngine::removeReleased() {
+    if(!fHasReleased) return;
+    std::vector<quint64> released;
+    {
+        std::lock_guard<std::mutex> lock(sThreadsMutex);
+        released.swap(fReleased);
+        fHasReleased = false;
+    }
+    // values are destroyed in the thread owning the engine
+    for(const auto id : released) fInstances.erase(id);
+}
+
+JSEnginePool::ThreadEngine& JSEnginePool::sThreadEngine() {
+    static QThreadStorage<ThreadEngine*> sEngines;
+    if(!sEngines.hasLocalData()) sEngines.setLocalData(new ThreadEngine);
+    const auto engine = sEngines.localData();
+    engine->removeReleased();
+    return *engine;
+}
+
+QJSEngine& JSEnginePool::sEngine() {
+    return sThreadEngine().fEngine;
+}
+
+QJSValue JSEnginePool::sCompiled(const QString& source) {
+    auto& engine = sThreadEngine();
+    if(const auto compiled = engine.fCompiled.object(source)) return *compiled;
+    const auto result = engine.fEngine.evaluate(source);
+    if(!result.isError()) engine.fCompiled.insert(source, new QJSValue(result));
+    return result;
+}
+
+QJSValue JSEnginePool::sInstance(const quint64 id, const QString& factorySource) {
+    auto& engine = sThreadEngine();
+    const auto it = engine.fInstances.find(id);
+    if(it != engine.fInstances.end()) return it->second;
+    const auto factory = sCompiled(factorySource);
+    if(factory.isError()) return factory;
+    const auto result = factory.call();
+    if(!result.isError()) engine.fInstances.insert({id, result});
+    return result;
+}
+
+void JSEnginePool::sReleaseInstance(const quint64 id) {
+    std::lock_guard<std::mutex> lock(sThreadsMutex);
+    for(const auto engine : sThreadEngines) {
+        engine->fReleased.push_back(id);
+        engine->fHasReleased = true;
+    }
+}
@@ -0,0 +1,74 @@
+// enve - 2D animations software
+// Copyright (C) 2016-2020 Maurycy Liebner
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef JSENGINEPOOL_H
+#define JSENGINEPOOL_H
+
+#include "core_global.h"
+
+#include <QJSEngine>
+#include <QCache>
+
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+
+//! @brief Provides one lazily created QJSEngine per thread for expressions.
+//! Scripts are compiled once per thread and shared between all users
+//! with the same source, the compiled cache is bounded and least recently
+//! used entries are dropped. Instances are kept until they are released.
+//! Values obtained from the pool should not be stored,
+//! they are only valid in the calling thread.
+class CORE_EXPORT JSEnginePool {
+public:
+    //! @brief Engine of the calling thread, created on first use
+    static QJSEngine& sEngine();
+
+    //! @brief Result of evaluating source in the calling thread's engine.
+    //! Evaluated once per thread, errors are returned but not cached.
+    //! The result is shared, it should not hold any state.
+    static QJSValue sCompiled(const QString& source);
+
+    //! @brief Result of calling the compiled factorySource function,
+    //! called once per thread for every id. Instances with different ids
+    //! do not share state, even if their factorySource is identical.
+    static QJSValue sInstance(const quint64 id, const QString& factorySource);
+    //! @brief Drops the instances of id in all threads, can be called from
+    //! any thread, other threads drop them the next time they use the pool
+    static void sReleaseInstance(const quint64 id);
+private:
+    struct ThreadEngine {
+        ThreadEngine();
+        ~ThreadEngine();
+
+        void removeReleased();
+
+        QJSEngine fEngine;
+        QCache<QString, QJSValue> fCompiled{256};
+        std::unordered_map<quint64, QJSValue> fInstances;
+        //! @brief Ids released by other threads, guarded by sThreadsMutex
+        std::vector<quint64> fReleased;
+        std::atomic<bool> fHasReleased{false};
+    };
+
+    static ThreadEngine& sThreadEngine();
+
+    static std::mutex sThreadsMutex;
+    static std::vector<ThreadEngine*> sThreadEngines;
+};
+
+#endif // JSENGINEPOOL_H